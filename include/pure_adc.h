@@ -1,15 +1,98 @@
 #ifndef PURE_ADC_H
 #define PURE_ADC_H
 
+#include <Arduino.h>
+
+#include <pure_metrics.h>
+#include <pure_ramfunc.h>
+
 namespace PurpleReign
 {
 
+	// Sample rate class of an analog input. The mux addresses are visited in frames of Adc::framePhases slots per address at most; the class sets how many of them sample the input.
+	enum analogRateClass_t
+	{
+		ANALOG_RATE_FAST,	// Every phase of the frame (e.g. performance faders)
+		ANALOG_RATE_NORMAL, // Every 2nd phase
+		ANALOG_RATE_SLOW	// Once per frame (e.g. set-and-forget pots)
+	};
+
+	// External 16:1 analog multiplexers (e.g. 4067), sharing the select lines, with their common outputs on separate ADC channels
+	struct analogMux_t
+	{
+		uint8_t numMuxes;	   // 1..Adc::maxMuxes
+		uint8_t adcChannel[4]; // ADC channel of the output of each mux. Must be above all other enabled ADC channels, since the sequence converts channels in numeric order.
+		uint8_t selectPin[4];  // Arduino pins of the select lines S0..S3. Must not be on the keybed row or column ports (PIOD, PIOC).
+	};
+
+	// An analog input (fader or pot) on a mux, reported as a CC
+	struct analogInput_t
+	{
+		uint8_t input;	   // mux * 16 + mux address
+		uint8_t ccNum;	   // CC number, or Adc::noCc for an input that is only sampled (read with Adc::value()), e.g. a key position sensor
+		uint8_t channel;   // 0..15
+		uint8_t rateClass; // analogRateClass_t
+	};
+
+	// Analog inputs behind external multiplexers, sampled in the background by timer triggered ADC conversions.
+	//
+	// A timer (TC0 channel 2, TIOA2) triggers one conversion sequence per slot, converting all enabled ADC channels. Each slot samples one mux address,
+	// i.e. one input of every mux. The end of conversion interrupt reads the mux channels and at once switches the select lines to the address of the next slot,
+	// so each address settles during the rest of the slot period while the CPU does other work, instead of being waited for before its conversion.
+	// The interrupt costs about a microsecond per slot, so 64 inputs sampled at several hundred Hz take no measurable share of the keybed scan budget.
+	//
+	// Addresses are visited according to the fastest rate class of their inputs. process() reports inputs changed by more than the threshold since their latest report,
+	// only looking at inputs sampled since the previous call. The other enabled ADC channels (not on muxes) are converted in every slot too, and can be read
+	// as before with adc_get_channel_value().
 	class Adc
 	{
 	public:
-		int init();
+		static const int maxMuxes = 4;
+		static const int muxSelectLines = 4;
+		static const int muxAddresses = 16;
+		static const int maxInputs = maxMuxes * muxAddresses;
+		static const int framePhases = 8;
+		static const int maxSlots = framePhases * muxAddresses;
+		static const uint8_t noCc = 0xFF;
+		static const uint32_t timerClockHz = VARIANT_MCK / 2; // TIMER_CLOCK1
+
+	private:
+		analogMux_t m_mux;
+		Pio *m_selectPort[muxSelectLines];
+		uint32_t m_selectMask[muxSelectLines];
+
+		uint8_t m_slotAddress[maxSlots]; // Mux address per slot of a frame
+		int m_numSlots;
+		int m_slot; // Slot being converted. Interrupt only, after init().
+
+		analogInput_t m_input[maxInputs];
+		int m_numInputs;
+		int8_t m_inputIx[maxInputs]; // Index into m_input[] per mux input, -1 if not used
+		uint16_t m_reported[maxInputs]; // Latest reported value, per m_input[]
+		uint64_t m_reportedValidBM;		// Bit Matrix with one bit per m_input[], set once the input has been sampled (the first sample is not reported, like the direct ADC channels at boot)
+		uint16_t m_threshold;
+
+		volatile uint16_t m_value[maxInputs];	  // Latest sample per mux input. Written by the interrupt only.
+		volatile uint32_t m_updatedBM[maxInputs / 32]; // Bit Matrix with one bit per mux input, set by the interrupt when sampled, cleared by process()
+		volatile uint32_t m_slotsConverted;
+
+		void (*m_changeFunction)(uint8_t ccNum, uint16_t adcVal, uint8_t channel);
+
+		inline void selectAddress(int address);
+
+	public:
+		Adc();
+
+		// Configures the select lines, the slot schedule, the trigger timer and the end of conversion interrupt, and starts sampling.
+		// The ADC itself (clock, timing, the other channels) must already be configured. Returns the number of slots per frame, or -1 if the configuration is invalid.
+		int init(const analogMux_t &mux, const analogInput_t *inputs, int numInputs, unsigned long slotMicros, uint16_t threshold);
+		void setChangeFunction(void (*function)(uint8_t ccNum, uint16_t adcVal, uint8_t channel));
+		PURE_HOT_FUNC void conversionInterrupt(); // Call from ADC_Handler()
+		void process();							  // Reports changed inputs. Call from every loop() iteration; returns at once when nothing was sampled.
+		uint16_t value(int input) { return m_value[input]; }
+		uint32_t slotsConverted() { return m_slotsConverted; }
 	};
 
 }
 
-#endif /* PURE_ADC_H */
\ No newline at end of file
+#endif /* PURE_ADC_H */
@@ -0,0 +1,90 @@
+#ifndef PURE_ANALOGKEYBED_H
+#define PURE_ANALOGKEYBED_H
+
+#include <stdint.h>
+
+#include <pure_ramfunc.h>
+#include <pure_timebase.h>
+#include <pure_velocitycurve.h>
+
+namespace PurpleReign
+{
+
+	const int analogKeyPositionMax = 1024; // Normalized position of a key at its calibrated bottom. 0 = rest. Keys pressed into the felt read above it.
+
+	// Velocity sensing keybed backend for keys with continuous position sensors (e.g. hall-effect sensors), an alternative to the MK/BK switch matrix of VelocityKeybed.
+	//
+	// scan() samples the position of every key once, through the position function (e.g. reading PurpleReign::Adc mux inputs), and is meant to be called at a fixed rate,
+	// which is then the per key sample rate. Raw sensor values are normalized per key by its calibration (rest and bottom values, in either direction).
+	//
+	// A note on is triggered when a key passes the trigger point downwards, and a note off when it passes the (lower) release point upwards. The velocity is taken from the
+	// position derivative at the crossing, over the last derivativeSamples sample intervals: the key speed is converted to the time it would take to travel the velocity
+	// travel distance, i.e. to the stopwatch value of the switch based keybed, so the same VelocityCurve applies. The release velocity is computed the same way.
+	// While a key is down, its position beyond the aftertouch start point is reported as (polyphonic) pressure.
+	//
+	// The class does not touch any hardware, so it runs on a host as well (with PURE_VIRTUAL_CLOCK and e.g. a KeyMotionModel as the position source).
+	class AnalogKeybed
+	{
+	public:
+		static const int maxKeys = 128;
+		static const int derivativeSamples = 4; // Must be a power of 2
+		static const int RELEASED = 0, PRESSED = 1;
+		static const int aftertouchHysteresis = 2; // Min change of the pressure value to be reported (except changes to 0 and 127)
+		static const int aftertouchSmoothingShift = 2; // The position used for pressure is smoothed by a first order low pass filter, with a time constant of 2^shift scans
+
+	private:
+		int m_numKeys;
+		uint16_t (*m_positionFunction)(int key);
+
+		int16_t m_rest[maxKeys]; // Raw value at rest, per key
+		int16_t m_span[maxKeys]; // Raw value at the bottom minus the raw value at rest, per key
+
+		int16_t m_position[derivativeSamples][maxKeys]; // Normalized position of the last derivativeSamples scans, per key
+		uint32_t m_scanTime[derivativeSamples];		  // Time stamp (Timebase::now32()) of the last derivativeSamples scans
+		int m_scanIx;								  // Index of the latest scan in m_position[] and m_scanTime[]
+
+		uint8_t m_keyState[maxKeys];
+		uint8_t m_pressure[maxKeys];				 // Latest reported pressure, per key
+		int32_t m_smoothedPosition[maxKeys]; // Low pass filtered position (scaled by 2^aftertouchSmoothingShift) for pressure, per key while pressed
+
+		int m_triggerPosition;
+		int m_releasePosition;
+		int m_velocityTravel;
+		int m_aftertouchStart;
+		int m_aftertouchFull;
+
+		uint32_t m_eventTime;
+		uint32_t m_eventStopwatch;
+		uint8_t m_releaseVelocity;
+
+		const VelocityCurve *m_velocityCurve;
+		void (*m_noteOnFunction)(int keyAddress, uint8_t velocity);
+		void (*m_noteOffFunction)(int keyAddress);
+		void (*m_aftertouchFunction)(int keyAddress, uint8_t pressure);
+
+		inline int normalize(int key, int raw);
+		uint8_t crossingVelocity(int key, int crossingPosition, int travel, uint32_t now);
+
+	public:
+		AnalogKeybed();
+
+		// Takes the current position of each key as its rest value, with the bottom defaultSpan raw units away (negative if the value falls when pressed). Call once before the first scan().
+		void init(int numKeys, uint16_t (*positionFunction)(int key), int defaultSpan);
+		void setCalibration(int key, uint16_t rest, uint16_t bottom);
+		void setVelocityCurve(const VelocityCurve *velocityCurve);
+		void setNoteOnFunction(void (*function)(int keyAddress, uint8_t velocity));
+		void setNoteOffFunction(void (*function)(int keyAddress));
+		void setAftertouchFunction(void (*function)(int keyAddress, uint8_t pressure));
+		bool setTriggerPoints(int triggerPosition, int releasePosition); // Normalized positions, release below trigger. Returns false (and changes nothing) if invalid.
+		void setVelocityTravel(int travel);								 // Normalized distance of the switch based velocity measurement that the key speed is mapped to
+		bool setAftertouchRange(int startPosition, int fullPosition);	 // Normalized positions of pressure 0 and 127. Returns false (and changes nothing) if invalid.
+		PURE_HOT_FUNC void scan();										 // Samples all keys once. Call at the fixed per key sample rate.
+		int position(int key) { return m_position[m_scanIx][key]; }		 // Latest normalized position
+		uint32_t eventTime() { return m_eventTime; }					 // Interpolated time of the trigger or release point crossing. Only valid within the note on/off callback.
+		uint8_t releaseVelocity() { return m_releaseVelocity; }		 // Only valid within the note off callback
+		uint32_t eventStopwatch() { return m_eventStopwatch; }		 // Fixed point stopwatch value of the crossing, for VelocityCurve::velocity16(). Only valid within the note on/off callback.
+	};
+
+}
+
+#endif /* PURE_ANALOGKEYBED_H */
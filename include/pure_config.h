@@ -0,0 +1,75 @@
+#ifndef PURE_CONFIG_H
+#define PURE_CONFIG_H
+
+#include <Arduino.h>
+
+#include <pure_zonerouter.h>
+
+namespace PurpleReign
+{
+
+	// Persistent configuration block
+	//
+	// Holds everything that is calibrated or set by the user (see MidiCtrl for the SysEx commands), so a unit boots straight into its tuned state.
+	// Controller maps are stored as their border lists (the calibration); the slopes and offsets are derived in microseconds at boot.
+	//
+	// The layout is versioned: Bump configVersion whenever config_t changes. A stored block with another version, size or a bad checksum is ignored (defaults are used instead).
+	static const uint32_t configMagic = 0x45525550; // "PURE"
+	static const uint16_t configVersion = 3;
+
+	static const int configNumCtrlMaps = 16;		// Number of ADC to controller maps
+	static const int configMaxNumCtrlMapBorders = 11; // Max number of borders (ranges + 1) per ADC to controller map
+	static const int configNumCcs = 128;				// CC 0..127, a controller map per CC
+
+	struct configCtrlMapBorder_t
+	{
+		uint16_t adcValue;
+		uint16_t ctrlValue;
+	};
+
+	struct configCtrlMap_t
+	{
+		uint8_t numBorders; // 0 = map not set
+		uint8_t reserved;
+		configCtrlMapBorder_t border[configMaxNumCtrlMapBorders];
+	};
+
+	struct config_t
+	{
+		uint32_t magic;
+		uint16_t version;
+		uint16_t size; // sizeof(config_t)
+
+		uint8_t velocityCurveType; // velocityCurveType_t
+		uint8_t enable14BitCc;	   // 0 = 7 bit CC, 1 = 14 bit CC
+		uint8_t reserved[2];
+		uint32_t switchMuteMicros[2];			 // Switch mute time, per switch type (MK/BK)
+		uint8_t ctrlMapIxPerCc[configNumCcs]; // ADC to controller map used per CC
+		configCtrlMap_t ctrlMap[configNumCtrlMaps];
+		uint8_t numZones; // Keyboard zones (splits, layers, transposition), see ZoneRouter
+		uint8_t reserved2[3];
+		zone_t zone[ZoneRouter::maxZones];
+
+		uint32_t checksum; // CRC-32 of all preceding bytes. Must be the last member.
+	};
+
+	// Stores the configuration block in the last pages of the Due's internal flash (bank 1, EFC1).
+	//
+	// The stored block is read directly from the memory mapped flash. Writing erases and programs a few flash pages (some ms each), during which
+	// nothing else runs, so save() is only meant to be called on explicit user request. The block survives power cycles, but not a firmware upload with
+	// flash erase (the default for the Due bootloader), since the upload erases the whole flash.
+	class ConfigStore
+	{
+	public:
+		static const uint32_t numPages = (sizeof(config_t) + IFLASH1_PAGE_SIZE - 1) / IFLASH1_PAGE_SIZE;
+		static const uint32_t address = IFLASH1_ADDR + IFLASH1_SIZE - (numPages * IFLASH1_PAGE_SIZE); // At the very end of the flash
+
+		static uint32_t checksum(const config_t &config);
+		static bool isValid(const config_t &config);
+		static bool load(config_t &config);		  // Returns false (and leaves config untouched) if there is no valid stored block
+		static bool save(const config_t &config); // Sets the magic, version, size and checksum of the stored copy. Returns false if the flash controller reports an error.
+	};
+
+}
+
+#endif /* PURE_CONFIG_H */
@@ -0,0 +1,102 @@
+#ifndef PURE_CTRLGOVERNOR_H
+#define PURE_CTRLGOVERNOR_H
+
+#include <Arduino.h>
+
+#include <pure_metrics.h>
+#include <pure_midievent.h>
+#include <pure_midiqueue.h>
+#include <pure_timebase.h>
+
+namespace PurpleReign
+{
+
+	// Statistics of the controller class, see CtrlGovernor::stats()
+	struct ctrlGovernorStats_t
+	{
+		uint32_t passed;			// Controller events forwarded at once
+		uint32_t throttled;			// Controller events held back since the controller or the class had used up its rate budget
+		uint32_t headroomThrottled; // Controller events held back since the MidiQueue was at the controller limit (see init())
+		uint32_t coalesced;			// Held back events replaced by a newer value of the same controller, i.e. never sent
+		uint32_t released;			// Held back events sent later, by process()
+		uint32_t untracked;			// Controller events forwarded without rate limiting, since all controller slots were busy
+	};
+
+	// Rate governor between the controller producers (faders, pots, wheels, encoders, aftertouch) and the MidiQueue.
+	//
+	// Every controller (controller change, pitch bend, channel and poly pressure, per channel and number) has a token bucket, and so has the controller
+	// class as a whole: an event is forwarded when both have a token left, and otherwise held back in the slot of its controller. A newer value of a
+	// held back controller replaces the older one (the intermediate values are of no use once they are late), and process() sends it as soon as the
+	// buckets have refilled. So the final resting value of a controller is always sent, at most one token period after the control stopped moving.
+	//
+	// Notes keep guaranteed headroom: controller events are also held back while the MidiQueue holds controllerLimit or more events (not yet taken by
+	// all of its outputs, see MidiQueue::fill()), so the last noteHeadroom places of the queue are only ever taken by notes (and merged or realtime
+	// traffic, which has limits of its own). noteHeadroom is at least MidiQueue::noteReserve, so a controller value let through is never shed by the queue.
+	//
+	// Buckets hold credit in CPU cycles: a token costs (1 s / rate) and a bucket holds up to burst tokens, so the refill is a subtraction, not a division.
+	// Controllers take a slot on first use. When all slots are taken, the slot of an idle controller (nothing held back, bucket full) is reused.
+	class CtrlGovernor
+	{
+	public:
+		static const int maxControllers = 64;
+		static const uint32_t minRate = 10;	 // Messages per second. 0 = unlimited.
+		static const uint8_t maxBurst = 16; // Tokens
+
+	private:
+		struct bucket_t
+		{
+			uint32_t cost;	   // Cycles per token, 0 = unlimited
+			uint32_t capacity; // Cycles
+			uint32_t credit;   // Cycles
+			cycles_t lastRefill;
+		};
+
+		struct slot_t
+		{
+			uint32_t key;	   // type, channel and index of the controller, 0 = free
+			bool configured;   // Rate set by setControllerRate(), the slot is never reused
+			bool pending;	   // event is held back
+			midiEvent_t event; // The latest held back value
+			uint32_t throttled;
+			bucket_t bucket;
+		};
+
+		MidiQueue *m_queue;
+		int m_controllerLimit;
+		slot_t m_slot[maxControllers];
+		int m_numSlots;
+		int m_numPending;
+		int m_nextPending; // First slot to look at in the next process() call
+		bucket_t m_classBucket;
+		uint32_t m_defaultRate;
+		uint8_t m_defaultBurst;
+		ctrlGovernorStats_t m_stats;
+
+		static inline uint32_t makeKey(uint8_t type, uint8_t channel, uint8_t index) { return ((uint32_t)(type + 1) << 16) | ((uint32_t)channel << 8) | index; }
+		static bool isGoverned(const midiEvent_t &event);
+		static void initBucket(bucket_t &bucket, uint32_t rate, uint8_t burst);
+		static void refill(bucket_t &bucket, cycles_t now);
+		slot_t *findSlot(uint32_t key, bool allocate);
+		int admit(slot_t &slot, cycles_t now); // 0 = admitted (tokens taken), 1 = rate limited, 2 = no headroom
+		inline void emit(const midiEvent_t &event)
+		{
+			Metrics::increment(METRIC_CTRL_EMITTED);
+			m_queue->push(event);
+		}
+
+	public:
+		CtrlGovernor();
+		void init(MidiQueue *queue, int noteHeadroom); // noteHeadroom: queue places (events) reserved for notes, at least MidiQueue::noteReserve
+		void setClassRate(uint32_t rate, uint8_t burst);	   // Budget of all controllers together, in messages per second
+		void setDefaultRate(uint32_t rate, uint8_t burst);  // Budget per controller, for the controllers without a rate of their own. Applies to slots taken from then on.
+		bool setControllerRate(uint8_t type, uint8_t channel, uint8_t index, uint32_t rate, uint8_t burst); // Budget of one controller (type: midiEventType_t). Returns false if all slots are taken.
+		void push(const midiEvent_t &event); // Forwards, or holds back, a controller event. Any other event is forwarded as is.
+		void process();						 // Sends held back values when the budgets allow. Returns at once when nothing is held back. Call from every loop() iteration.
+		uint32_t controllerThrottled(uint8_t type, uint8_t channel, uint8_t index); // Number of events held back for one controller
+		const ctrlGovernorStats_t &stats() { return m_stats; }
+		void resetStats();
+	};
+
+}
+
+#endif /* PURE_CTRLGOVERNOR_H */
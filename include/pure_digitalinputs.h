@@ -0,0 +1,80 @@
+#ifndef PURE_DIGITALINPUTS_H
+#define PURE_DIGITALINPUTS_H
+
+#include <Arduino.h>
+
+#include <pure_midiqueue.h>
+#include <pure_timebase.h>
+
+namespace PurpleReign
+{
+
+	enum digitalInputAction_t
+	{
+		INPUT_ACTION_CC,		   // Switch CC (e.g. 64 sustain, 66 sostenuto, 67 soft): 127 when active, 0 when inactive
+		INPUT_ACTION_PROGRAM,	   // Program change to a fixed program, when activated
+		INPUT_ACTION_PROGRAM_UP,   // Program change to the next program, when activated
+		INPUT_ACTION_PROGRAM_DOWN // Program change to the previous program, when activated
+	};
+
+	// A digital input (pedal or button), connected between an Arduino pin and ground
+	struct digitalInput_t
+	{
+		uint8_t pin;	   // Arduino pin number. Must not be on the keybed row or column ports (PIOD, PIOC).
+		uint8_t action;	   // digitalInputAction_t
+		uint8_t number;	   // CC number (INPUT_ACTION_CC) or program number (INPUT_ACTION_PROGRAM)
+		uint8_t channel;   // 0..15
+		uint8_t activeLow; // 1 if the input is active when the pin is LOW (normally open switch to ground), 0 for normally closed switches (e.g. many sustain pedals)
+	};
+
+	// Digital inputs using PIO change interrupts, instead of being polled.
+	//
+	// The PIO debounce filters reject switch bounces in hardware, so each (filtered) edge interrupts once. The interrupt only time stamps the edge and
+	// pushes it to a queue. process() maps the queued edges to MIDI messages in the foreground; it is a single compare while the inputs are idle.
+	//
+	// The interrupt handlers are trampolines to the single instance (see init()), since attachInterrupt() passes no argument to the handler.
+	class DigitalInputs
+	{
+	public:
+		static const int maxInputs = 8;
+		static const int eventQueueSize = 16; // Must be a power of 2 (and below 256)
+
+	private:
+		struct edgeEvent_t
+		{
+			uint32_t time; // Time stamp (Timebase::now32()) of the edge
+			uint8_t input;
+			uint8_t level; // Pin level after the edge
+		};
+
+		digitalInput_t m_input[maxInputs];
+		int m_numInputs;
+		uint8_t m_active[maxInputs]; // Latest reported state per input, to drop edges that do not change it (e.g. when events were lost)
+		uint8_t m_program;			 // Current program, for INPUT_ACTION_PROGRAM_UP/DOWN
+		MidiQueue *m_queue;
+
+		edgeEvent_t m_event[eventQueueSize];
+		volatile uint8_t m_eventHead; // Written by the interrupt handlers only
+		volatile uint8_t m_eventTail; // Written by process() only
+		volatile uint32_t m_eventsDropped;
+
+		static DigitalInputs *s_instance;
+		template <int Input>
+		static void edgeInterrupt();
+
+		void edge(int input);
+		void activate(int input, bool active, uint32_t time);
+
+	public:
+		DigitalInputs();
+
+		// Configures the pins, their debounce filters (one filter time per PIO controller, so all inputs share debounceMicros) and change interrupts.
+		// Call once. Returns false if there are too many inputs.
+		bool init(const digitalInput_t *inputs, int numInputs, unsigned long debounceMicros, MidiQueue *queue);
+		void process(); // Maps queued edges to MIDI messages. Call from every loop() iteration.
+		uint32_t eventsDropped() { return m_eventsDropped; }
+	};
+
+}
+
+#endif /* PURE_DIGITALINPUTS_H */
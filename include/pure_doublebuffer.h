@@ -0,0 +1,50 @@
+#ifndef PURE_DOUBLEBUFFER_H
+#define PURE_DOUBLEBUFFER_H
+
+#include <Arduino.h>
+
+namespace PurpleReign
+{
+
+	// An active and a shadow copy of a settings object, published by an atomic pointer swap.
+	//
+	// Readers (e.g. the ADC scan) take a reference with active() once per pass and use only that reference during the pass; they never see a half
+	// updated object and never wait. The writer edits the shadow copy (edit() starts out from a copy of the active object) and makes it active with publish(),
+	// a single (32-bit, thus atomic) pointer store.
+	//
+	// There must be a single writer, and readers must be done with a reference before the writer calls edit() the second time after taking it
+	// (the then shadow copy is overwritten). Foreground tasks always are, since the writer runs in the same loop().
+	template <class T>
+	class DoubleBuffer
+	{
+	private:
+		T m_copy[2];
+		T *volatile m_active;
+
+		inline T *shadowCopy() { return (m_active == &m_copy[0]) ? &m_copy[1] : &m_copy[0]; }
+
+	public:
+		DoubleBuffer() : m_active(&m_copy[0]) {}
+
+		inline const T &active() const { return *m_active; }
+
+		// Copies the active object to the shadow copy and returns the shadow copy for editing
+		T &edit()
+		{
+			T *shadow = shadowCopy();
+			*shadow = *m_active;
+			return *shadow;
+		}
+
+		// Makes the (edited) shadow copy the active object
+		void publish()
+		{
+			T *shadow = shadowCopy();
+			__DMB(); // All writes to the shadow copy complete before the pointer swap
+			m_active = shadow;
+		}
+	};
+
+}
+
+#endif /* PURE_DOUBLEBUFFER_H */
@@ -0,0 +1,75 @@
+#ifndef PURE_ENCODERS_H
+#define PURE_ENCODERS_H
+
+#include <Arduino.h>
+
+namespace PurpleReign
+{
+
+	enum encoderMode_t
+	{
+		ENCODER_ABSOLUTE, // The encoder moves a 14-bit controller value, clamped to 0..16383, sent as a regular CC
+		ENCODER_RELATIVE  // The encoder sends its movement as a relative CC ("binary offset": 64 = no change, 65 = +1, 63 = -1, ...)
+	};
+
+	// A rotary encoder, connected to the phase inputs of a timer counter block in quadrature decoder mode
+	struct encoder_t
+	{
+		uint8_t qdec;		   // Quadrature decoder: 0 = TC0 (PHA pin 2, PHB pin 13), 1 = TC2 (PHA pin 5, PHB pin 4)
+		uint8_t ccNum;		   // CC number
+		uint8_t channel;	   // 0..15
+		uint8_t mode;		   // encoderMode_t
+		uint8_t countsPerStep; // Decoder counts per step (per detent), e.g. 4 for a detented encoder with one full quadrature cycle per detent
+	};
+
+	// Rotary encoders as CC sources, counted by the SAM3X timer counter quadrature decoders (QDEC).
+	//
+	// The decoder counts every edge of both phases in hardware, so no edge is lost however fast the encoder is spun, and it costs no CPU time.
+	// poll() only reads the position counters at a low rate, applies acceleration (the more steps since the previous poll, the larger each step)
+	// and reports the result through the absolute or relative CC function.
+	//
+	// Only TC0 and TC2 are usable: the TC1 decoder inputs are not routed to the Due headers (and TC1 channel 0 is taken by MidiClock anyway).
+	// Pin 13 (TIOB0) is also the LED pin, so the LED can not be used when TC0 decodes an encoder.
+	// The TC2 inputs (pins 5/4 = PC25/PC26) are column inputs of connector 2 of Keybed88Geometry, so with that keybed only TC0 is usable. See pioCMask().
+	class Encoders
+	{
+	public:
+		static const int maxEncoders = 2;	   // One per usable QDEC
+		static const int absoluteStep = 128;   // Absolute mode: change of the 14-bit value per (unaccelerated) step, i.e. one 7-bit CC step
+		static const int maxAcceleration = 8;  // Max multiplier applied to steps during fast spins
+		static const int accelerationSteps = 2; // The multiplier grows by one per this number of steps per poll
+
+	private:
+		encoder_t m_encoder[maxEncoders];
+		int m_numEncoders;
+		uint32_t m_lastCount[maxEncoders]; // Decoder position at the previous poll
+		int32_t m_residual[maxEncoders];   // Counts not yet making up a full step
+		int32_t m_value[maxEncoders];	   // Absolute mode: current 14-bit value
+		void (*m_absoluteFunction)(uint8_t ccNum, uint16_t ctrlVal, uint8_t channel);
+		void (*m_relativeFunction)(uint8_t ccNum, int delta, uint8_t channel);
+
+		static Tc *qdecTc(int qdec) { return qdec == 0 ? TC0 : TC2; }
+		static constexpr uint32_t qdecPioCMask(int qdec) { return qdec == 1 ? ((1ul << 25) | (1ul << 26)) : 0; } // PIOC input pins of a decoder (the TC0 ones are on PIOB)
+		static void initQdec(int qdec, unsigned long filterMaxCycles);
+
+	public:
+		Encoders();
+
+		// Configures the decoders and their input pins. filterMaxCycles (0..63) is the width in master clock cycles of pulses rejected by the input filter. Call once.
+		// Returns false if there are too many encoders, or if two encoders share a decoder.
+		bool init(const encoder_t *encoders, int numEncoders, unsigned long filterMaxCycles);
+		void setAbsoluteFunction(void (*function)(uint8_t ccNum, uint16_t ctrlVal, uint8_t channel));
+		void setRelativeFunction(void (*function)(uint8_t ccNum, int delta, uint8_t channel));
+		void setValue(int encoder, uint16_t ctrlVal); // Absolute mode: sets the current 14-bit value (e.g. to match a preset), without sending it
+		void poll();								  // Reads the decoders and reports any movement. Call at a low rate (e.g. 100 Hz).
+
+		// PIOC pins taken by the decoders of an encoder configuration, to check it against the keybed column port at compile time (see KeybedGeometry::colPortBitMask())
+		static constexpr uint32_t pioCMask(const encoder_t *encoders, int numEncoders)
+		{
+			return numEncoders <= 0 ? 0 : qdecPioCMask(encoders[0].qdec) | pioCMask(encoders + 1, numEncoders - 1);
+		}
+	};
+
+}
+
+#endif /* PURE_ENCODERS_H */
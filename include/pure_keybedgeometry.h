@@ -0,0 +1,107 @@
+#ifndef PURE_KEYBEDGEOMETRY_H
+#define PURE_KEYBEDGEOMETRY_H
+
+#include <Arduino.h>
+
+namespace PurpleReign
+{
+
+	///////////////////////////////////////////////////////////////////////////////////
+	//
+	// Keybed switch matrix geometry
+	//
+	// A keybed is scanned by driving one row "drive line" at a time LOW on the row port (PIOD) and reading all columns of all connectors in parallel from the column port (PIOC).
+	// Each key has <numSwitches> switches (MK = make = bottom switch, BK = break = top switch), each switch having its own drive line. Drive lines are ordered {row0,MK},{row0,BK},{row1,MK},... and
+	// occupy <numDriveLines> consecutive row port bits starting at <RowPortFirstBit>.
+	// The <NumCols> columns of each connector occupy consecutive column port bits starting at the connector's entry in <ColPortFirstBits...> (one entry per connector).
+	// Connectors whose bit is set in <InvertedConnectorMask> read LOW for an open switch (e.g. with a 74HC14 inverting buffer in series), and are inverted back by the scan.
+	//
+	// Everything the scan needs (port masks, column extraction shifts, key addresses) is derived from these parameters at compile time.
+	//
+	// Key addresses are assigned in connector, row, column order: address = ((con * numRows) + row) * numCols + col
+	// Matrix positions with an address >= <NumKeys> are unwired and never generate any notes.
+	// Dual manuals are handled as one matrix with more connectors; the upper manual's keys then simply start at address (connectorsOfLowerManual * numRows * numCols).
+	//
+	///////////////////////////////////////////////////////////////////////////////////
+
+	template <int NumRows, int NumCols, int NumKeys, int RowPortFirstBit, uint32_t InvertedConnectorMask, int... ColPortFirstBits>
+	struct KeybedGeometry
+	{
+		static const int numConnectors = sizeof...(ColPortFirstBits); // number of switch matrix connectors on keybed
+		static const int numRows = NumRows;							  // number of key switch matrix rows per connector, disregarding the number of switches per key
+		static const int numSwitches = 2;							  // Number of key switches per key (2 switches => 1 make, 1 break)
+		static const int numCols = NumCols;							  // number of key switch matrix columns per connector
+		static const int numKeys = NumKeys;							  // number of wired keys
+		static const int numKeySlots = numConnectors * numRows * numCols; // number of key positions in the matrix (wired or not)
+		static const int numDriveLines = numRows * numSwitches;		  // number of row port bits driven during one scan
+
+		static const uint32_t rowPortInitialBitPattern = ((uint32_t)1) << RowPortFirstBit;										// Drive line of {row0,MK}
+		static const uint32_t rowPortBitMask = (uint32_t)((((uint64_t)1) << numDriveLines) - 1) << RowPortFirstBit;			// All drive lines
+		static const uint32_t colMask = (uint32_t)((((uint64_t)1) << numCols) - 1);											// Columns of one connector, shifted down to bit 0
+		static constexpr int colPortFirstBit[numConnectors] = {ColPortFirstBits...};											// Column port bit of column 0, per connector
+
+		static Pio *rowPort() { return PIOD; }
+		static Pio *colPort() { return PIOC; }
+		static const uint32_t rowPortId = ID_PIOD; // Peripheral IDs of the ports, for their clocks (see VelocityKeybed::init())
+		static const uint32_t colPortId = ID_PIOC;
+
+		// Mask of the packed column bit matrix bits (see packColumns()) belonging to inverted connectors
+		static constexpr uint32_t colInvertMask(int con = 0)
+		{
+			return (con >= numConnectors) ? 0 : (((InvertedConnectorMask >> con) & 1) ? (colMask << (con * numCols)) : 0) | colInvertMask(con + 1);
+		}
+
+		// Column port bits in use, for all connectors
+		static constexpr uint32_t colPortBitMask(int con = 0)
+		{
+			return (con >= numConnectors) ? 0 : (colMask << colPortFirstBit[con]) | colPortBitMask(con + 1);
+		}
+
+		// Pack the columns of all connectors into one bit matrix, connector 0 in the lowest <numCols> bits, connector 1 in the next <numCols> bits and so on.
+		// Inverted connectors are inverted back, so a set bit always means an open switch (HIGH) and a cleared bit a closed switch (LOW).
+		static inline uint32_t packColumns(uint32_t colPortInput)
+		{
+			uint32_t colKeySwitchBM = 0;
+			for (int con = 0; con < numConnectors; con++) // Loop has a compile time trip count and is unrolled by the compiler into <numConnectors> shift-and-mask operations
+				colKeySwitchBM |= ((colPortInput >> colPortFirstBit[con]) & colMask) << (con * numCols);
+			return colKeySwitchBM ^ colInvertMask();
+		}
+
+		static inline int keyAddress(int con, int row, int col)
+		{
+			return ((con * numRows) + row) * numCols + col;
+		}
+
+		static_assert(numConnectors >= 1, "At least one connector is needed");
+		static_assert(numConnectors * numCols <= 32, "Packed column bit matrix must fit in 32 bits");
+		static_assert(RowPortFirstBit + numDriveLines <= 32, "Drive lines must fit in the row port");
+		static_assert(numKeys <= numKeySlots, "More keys than matrix positions");
+	};
+
+	template <int NumRows, int NumCols, int NumKeys, int RowPortFirstBit, uint32_t InvertedConnectorMask, int... ColPortFirstBits>
+	constexpr int KeybedGeometry<NumRows, NumCols, NumKeys, RowPortFirstBit, InvertedConnectorMask, ColPortFirstBits...>::colPortFirstBit[];
+
+	///////////////////////////////////////////////////////////////////////////////////
+	// Predefined geometries
+	///////////////////////////////////////////////////////////////////////////////////
+
+	// 61 key (5 octave) keybed, 2 connectors with 4 rows x 8 columns each.
+	//  * Drive lines: D.1..D.8 (Due pins 26, 27, 28, 14, 15, 29, 11, 12)
+	//  * Connector 0 columns: C.1..C.8 (Due pins 33..40), inverted (74HC14 in series with connector 0 output)
+	//  * Connector 1 columns: C.12..C.19 (Due pins 51..44)
+	typedef KeybedGeometry<4, 8, 61, 1, 0b01, 1, 12> Keybed61Geometry;
+
+	// 76 key keybed, 2 connectors with 5 rows x 8 columns each. Same column wiring as the 61 key keybed.
+	//  * Drive lines: D.1..D.10 (Due pins 26, 27, 28, 14, 15, 29, 11, 12, 30, 32)
+	typedef KeybedGeometry<5, 8, 76, 1, 0b01, 1, 12> Keybed76Geometry;
+
+	// 88 key keybed, 3 connectors with 5 rows x 6 columns each.
+	//  * Drive lines: D.0..D.9 (Due pins 25, 26, 27, 28, 14, 15, 29, 11, 12, 30)
+	//  * Connector 0 columns: C.1..C.6 (Due pins 33..38), inverted
+	//  * Connector 1 columns: C.12..C.17 (Due pins 51..46)
+	//  * Connector 2 columns: C.21..C.26 (Due pins 9..4)
+	typedef KeybedGeometry<5, 6, 88, 0, 0b001, 1, 12, 21> Keybed88Geometry;
+
+}
+
+#endif /* PURE_KEYBEDGEOMETRY_H */
@@ -0,0 +1,48 @@
+#ifndef PURE_KEYMOTIONMODEL_H
+#define PURE_KEYMOTIONMODEL_H
+
+#include <stdint.h>
+
+#include <pure_timebase.h>
+
+namespace PurpleReign
+{
+
+	// Synthetic key motion: raw sensor values of keys played by a script, as a position source for AnalogKeybed without sensors.
+	// Runs on a host (with PURE_VIRTUAL_CLOCK) as well as on the target (e.g. for bring-up of the MIDI side before the sensors are fitted).
+	//
+	// A stroke moves the key from rest to the bottom at constant speed, holds it while pressing into the felt (up to the overtravel and back, over the hold time),
+	// and releases it at constant speed. Optional noise is added to every reading.
+	class KeyMotionModel
+	{
+	public:
+		static const int maxKeys = 128;
+
+	private:
+		struct stroke_t
+		{
+			uint32_t start;			// Time stamp (Timebase::now32()) of the start of the stroke
+			uint32_t pressCycles;	// Rest to bottom
+			uint32_t holdCycles;	// At the bottom
+			uint32_t releaseCycles; // Bottom to rest
+			int16_t overtravel;		// Max normalized position beyond the bottom, reached in the middle of the hold
+			uint8_t active;
+		};
+
+		stroke_t m_stroke[maxKeys];
+		uint16_t m_restRaw;
+		uint16_t m_bottomRaw;
+		int m_noise;			 // Max noise amplitude, in raw units
+		mutable uint32_t m_seed; // Noise generator state
+
+	public:
+		KeyMotionModel(uint16_t restRaw, uint16_t bottomRaw);
+		void setNoise(int amplitude) { m_noise = amplitude; }
+		void press(int key, uint32_t pressMicros, uint32_t holdMicros, uint32_t releaseMicros, int overtravel); // Starts a stroke now (Timebase::now32())
+		int position(int key) const;																		  // Normalized position (0 = rest, analogKeyPositionMax = bottom) now, without noise
+		uint16_t raw(int key) const;																		  // Raw sensor value now, with noise
+	};
+
+}
+
+#endif /* PURE_KEYMOTIONMODEL_H */
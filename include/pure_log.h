@@ -0,0 +1,129 @@
+#ifndef PURE_LOG_H
+#define PURE_LOG_H
+
+#include <Arduino.h>
+
+#include <pure_logformats.h>
+#include <pure_timebase.h>
+
+// Log levels. PURE_LOG_LEVEL is the highest level compiled in, 0 compiles out all logging. Set it for all sources, e.g. build_flags = -DPURE_LOG_LEVEL=4
+#define PURE_LOG_LEVEL_ERROR 1
+#define PURE_LOG_LEVEL_WARN 2
+#define PURE_LOG_LEVEL_INFO 3
+#define PURE_LOG_LEVEL_DEBUG 4
+#define PURE_LOG_LEVEL_TRACE 5
+
+#ifndef PURE_LOG_LEVEL
+#define PURE_LOG_LEVEL PURE_LOG_LEVEL_INFO
+#endif
+
+// Log subsystems (bit mask). PURE_LOG_SUBSYSTEMS selects the subsystems compiled in, e.g. -DPURE_LOG_SUBSYSTEMS=0x06 for keybed and controllers only.
+#define PURE_LOG_CORE 0x01
+#define PURE_LOG_KEYBED 0x02
+#define PURE_LOG_CTRL 0x04
+#define PURE_LOG_MIDI 0x08
+#define PURE_LOG_CONFIG 0x10
+#define PURE_LOG_ALL 0xFF
+
+#ifndef PURE_LOG_SUBSYSTEMS
+#define PURE_LOG_SUBSYSTEMS PURE_LOG_ALL
+#endif
+
+#define PURE_LOG_ENABLED(level, subsystem) ((level) <= PURE_LOG_LEVEL && ((subsystem) & PURE_LOG_SUBSYSTEMS) != 0)
+
+// PURE_LOG(level, subsystem, formatId, args...): formatId is an ID of include/pure_logformats.h, args are up to Log::maxArgs integers or floats.
+// A log site that is filtered out at compile time generates no code (the condition is a constant).
+#define PURE_LOG(level, subsystem, id, ...)                                                   \
+	do                                                                                        \
+	{                                                                                         \
+		if (PURE_LOG_ENABLED(level, subsystem))                                               \
+			PurpleReign::Log::write(level, subsystem, PurpleReign::LOGFMT_##id, ##__VA_ARGS__); \
+	} while (0)
+
+#define PURE_LOG_ERROR(subsystem, id, ...) PURE_LOG(PURE_LOG_LEVEL_ERROR, subsystem, id, ##__VA_ARGS__)
+#define PURE_LOG_WARN(subsystem, id, ...) PURE_LOG(PURE_LOG_LEVEL_WARN, subsystem, id, ##__VA_ARGS__)
+#define PURE_LOG_INFO(subsystem, id, ...) PURE_LOG(PURE_LOG_LEVEL_INFO, subsystem, id, ##__VA_ARGS__)
+#define PURE_LOG_DEBUG(subsystem, id, ...) PURE_LOG(PURE_LOG_LEVEL_DEBUG, subsystem, id, ##__VA_ARGS__)
+#define PURE_LOG_TRACE(subsystem, id, ...) PURE_LOG(PURE_LOG_LEVEL_TRACE, subsystem, id, ##__VA_ARGS__)
+
+namespace PurpleReign
+{
+
+	enum logFormatId_t
+	{
+#define PURE_LOG_FORMAT_ID(id, format) LOGFMT_##id,
+		PURE_LOG_FORMATS(PURE_LOG_FORMAT_ID)
+#undef PURE_LOG_FORMAT_ID
+			numLogFormats
+	};
+
+	// Deferred binary log.
+	//
+	// A log site only stores a record (time stamp, format ID and raw argument words) in a ring, with interrupts disabled for the copy, so it can be
+	// used from interrupt handlers and the scan path. No formatting is done on the device: flush() sends the records as binary frames, and
+	// tools/decode_log.py formats them on the host with the strings of include/pure_logformats.h. When the ring is full, new records are dropped
+	// and counted, and the count is logged (LOG_OVERFLOW) once there is room again.
+	//
+	// Frame: 0xA5, payload length, payload, checksum (sum of the payload bytes, modulo 256).
+	// Payload (little endian): time (Timebase::now32(), 4 bytes), format ID (2 bytes), level, subsystem, arguments (4 bytes each).
+	// The frame byte 0xA5 is not ASCII, so frames and plain text output (e.g. the LOG_* statistics) can share the serial port.
+	class Log
+	{
+	public:
+		static const int maxArgs = 4;
+		static const int ringSize = 64; // Records. Must be a power of 2 (and below 256).
+		static const uint8_t frameStart = 0xA5;
+
+	private:
+		struct record_t
+		{
+			uint32_t time;
+			uint16_t formatId;
+			uint8_t level;
+			uint8_t subsystem;
+			uint8_t numArgs;
+			uint32_t arg[maxArgs];
+		};
+
+		static record_t s_ring[ringSize];
+		static volatile uint8_t s_head; // Next record to write, written by write() (with interrupts disabled, since there can be several producers)
+		static volatile uint8_t s_tail; // Next record to send, written by flush() only
+		static volatile uint32_t s_dropped;
+
+		static inline uint32_t toWord(int value) { return (uint32_t)value; }
+		static inline uint32_t toWord(unsigned value) { return value; }
+		static inline uint32_t toWord(long value) { return (uint32_t)value; }
+		static inline uint32_t toWord(unsigned long value) { return (uint32_t)value; }
+		static inline uint32_t toWord(short value) { return (uint32_t)(int)value; }
+		static inline uint32_t toWord(unsigned short value) { return value; }
+		static inline uint32_t toWord(signed char value) { return (uint32_t)(int)value; }
+		static inline uint32_t toWord(unsigned char value) { return value; }
+		static inline uint32_t toWord(char value) { return (uint32_t)(int)value; }
+		static inline uint32_t toWord(bool value) { return value; }
+		static inline uint32_t toWord(float value)
+		{
+			uint32_t word;
+			memcpy(&word, &value, sizeof(word));
+			return word;
+		}
+		static inline uint32_t toWord(double value) { return toWord((float)value); }
+
+		static void writeRecord(uint8_t level, uint8_t subsystem, uint16_t formatId, const uint32_t *args, int numArgs);
+		static void sendRecord(Print *out, const record_t &record);
+
+	public:
+		template <typename... Args>
+		static inline void write(uint8_t level, uint8_t subsystem, uint16_t formatId, Args... args)
+		{
+			static_assert(sizeof...(Args) <= maxArgs, "Too many log arguments");
+			const uint32_t words[sizeof...(Args) + 1] = {toWord(args)...}; // + 1, since an array can not be empty
+			writeRecord(level, subsystem, formatId, words, sizeof...(Args));
+		}
+
+		static void flush(Print *out, int maxRecords); // Sends up to maxRecords records. Call from loop(), e.g. from a low rate task.
+		static uint32_t dropped() { return s_dropped; }
+	};
+
+}
+
+#endif /* PURE_LOG_H */
@@ -0,0 +1,23 @@
+#ifndef PURE_LOGFORMATS_H
+#define PURE_LOGFORMATS_H
+
+// Log message formats, see include/pure_log.h. The firmware only stores the index of the format (logFormatId_t) and the raw arguments,
+// the strings are read from this file by the host decoder (tools/decode_log.py), so they take no flash.
+//
+// One X(ID, "format") per line. Append new formats at the end, so logs of older firmware still decode.
+// Conversions: %d (signed), %u (unsigned), %x (hex), %f (float). At most PurpleReign::Log::maxArgs per format.
+#define PURE_LOG_FORMATS(X)                                                                             \
+	X(LOG_OVERFLOW, "%u log records dropped (ring full)")                                               \
+	X(CONFIG_LOADED, "Configuration loaded from flash")                                                 \
+	X(CONFIG_DEFAULTS, "No stored configuration, using defaults")                                       \
+	X(CTRL_MAP_SET_BEGIN, "Entering setAdcToCtrlMap(), %d borders")                                     \
+	X(CTRL_MAP_SET_END, "Exiting setAdcToCtrlMap()")                                                    \
+	X(CTRL_MAP_BORDER, "Border %d: adcValue %u ctrlValue %u k %f")                                      \
+	X(CTRL_MAP_HEADER, "adcToCtrlMap: numAdcRanges %d numAdcRangeBorders %d ctrlRangeBorderHighest %u") \
+	X(CTRL_MAP_RANGE, "  range %d: adcRangeBorder %u k %f m %u")                                        \
+	X(CTRL_MAP_TOP, "  adcRangeBorder[%d] %u")                                                          \
+	X(PITCH_BEND_VALUE, "Pitch bend %u (was %u)")                                                       \
+	X(MIDI_OUTPUT_STALL, "MIDI output %d stalled, backlog dropped (0 = USB, 1.. = sinks)")              \
+	X(MIDI_OUTPUT_RESYNC, "MIDI output %d resynced")
+
+#endif /* PURE_LOGFORMATS_H */
@@ -0,0 +1,34 @@
+#ifndef PURE_METRICNAMES_H
+#define PURE_METRICNAMES_H
+
+// Runtime metrics, see include/pure_metrics.h. The firmware only sends the values of a snapshot, in this order, the names are read from this file
+// by the host tools (tools/decode_log.py, tools/query_metrics.py), so they take no flash.
+//
+// One X(ID, KIND, "name") per line. KIND is COUNTER (only increases, wraps at 2^32: use the difference of two snapshots), GAUGE (last value set)
+// or PEAK (highest value seen since the last peak reset). Append new metrics at the end, so snapshots of older firmware still decode.
+#define PURE_METRIC_NAMES(X)                                                   \
+	X(KEYBED_SCANS, COUNTER, "keybed.scans")                                   \
+	X(KEYBED_SCAN_RATE, GAUGE, "keybed.scans_per_s")                           \
+	X(KEYBED_INFLIGHT_SCANS, COUNTER, "keybed.inflight_scans")                 \
+	X(MIDI_EVENTS_ENQUEUED, COUNTER, "midi.events_enqueued")                   \
+	X(MIDI_QUEUE_PEAK, PEAK, "midi.queue_peak")                                \
+	X(MIDI_USB_WRITE_FAILURES, COUNTER, "midi.usb_write_failures")             \
+	X(ADC_SAMPLES, COUNTER, "adc.samples")                                     \
+	X(CTRL_FILTERED, COUNTER, "ctrl.filtered")                                 \
+	X(CTRL_EMITTED, COUNTER, "ctrl.emitted")                                   \
+	X(TASK_OVERRUNS_KEYBED, COUNTER, "task.keybed.overruns")                   \
+	X(TASK_OVERRUNS_KEYBED_INFLIGHT, COUNTER, "task.keybed_inflight.overruns") \
+	X(TASK_OVERRUNS_ADC, COUNTER, "task.adc.overruns")                         \
+	X(TASK_OVERRUNS_ENCODERS, COUNTER, "task.encoders.overruns")               \
+	X(TASK_OVERRUNS_MIDI_IN, COUNTER, "task.midi_in.overruns")                 \
+	X(TASK_OVERRUNS_LOG_FLUSH, COUNTER, "task.log_flush.overruns")             \
+	X(MIDI_CONTROLLERS_SHED, COUNTER, "midi.controllers_shed")                 \
+	X(MIDI_NOTE_ONS_SHED, COUNTER, "midi.note_ons_shed")                       \
+	X(MIDI_NOTE_OFFS_SHED, COUNTER, "midi.note_offs_shed")                     \
+	X(MIDI_OVERFLOWS, COUNTER, "midi.overflows")                               \
+	X(MIDI_OUTPUT_STALLS, COUNTER, "midi.output_stalls")                       \
+	X(MIDI_OUTPUT_RESYNCS, COUNTER, "midi.output_resyncs")                     \
+	X(MIDI_RESYNC_NOTE_OFFS, COUNTER, "midi.resync_note_offs")                 \
+	X(MIDI_ALL_NOTES_OFFS, COUNTER, "midi.all_notes_offs")
+
+#endif /* PURE_METRICNAMES_H */
@@ -0,0 +1,79 @@
+#ifndef PURE_METRICS_H
+#define PURE_METRICS_H
+
+#include <Arduino.h>
+
+#include <pure_metricnames.h>
+
+// PURE_METRICS 0 compiles out all metric updates (the registry reads as all zeros). Set it for all sources, e.g. build_flags = -DPURE_METRICS=0
+#ifndef PURE_METRICS
+#define PURE_METRICS 1
+#endif
+
+namespace PurpleReign
+{
+
+	enum metricId_t
+	{
+#define PURE_METRIC_ID(id, kind, name) METRIC_##id,
+		PURE_METRIC_NAMES(PURE_METRIC_ID)
+#undef PURE_METRIC_ID
+			numMetrics
+	};
+
+	// Registry of runtime metrics (counters, gauges and peaks, see include/pure_metricnames.h), always compiled in, so a unit in the field can be
+	// monitored without a debug build.
+	//
+	// An update is a single relaxed atomic operation on a 32-bit word (LDREX/STREX on the Cortex-M3, no barriers, no interrupt masking), so updates
+	// can be made from the scan path and from interrupt handlers. A snapshot reads the values one at a time: it is not taken at a single instant,
+	// which does not matter for counters that are compared between snapshots.
+	//
+	// Snapshots are sent as:
+	//  * A binary frame on a serial port (sendFrame()): 0xA6, payload length, payload, checksum (sum of the payload bytes, modulo 256).
+	//    Payload (little endian): time (Timebase::now32(), 4 bytes), number of metrics, values (4 bytes each, in metricId_t order).
+	//    The frame byte 0xA6 is not ASCII, so snapshots can share the port with text and the log frames (0xA5) of PurpleReign::Log.
+	//  * The data part of a SysEx reply (sysexSnapshot()): the same fields, each value in five 7-bit groups, MSB first (see MidiCtrl::pack32()).
+	// tools/query_metrics.py requests and decodes both.
+	class Metrics
+	{
+	public:
+		static const uint8_t frameStart = 0xA6;
+		static const int framePayloadLength = 4 + 1 + 4 * numMetrics;
+		static const int sysexSnapshotLength = 5 + 1 + 5 * numMetrics;
+		static_assert(framePayloadLength < 256, "The payload length is sent in one byte");
+
+	private:
+		static uint32_t s_value[numMetrics];
+
+	public:
+		static inline void add(metricId_t id, uint32_t amount)
+		{
+#if PURE_METRICS
+			__atomic_fetch_add(&s_value[id], amount, __ATOMIC_RELAXED);
+#endif
+		}
+		static inline void increment(metricId_t id) { add(id, 1); }
+		static inline void set(metricId_t id, uint32_t value)
+		{
+#if PURE_METRICS
+			__atomic_store_n(&s_value[id], value, __ATOMIC_RELAXED);
+#endif
+		}
+		static inline void peak(metricId_t id, uint32_t value) // Raises a PEAK metric to value, if it is higher
+		{
+#if PURE_METRICS
+			uint32_t seen = __atomic_load_n(&s_value[id], __ATOMIC_RELAXED);
+			while (value > seen && !__atomic_compare_exchange_n(&s_value[id], &seen, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				;
+#endif
+		}
+		static inline uint32_t value(metricId_t id) { return __atomic_load_n(&s_value[id], __ATOMIC_RELAXED); }
+
+		static void resetPeaks();                          // Restarts the PEAK metrics from 0, e.g. after a snapshot
+		static void sendFrame(Print *out);                 // Sends a snapshot as a binary frame
+		static int sysexSnapshot(uint8_t *data, int size); // Writes a snapshot as SysEx data bytes. Returns the number of bytes (sysexSnapshotLength), 0 if size is too small.
+	};
+
+}
+
+#endif /* PURE_METRICS_H */
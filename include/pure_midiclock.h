@@ -0,0 +1,67 @@
+#ifndef PURE_MIDICLOCK_H
+#define PURE_MIDICLOCK_H
+
+#include <Arduino.h>
+
+#include <pure_midiqueue.h>
+#include <pure_timebase.h>
+
+namespace PurpleReign
+{
+
+	struct midiClockStats_t
+	{
+		uint32_t ticks;				  // Number of clock ticks (timer interrupts)
+		uint32_t maxTimerJitterCycles; // Highest deviation of the time between two timer interrupts from the clock period (interrupt latency variation)
+	};
+
+	// MIDI clock and transport generator (24 PPQN, start/stop/continue), with the tempo set by the host (setTempo()) or by tapping (tap()).
+	//
+	// The clock is driven by a hardware timer (TC1 channel 0, i.e. TC3 in Arduino numbering; TC0 and TC2 are left for quadrature decoders) at the highest
+	// interrupt priority, not by a polled Task, so it does not inherit the jitter of loop(). The interrupt only time stamps the tick and pushes a clock message
+	// to the realtime lane of the MidiQueue, which sends it ahead of all queued traffic. Call timerInterrupt() from TC3_Handler().
+	//
+	// Jitter is measured at both ends: maxTimerJitterCycles (here) covers the timer interrupt, and the realtime delay statistics of the MidiQueue
+	// (max - min delay from time stamp to USB write) cover the output path.
+	class MidiClock
+	{
+	public:
+		static const int ppqn = 24;
+		static const uint32_t minTempo = 2000;	 // In 1/100 BPM
+		static const uint32_t maxTempo = 30000;	 // In 1/100 BPM
+		static const uint32_t timerClockHz = VARIANT_MCK / 2; // TIMER_CLOCK1
+		static const uint32_t maxTapIntervalMicros = 2000000; // A longer pause starts a new tap sequence
+		static const int numTapIntervals = 3;				   // Number of tap intervals averaged
+
+	private:
+		MidiQueue *m_queue;
+		volatile uint32_t m_timerPeriod;		// Timer counts (TIMER_CLOCK1) per clock tick
+		volatile bool m_timerPeriodChanged;		// Set by setTempo(), the timer interrupt applies the new period
+		volatile uint32_t m_lastTickTime;		// Time stamp (Timebase::now32()) of the previous tick
+		volatile bool m_jitterValid;			// False until two ticks at the same period have been seen
+		uint32_t m_tempo;						// In 1/100 BPM
+		bool m_running;							// Transport state (the clock ticks also when stopped, so receivers can lock to the tempo)
+		uint32_t m_tapTime[numTapIntervals + 1]; // Time stamps (Timebase::now32()) of the latest taps
+		int m_numTaps;
+		midiClockStats_t m_stats;
+
+		static uint32_t tempoToTimerPeriod(uint32_t tempo);
+
+	public:
+		MidiClock();
+		void init(MidiQueue *queue, uint32_t tempo); // Starts the clock timer
+		void setTempo(uint32_t tempo);				 // In 1/100 BPM, clamped to [minTempo..maxTempo]
+		uint32_t tempo() { return m_tempo; }
+		void tap(); // Tap tempo: sets the tempo from the average of the latest tap intervals
+		void start();
+		void stop();
+		void resume(); // MIDI continue
+		bool isRunning() { return m_running; }
+		void timerInterrupt();
+		const midiClockStats_t &stats() { return m_stats; }
+		void resetStats();
+	};
+
+}
+
+#endif /* PURE_MIDICLOCK_H */
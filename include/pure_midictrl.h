@@ -1,15 +1,93 @@
 #ifndef PURE_MIDICTRL_H
 #define PURE_MIDICTRL_H
 
+#include <Arduino.h>
+
 namespace PurpleReign
 {
 
+	// Configuration over MIDI: Consumes incoming USB-MIDI and parses PurpleReign configuration SysEx messages.
+	//
+	// Message format: F0 7D 50 <command> <data bytes...> F7
+	//  * 7D is the SysEx ID for non-commercial use, 50 ('P') identifies PurpleReign. Other SysEx messages are skipped.
+	//  * Multi byte values are sent MSB first, in 7-bit groups (see unpack14()/unpack21()).
+	//
+	// The parser is resumable at any byte: poll() processes at most a given number of bytes per call and continues with the rest (even in the middle of
+	// a USB-MIDI packet) at the next call. This bounds the time spent on incoming MIDI per scheduler slot, so a large transfer never delays the keybed scan.
+	// Packets passed on to the thru function count against the same budget, so a burst of notes or controllers from the host does not delay the scan either.
+	// Complete messages are handed to the config function (see setConfigFunction()), which validates and applies them.
+	// USB-MIDI SysEx is reserved for configuration; other messages can be passed on to a thru function (see setThruFunction()), e.g. to merge them into the output.
 	class MidiCtrl
 	{
 	public:
+		static const uint8_t sysexManufacturerId = 0x7D; // Non-commercial use
+		static const uint8_t sysexProductId = 0x50;		 // 'P' for PurpleReign
+		static const int maxSysexDataLength = 64;		 // Longest data part (after the command byte) of a configuration message. Longer messages are rejected.
+
+		enum sysexCommand_t
+		{
+			CMD_SET_14BIT_CC = 0x01,		  // <0|1>: 7 or 14 bit CC mode
+			CMD_SELECT_VELOCITY_CURVE = 0x02, // <curve>: velocityCurveType_t
+			CMD_SET_SWITCH_MUTE_TIME = 0x03,  // <mkbk> <micros (21 bit)>: switch mute (debounce) time per switch type
+			CMD_ASSIGN_CC_MAP = 0x04,		  // <ccNum (0..127)> <mapIx>: ADC to controller map used by a CC
+			CMD_SET_CTRL_MAP = 0x05,		  // <mapIx> <numBorders> {<adcValue (14 bit)> <ctrlValue (14 bit)>} * numBorders: ADC to controller map
+			CMD_STORE_CONFIG = 0x06,		  // (no data): Store the active configuration in flash, it is loaded at boot
+			CMD_RESET_CONFIG = 0x07,		  // (no data): Revert to the factory defaults (not stored until CMD_STORE_CONFIG)
+			CMD_SET_TEMPO = 0x08,			  // <tempo (21 bit)>: MIDI clock tempo in 1/100 BPM
+			CMD_TRANSPORT = 0x09,			  // <0|1|2>: MIDI clock stop, start or continue
+			CMD_TAP_TEMPO = 0x0A,			  // (no data): MIDI clock tap tempo
+			CMD_SET_ZONES = 0x0B,			  // <numZones> {<lowKey> <highKey> <channel> <noteOffset + 64>} * numZones: Keyboard zones (splits, layers, transposition)
+			CMD_AUTOTUNE_MUTE_TIMES = 0x0C,	  // <minMicros (21 bit)> <maxMicros (21 bit)>: Derive per switch mute times from the switch chatter statistics (not stored)
+			// 0x0D is not used
+			CMD_GET_METRICS = 0x0E			  // <0|1>: Request a metrics snapshot, 1 also restarts the peak metrics. Replied to over USB with F0 7D 50 0E <snapshot> F7, see Metrics::sysexSnapshot().
+		};
+
+	private:
+		enum parserState_t
+		{
+			IDLE,		  // Outside of SysEx, or skipping a SysEx message that is not ours
+			MANUFACTURER, // F0 received
+			PRODUCT,	  // Manufacturer ID matched
+			COMMAND,	  // Product ID matched
+			DATA		  // Command received, collecting data bytes
+		};
+
+		parserState_t m_state;
+		uint8_t m_command;
+		uint8_t m_data[maxSysexDataLength];
+		int m_dataLength;
+
+		uint8_t m_packet[3]; // MIDI bytes of the current USB-MIDI packet
+		int m_packetLength;	 // Number of MIDI bytes in m_packet
+		int m_packetIx;		 // Next byte in m_packet to parse. Equals m_packetLength when the packet has been fully parsed.
+
+		uint32_t m_numApplied;	// Number of configuration messages applied
+		uint32_t m_numRejected; // Number of configuration messages rejected (too long, or rejected by the config function)
+
+		bool (*m_configFunction)(uint8_t command, const uint8_t *data, int length);
+		void (*m_thruFunction)(uint32_t packet);
+
+		int fetchPacket();
+		void parseByte(uint8_t midiByte);
+
+	public:
+		MidiCtrl();
 		int init();
+		void setConfigFunction(bool (*function)(uint8_t command, const uint8_t *data, int length)); // The function returns false if the message is invalid
+		void setThruFunction(void (*function)(uint32_t packet));									   // Gets the received non-SysEx USB-MIDI packets (e.g. for MidiMerge), instead of discarding them
+		int poll(int byteBudget);																	   // Parses (or passes on) at most byteBudget bytes of incoming MIDI, a packet passed on counts as 3. Returns the number of bytes.
+		uint32_t numApplied() { return m_numApplied; }
+		uint32_t numRejected() { return m_numRejected; }
+
+		static inline uint16_t unpack14(const uint8_t *data) { return (data[0] << 7) | data[1]; }
+		static inline uint32_t unpack21(const uint8_t *data) { return (data[0] << 14) | (data[1] << 7) | data[2]; }
+		static inline void pack32(uint32_t value, uint8_t *data) // Five 7-bit groups, MSB first (for replies)
+		{
+			for (int ix = 4; ix >= 0; ix--, value >>= 7)
+				data[ix] = value & 0x7F;
+		}
 	};
 
 }
 
-#endif /* PURE_MIDICTRL_H */
\ No newline at end of file
+#endif /* PURE_MIDICTRL_H */
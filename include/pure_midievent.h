@@ -0,0 +1,100 @@
+#ifndef PURE_MIDIEVENT_H
+#define PURE_MIDIEVENT_H
+
+#include <stdint.h>
+
+namespace PurpleReign
+{
+
+	// Internal MIDI event types. The use of the midiEvent_t fields per type:
+	enum midiEventType_t
+	{
+		EVENT_NOTE_OFF,			// index: key, data: velocity (7 bit), value: velocity (16 bit)
+		EVENT_NOTE_ON,			// index: key, data: velocity (7 bit, 1..127), value: velocity (16 bit)
+		EVENT_POLY_PRESSURE,	// index: key, data: pressure (7 bit)
+		EVENT_CONTROL_CHANGE,	// index: controller, data: value (7 bit, i.e. the MSB), value: value (14 bit). See EVENT_FLAG_LSB and EVENT_FLAG_7BIT.
+		EVENT_PROGRAM_CHANGE,	// index: program
+		EVENT_CHANNEL_PRESSURE, // data: pressure (7 bit)
+		EVENT_PITCH_BEND,		// value: 14 bit, 8192 = center
+		EVENT_SYSTEM_COMMON,	// channel: status (0xF1..0xF6), index, data: data bytes (as far as the status has them)
+		EVENT_SYSEX,			// A piece (up to 3 bytes, F0 and F7 included) of a SysEx message. channel: number of bytes, index, data, value (low byte): the bytes.
+		EVENT_REALTIME			// channel: status (0xF8..0xFF). Not queued, but handed to sinks from the realtime lane of the MidiQueue.
+	};
+
+	const uint8_t EVENT_FLAG_LSB = 0x01;  // Controller change: MIDI 1.0 encoders also send the LSB controller (index + 32), i.e. 14-bit CC mode
+	const uint8_t EVENT_FLAG_7BIT = 0x02; // Controller change: only data is valid (e.g. relative controllers), there is no high resolution value
+	const uint8_t EVENT_FLAG_USB_ONLY = 0x04; // Only sent to USB, skipped by the other sinks (e.g. a SysEx reply to the host, see MidiQueue::pushSysex())
+	const uint8_t EVENT_FLAG_FROM_DIN = 0x08; // Merged from the DIN input (see MidiMerge::setSourceFlags()), so the DIN output can leave it out instead of echoing it
+
+	// A MIDI event as emitted by the producers (keybed, controllers, merge), independent of any transport.
+	// Sinks (USB-MIDI 1.0, DIN, trace, ...) encode events when they send them, see MidiQueue.
+	struct midiEvent_t
+	{
+		uint8_t type;	 // midiEventType_t
+		uint8_t channel; // 0..15, or the status byte of system events
+		uint8_t index;	 // Key, controller or program number
+		uint8_t data;	 // 7-bit value (MIDI 1.0 resolution)
+		uint16_t value;	 // High resolution value, where the producer has one (see midiEventType_t)
+		uint8_t flags;	 // EVENT_FLAG_*
+		uint8_t reserved;
+		uint32_t time; // Capture time (Timebase::now32())
+	};
+
+	// Event builders and stateless encoders
+	class MidiEvent
+	{
+	public:
+		static inline midiEvent_t make(uint8_t type, uint8_t channel, uint8_t index, uint8_t data, uint16_t value, uint8_t flags, uint32_t time)
+		{
+			midiEvent_t event;
+			event.type = type;
+			event.channel = channel;
+			event.index = index;
+			event.data = data;
+			event.value = value;
+			event.flags = flags;
+			event.reserved = 0;
+			event.time = time;
+			return event;
+		}
+		static inline midiEvent_t noteOn(uint8_t channel, uint8_t key, uint8_t velocity, uint16_t velocity16, uint32_t time) { return make(EVENT_NOTE_ON, channel, key, velocity, velocity16, 0, time); }
+		static inline midiEvent_t noteOff(uint8_t channel, uint8_t key, uint8_t velocity, uint16_t velocity16, uint32_t time) { return make(EVENT_NOTE_OFF, channel, key, velocity, velocity16, 0, time); }
+		static inline midiEvent_t polyPressure(uint8_t channel, uint8_t key, uint8_t pressure, uint32_t time) { return make(EVENT_POLY_PRESSURE, channel, key, pressure, 0, 0, time); }
+		static inline midiEvent_t controlChange(uint8_t channel, uint8_t ccNum, uint16_t value14, uint8_t flags, uint32_t time) { return make(EVENT_CONTROL_CHANGE, channel, ccNum, (value14 >> 7) & 0x7F, value14 & 0x3FFF, flags, time); }
+		static inline midiEvent_t controlChange7(uint8_t channel, uint8_t ccNum, uint8_t value, uint32_t time) { return make(EVENT_CONTROL_CHANGE, channel, ccNum, value, 0, EVENT_FLAG_7BIT, time); }
+		static inline midiEvent_t programChange(uint8_t channel, uint8_t program, uint32_t time) { return make(EVENT_PROGRAM_CHANGE, channel, program, 0, 0, 0, time); }
+		static inline midiEvent_t pitchBend(uint8_t channel, uint16_t value14, uint32_t time) { return make(EVENT_PITCH_BEND, channel, 0, 0, value14 & 0x3FFF, 0, time); }
+
+		// True if a SysEx event ends the message (its last byte is F7)
+		static inline bool isSysexEnd(const midiEvent_t &event)
+		{
+			uint8_t last = event.channel == 1 ? event.index : event.channel == 2 ? event.data : (uint8_t)event.value;
+			return last == 0xF7;
+		}
+
+		static bool fromUsbMidi(uint32_t packet, uint32_t time, midiEvent_t &event); // Decodes a USB-MIDI event packet. Returns false for packets without an event (reserved CINs).
+	};
+
+	// Encodes events to USB-MIDI 1.0 event packets. Keeps the state of the 14-bit controller MSB/LSB protocol, so each sink needs an encoder of its own.
+	//
+	// According to MIDI 1.0 specs and MSB/LSB CC message pairs (assuming receiver cares about these things):
+	//  * MSB needs not be resent if only LSB is sent. Receiver should interpret it as a "fine adjustment".
+	//  * If MSB is sent ("coarse adjustment"), LSB will automatically be "reset" to 0 by receiver.
+	// So the MSB of a controller (0..31) is only sent when it has changed (or the controller was last sent on another channel), and the LSB always when EVENT_FLAG_LSB is set.
+	class Midi1Encoder
+	{
+	public:
+		static const int maxPackets = 2; // Highest number of packets per event (controller MSB + LSB)
+
+	private:
+		uint8_t m_prevCcMsb[32];	 // MSB last sent, per controller (0..31)...
+		uint8_t m_prevCcChannel[32]; // ... and the channel it was sent on (0xFF = none yet). Keeps the encoder small, since pumps copy it.
+
+	public:
+		Midi1Encoder();
+		int encode(const midiEvent_t &event, uint32_t *packets); // Returns the number of packets (0..maxPackets). 0 = nothing to send.
+	};
+
+}
+
+#endif /* PURE_MIDIEVENT_H */
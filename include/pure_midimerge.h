@@ -0,0 +1,101 @@
+#ifndef PURE_MIDIMERGE_H
+#define PURE_MIDIMERGE_H
+
+#include <Arduino.h>
+#include <CircularBuffer.h>
+
+#include <pure_midiqueue.h>
+#include <pure_timebase.h>
+
+namespace PurpleReign
+{
+
+	// Statistics per merge source, see MidiMerge::stats()
+	struct midiMergeStats_t
+	{
+		uint32_t received;		// Number of whole messages received (realtime messages not included)
+		uint32_t forwarded;		// Number of messages forwarded to the MidiQueue
+		uint32_t realtime;		// Number of realtime messages forwarded to the realtime lane
+		uint32_t clockDropped;	// Number of clock and transport messages (F8, FA, FB, FC) dropped, see setClockFilter()
+		uint32_t dropped;		// Number of messages dropped since the source buffer was full
+		uint32_t sysexDropped;	// Number of SysEx messages dropped since they were longer than maxMessagePackets, or aborted by a status byte
+		uint32_t maxWaitCycles; // Highest delay from reception to forwarding of a message
+	};
+
+	// Merges incoming MIDI streams (e.g. a controller chained to the DIN input, or USB-MIDI from the host) into the local output MidiQueue.
+	//
+	// Each source is parsed into whole messages in a buffer of its own: serial sources are parsed byte by byte (with running status), packet sources
+	// get USB-MIDI event packets (see receivePacket()). A SysEx message is only forwarded once it has been received completely, and then in one go,
+	// so it is never interleaved with other messages. Realtime messages bypass the buffers and are forwarded to the realtime lane of the MidiQueue at once.
+	// When the output has a clock of its own (e.g. MidiClock), the merged clock and transport messages are dropped (see setClockFilter()), so the receiver
+	// does not get two interleaved clock streams.
+	//
+	// Arbitration (process()):
+	//  * Local traffic (keybed, controllers) is pushed to the MidiQueue directly and always has priority: a message of a source is only forwarded while the
+	//    MidiQueue holds fewer than mergeLimit events (one per packet, counted over all outputs, see MidiQueue::fill()), including the message. A local note on is thus never queued behind more than
+	//    mergeLimit events of merged traffic, i.e. about (mergeLimit / MidiQueue::packetsPerBank) USB banks, whatever the input rate.
+	//  * The sources are served round-robin, each with a quota of packets per process() call, so a flooding source can not starve the others.
+	//  * Messages of a source are forwarded in order. When a source sends faster than it is forwarded, its buffer fills up and new messages are dropped (counted).
+	class MidiMerge
+	{
+	public:
+		static const int maxSources = 2;
+		static const int sourceBufferSize = 64;	 // Packets per source buffer
+		static const int maxMessagePackets = 32; // Longest message forwarded, in USB-MIDI packets (i.e. SysEx of up to 96 bytes). Also the lowest merge limit.
+		static const int defaultQuota = 8;		 // Packets per source per process() call
+		static const int serialByteBudget = 64;	 // Bytes read per serial source per process() call
+
+	private:
+		struct source_t
+		{
+			Stream *serial;											 // Serial byte stream, or nullptr for a packet source
+			int quota;												 // Packets forwarded per process() call
+			CircularBuffer<uint32_t, sourceBufferSize> packet;		 // USB-MIDI event packets of whole messages, followed by those of the SysEx being received
+			CircularBuffer<uint32_t, sourceBufferSize> arrivalTime; // Time stamp (Timebase::now32()) per packet, in the same order
+			int numCompletePackets;									 // Packets of whole messages, at the head of the buffer
+			int numSysexPackets;									 // Packets of the SysEx being received, at the tail of the buffer
+			bool skipSysex;											 // Dropping the rest of a SysEx message
+			uint8_t eventFlags;										 // EVENT_FLAG_* added to the forwarded events, see setSourceFlags()
+
+			// Serial parser state
+			uint8_t runningStatus; // 0 = none
+			uint8_t message[3];	   // Status and data bytes of the message being received (SysEx: up to three data bytes not yet packed)
+			int messageLength;	   // Bytes in message[]
+			int expectedLength;	   // Length of the current message, including the status byte
+			bool inSysex;
+
+			midiMergeStats_t stats;
+		};
+
+		MidiQueue *m_queue;
+		source_t m_source[maxSources];
+		int m_numSources;
+		int m_nextSource; // First source to serve at the next process() call
+		int m_mergeLimit;
+		bool m_clockFilter; // Drop merged clock and transport messages
+
+		void initSource(source_t &source, Stream *serial, int quota);
+		void appendPacket(source_t &source, uint32_t packet, uint32_t now);
+		void abortSysex(source_t &source);
+		void parseSerialByte(source_t &source, uint8_t midiByte, uint32_t now);
+		int headMessagePackets(source_t &source);
+		int forward(source_t &source, int quota);
+
+	public:
+		MidiMerge();
+		void init(MidiQueue *queue, int mergeLimit);
+		int addSerialSource(Stream *serial, int quota); // The stream must be opened (e.g. Serial.begin(31250)) by the caller. Returns the source number, -1 if there are too many sources.
+		int addPacketSource(int quota);					 // Source fed by receivePacket(). Returns the source number, -1 if there are too many sources.
+		void receivePacket(int source, uint32_t packet); // Appends a USB-MIDI event packet (e.g. from MidiCtrl's thru function) to a packet source
+		void setSourceFlags(int source, uint8_t flags);	 // EVENT_FLAG_* added to the events (realtime included) forwarded from a source, e.g. EVENT_FLAG_FROM_DIN
+		void process();									 // Reads the serial sources and forwards whole messages. Call from every loop() iteration.
+		void setMergeLimit(int mergeLimit);				 // Clamped to [maxMessagePackets..MidiQueue::queueSize]
+		void setClockFilter(bool drop) { m_clockFilter = drop; } // Drop the clock and transport messages (F8, FA, FB, FC) of all sources, e.g. when MidiClock drives the output
+		int mergeLimit() { return m_mergeLimit; }
+		const midiMergeStats_t &stats(int source) { return m_source[source].stats; }
+		void resetStats();
+	};
+
+}
+
+#endif /* PURE_MIDIMERGE_H */
@@ -1,15 +1,159 @@
 #ifndef PURE_MIDIQUEUE_H
 #define PURE_MIDIQUEUE_H
 
+#include <Arduino.h>
+
+#include <pure_metrics.h>
+#include <pure_midievent.h>
+#include <pure_ramfunc.h>
+#include <pure_timebase.h>
+
+// USB endpoint number of the MIDIUSB IN (device to host) endpoint. MIDIUSB plugs its endpoints in after the CDC (SerialUSB) endpoints 1..3, i.e. OUT = 4, IN = 5.
+#ifndef PURE_USB_MIDI_TX_ENDPOINT
+#define PURE_USB_MIDI_TX_ENDPOINT 5
+#endif
+
 namespace PurpleReign
 {
 
+	// Statistics of the USB output, see MidiQueue::stats()
+	struct midiQueueStats_t
+	{
+		uint32_t released;			// Number of events released
+		uint32_t missedDeadlines;	// Number of events released later than their deadline (capture time + latency) plus deadlineToleranceMicros
+		uint32_t maxLatenessCycles; // Highest lateness (release time - deadline) seen, in cycles
+
+		uint32_t realtimeReleased;		  // Number of realtime packets released
+		uint32_t realtimeDropped;		  // Number of realtime packets dropped since the realtime lane was full
+		uint32_t realtimeMinDelayCycles; // Lowest delay from capture (e.g. the clock timer interrupt) to USB write of a realtime packet
+		uint32_t realtimeMaxDelayCycles; // Highest delay from capture to USB write of a realtime packet. Max - min is the jitter added by the output path.
+	};
+
+	// Notes sounding, one bit per channel and key
+	struct soundingMap_t
+	{
+		uint32_t bits[16][4];
+	};
+
+	// Queue of MIDI events (see midiEvent_t), with an event driven send pump and several output sinks.
+	//
+	// Producers push compact, transport independent events. Each sink has a read position of its own in the queue and encodes the events when it takes them,
+	// at its own pace, so producers never format packets and a sink is added without touching them. An event is kept until every sink has taken it.
+	// When the queue is full, the oldest event is discarded, for the sinks that have not taken it yet (counted per sink).
+	//
+	// The USB sink is built in: pump() is called from every loop() iteration instead of from a periodic task. It returns after a single check when nothing is queued,
+	// so an idle keyboard spends (practically) no cycles on MIDI output. When there are events queued, it waits (without blocking) for the USB IN endpoint
+	// bank to become free, and then fills the whole bank at once (up to 16 packets) and releases it, so a busy keyboard refills the endpoint the moment it is free.
+	// Other sinks (see addSink()) are functions that take one event at a time, and return false when they can not take it yet (e.g. a full UART buffer).
+	// Events with EVENT_FLAG_USB_ONLY are skipped by them.
+	//
+	// System realtime messages (MIDI clock, start, stop, ...) have a lane of their own: pushRealtime() is interrupt safe, and every sink gets realtime events
+	// ahead of all other queued events, regardless of the constant latency mode.
+	//
+	// Overload policies: When the queue fills up, it sheds load in this order, so no note is left hanging on a receiver:
+	//  * Controller events (controller change, pitch bend, pressure) are not queued once fewer than noteReserve places are left.
+	//  * In a full queue, note ons are not queued, and neither are note offs of notes that are not sounding (their note on was not queued).
+	//  * Anything else (note offs of sounding notes, SysEx, ...) is queued by discarding the oldest event of the outputs that have not taken it yet.
+	// Every output (USB and each sink) keeps a map of the notes sounding on its receiver, next to the map of the notes that should be sounding.
+	// An output that lost events is resynced: it sends note offs for the notes that are sounding on its receiver but should not be (or
+	// All Notes Off, when there are more than allNotesOffThreshold of them on a channel), before it goes on with the queued events.
+	// An output that makes no progress for outputStallMicros while it has events to send (e.g. the host stopped polling the USB endpoint) is stalled:
+	// its backlog is dropped, so it no longer holds the queue full, and it is resynced once it takes events again. Nothing is retried forever.
+	// Each of these steps is counted in the midi.* metrics (see include/pure_metricnames.h): shed events, overflows, stalls, resyncs and the note offs they sent.
+	//
+	// Constant latency mode (optional, off by default): Every event is stamped with its capture time (e.g. the time stamp of the key switch transition), and is held back
+	// until capture time + a fixed latency. This trades minimum latency for a latency that does not depend on the scan phase, the queue depth nor the USB frame timing.
+	// The release gate is evaluated by pump(), i.e. once per loop() iteration, which is well below the USB frame period. Events that could not be released in time
+	// (e.g. since the latency is set too low, or the host did not poll the endpoint) are sent as soon as possible and counted in the statistics.
+	// In this mode push() inserts events by capture time (they are not pushed in that order, since keybed events are backdated), so the gate only checks the oldest event.
+	// Events for the same key or controller on a channel, and SysEx messages, keep their push order.
 	class MidiQueue
 	{
 	public:
+		static const int queueSize = 128;				   // Events. Must be a power of 2.
+		static const int usbBankSize = 64;				   // Bytes per USB full speed bulk endpoint bank
+		static const int packetsPerBank = usbBankSize / 4; // USB-MIDI event packets per bank
+		static const uint32_t deadlineToleranceMicros = 20; // Lateness that is not counted as a missed deadline (the release gate granularity is one loop() iteration)
+		static const int realtimeQueueSize = 8;				 // Must be a power of 2 (and below 256)
+		static const int maxSinks = 3;						 // Sinks besides USB
+		static const int sinkEventsPerPump = 16;			 // Highest number of events handed to a sink per pump()
+		static const int noteReserve = 32;					 // Places at the end of the queue that controller events never take
+		static const uint32_t outputStallMicros = 250000;	 // An output without progress for this long is stalled
+		static const int allNotesOffThreshold = 8;			 // A resync sends All Notes Off instead of more note offs than this, per channel
+
+	private:
+		struct sink_t
+		{
+			bool (*function)(const midiEvent_t &event);
+			uint32_t cursor;				 // Next event to take
+			volatile uint8_t realtimeCursor; // Next realtime event to take
+			uint32_t dropped;				 // Events discarded before the sink took them
+			soundingMap_t sounding;			 // Notes sounding on the receiver of the sink
+			bool resync;					 // Events were lost, resync before taking more
+			uint8_t resyncChannel;			 // Next channel to resync
+			uint32_t progressTime;			 // Last time the sink took an event, or had nothing to take
+		};
+
+		midiEvent_t m_event[queueSize];
+		uint32_t m_head;	   // Next event to write (free running, the index is m_head & (queueSize - 1))
+		uint32_t m_usbCursor;  // Next event to send over USB
+		uint32_t m_usbDropped; // Events discarded before they were sent over USB
+		Midi1Encoder m_usbEncoder;
+		soundingMap_t m_usbSounding; // Notes sounding on the USB receiver (the host)
+		bool m_usbResync;
+		uint8_t m_usbResyncChannel;
+		bool m_usbStalled;
+		uint32_t m_usbProgressTime;
+		soundingMap_t m_sounding; // Notes that should be sounding, i.e. of the events queued so far
+		sink_t m_sink[maxSinks];
+		int m_numSinks;
+		uint32_t m_latencyCycles; // Fixed output latency. 0 = constant latency mode off, send as soon as possible.
+		midiQueueStats_t m_stats;
+
+		uint8_t m_realtimeStatus[realtimeQueueSize];
+		uint32_t m_realtimeCaptureTime[realtimeQueueSize];
+		uint8_t m_realtimeFlags[realtimeQueueSize]; // EVENT_FLAG_*, handed to the sinks with the event
+		volatile uint8_t m_realtimeHead; // Written by pushRealtime() (with interrupts disabled, since there can be several producers)
+		volatile uint8_t m_realtimeTail; // Next realtime event to send over USB. Written by pump() only.
+
+		inline bool isUsbTxReady();
+		inline bool isReleased(const midiEvent_t &event, uint32_t now) { return m_latencyCycles == 0 || (int32_t)(now - (event.time + m_latencyCycles)) >= 0; }
+		inline void skipEvent(uint32_t &cursor);
+		uint32_t oldestCursor();
+		uint32_t newestCursor();
+		void discardOldest();
+		static void clearSounding(soundingMap_t &map);
+		static inline bool isSounding(const soundingMap_t &map, uint8_t channel, uint8_t key) { return (map.bits[channel & 0x0F][(key >> 5) & 0x03] >> (key & 0x1F)) & 1; }
+		static void trackNotes(soundingMap_t &map, const midiEvent_t &event);
+		int resyncEvents(const soundingMap_t &map, uint8_t channel, midiEvent_t *events, uint32_t now); // The events resyncing one channel of an output (up to allNotesOffThreshold)
+		void commitResync(soundingMap_t &map, uint8_t channel);
+		void stallUsb();
+		void pumpUsb(uint32_t now);
+		void pumpSink(sink_t &sink, uint32_t now);
+
+	public:
+		MidiQueue();
 		int init();
+		void push(const midiEvent_t &event); // Enqueue an event, see the overload policies. Realtime events go to the realtime lane.
+		bool pushRealtime(uint8_t status, uint32_t captureTime, uint8_t flags = 0); // Enqueue a system realtime message (0xF8..0xFF). Interrupt safe. Returns false if the realtime lane is full.
+		bool pushSysex(const uint8_t *message, int length, uint8_t flags, uint32_t captureTime); // Enqueue a whole SysEx message (F0 .. F7) as EVENT_SYSEX pieces with the given flags (e.g. EVENT_FLAG_USB_ONLY). Returns false, and enqueues nothing, if it would take the note reserve.
+		int addSink(bool (*function)(const midiEvent_t &event)); // Adds an output sink, which gets the events pushed from then on. Returns the sink number, -1 if there are too many sinks.
+		uint32_t sinkDropped(int sink) { return m_sink[sink].dropped; }
+		uint32_t usbDropped() { return m_usbDropped; }
+		bool isUsbStalled() { return m_usbStalled; }
+		bool isSounding(uint8_t channel, uint8_t key) { return isSounding(m_sounding, channel, key); }
+
+		bool isEmpty();
+		int size() { return m_head - m_usbCursor; } // Number of events not yet sent over USB, realtime lane not included
+		int fill() { return m_head - oldestCursor(); } // Number of events not yet taken by every output (USB and the sinks), the fill level the overload policies act on
+		PURE_HOT_FUNC void pump(); // Sends as many queued (and released) events as fit in a free USB endpoint bank, and hands events to the other sinks. Call from every loop() iteration.
+
+		void setConstantLatency(uint32_t latencyMicros); // 0 turns constant latency mode off. Must be below ~51 s.
+		uint32_t constantLatency() { return Timebase::cyclesToMicros32(m_latencyCycles); }
+		const midiQueueStats_t &stats() { return m_stats; }
+		void resetStats();
 	};
 
 }
 
-#endif /* PURE_MIDIQUEUE_H */
\ No newline at end of file
+#endif /* PURE_MIDIQUEUE_H */
@@ -0,0 +1,40 @@
+#ifndef PURE_MIDISERIALOUT_H
+#define PURE_MIDISERIALOUT_H
+
+#include <Arduino.h>
+
+#include <pure_midievent.h>
+
+namespace PurpleReign
+{
+
+	// MIDI 1.0 byte stream output sink (DIN MIDI on a UART), see MidiQueue::addSink().
+	//
+	// Events are encoded with a Midi1Encoder of its own and sent with running status: the status byte of a channel voice message is left out when it
+	// equals the previous one. System common messages and SysEx cancel running status, realtime messages leave it as it is (as the receiver does).
+	// An event is only accepted when the whole of it fits in the UART transmit buffer, so send() never blocks.
+	class MidiSerialOut
+	{
+	public:
+		static const int maxEventBytes = Midi1Encoder::maxPackets * 3; // Controller MSB + LSB messages, without running status
+
+	private:
+		HardwareSerial *m_serial;
+		Midi1Encoder m_encoder;
+		uint8_t m_runningStatus; // 0 = none
+		uint32_t m_bytesSent;
+		uint32_t m_bytesSaved; // Status bytes left out thanks to running status
+
+		void writePacket(uint32_t packet);
+
+	public:
+		MidiSerialOut();
+		void init(HardwareSerial *serial); // The port must be opened (e.g. Serial.begin(31250)) by the caller
+		bool send(const midiEvent_t &event); // Returns false (and leaves the event to be offered again) if the transmit buffer has no room for it
+		uint32_t bytesSent() { return m_bytesSent; }
+		uint32_t bytesSaved() { return m_bytesSaved; }
+	};
+
+}
+
+#endif /* PURE_MIDISERIALOUT_H */
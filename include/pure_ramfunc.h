@@ -0,0 +1,29 @@
+#ifndef PURE_RAMFUNC_H
+#define PURE_RAMFUNC_H
+
+//////////////////////////////////////////////////////////////////////////////////////
+//
+// RAM resident hot path (opt-in)
+//
+// The SAM3X executes from flash with wait states at 84 MHz, so the timing of flash resident code depends on the flash prefetch buffer.
+// If PURE_RAM_HOT_PATH is defined (see the "due_ramhotpath" environment in platformio.ini), functions marked PURE_HOT_FUNC and tables marked PURE_HOT_DATA
+// are placed in .ramfunc.* sections. The Due linker script collects .ramfunc.* into the .relocate output section, which the startup code copies from flash to SRAM
+// before main() is called. Thus no changes to the linker script nor to the startup code are needed.
+//
+// Code and data use different section names, since GCC does not allow code and (read only) data in the same section.
+// Calls between SRAM and flash are out of range for a direct branch; the linker inserts long branch veneers, and PURE_HOT_FUNC functions are long_call for their callers.
+//
+// tools/ramfunc_report.py prints a report of what landed in SRAM after each build of the "due_ramhotpath" environment, and flags calls from SRAM into flash
+// (e.g. to soft-float helpers), so keep PURE_HOT_FUNC code to integer arithmetic.
+//
+//////////////////////////////////////////////////////////////////////////////////////
+
+#ifdef PURE_RAM_HOT_PATH
+#define PURE_HOT_FUNC __attribute__((section(".ramfunc.pure_func"), noinline, long_call))
+#define PURE_HOT_DATA __attribute__((section(".ramfunc.pure_data")))
+#else
+#define PURE_HOT_FUNC
+#define PURE_HOT_DATA
+#endif
+
+#endif /* PURE_RAMFUNC_H */
@@ -0,0 +1,72 @@
+#ifndef PURE_SCOPEPINS_H
+#define PURE_SCOPEPINS_H
+
+#include <Arduino.h>
+
+//
+// toggle pins for observability
+//
+
+#define REG_PIO_PIN_52_SODR REG_PIOB_SODR
+#define REG_PIO_PIN_52_CODR REG_PIOB_CODR
+#define REG_PIO_PIN_53_SODR REG_PIOB_SODR
+#define REG_PIO_PIN_53_CODR REG_PIOB_CODR
+#define PIN_52_BITMASK ((uint32_t)1 << 21)
+#define PIN_53_BITMASK ((uint32_t)1 << 14)
+
+#define SET_PIN_52                            \
+	{                                         \
+		REG_PIO_PIN_52_SODR = PIN_52_BITMASK; \
+	}
+#define CLR_PIN_52                            \
+	{                                         \
+		REG_PIO_PIN_52_CODR = PIN_52_BITMASK; \
+	}
+#define SET_PIN_53                            \
+	{                                         \
+		REG_PIO_PIN_53_SODR = PIN_53_BITMASK; \
+	}
+#define CLR_PIN_53                            \
+	{                                         \
+		REG_PIO_PIN_53_CODR = PIN_53_BITMASK; \
+	}
+
+inline void initPinB()
+{
+	pinMode(52, OUTPUT);
+}
+
+inline void togglePinB()
+{
+	static bool toggle = false;
+	if (toggle)
+	{
+		SET_PIN_52 // digitalWrite(52,HIGH);
+	}
+	else
+	{
+		CLR_PIN_52 // digitalWrite(52,LOW);
+	}
+	toggle = !toggle;
+}
+
+inline void initPinA()
+{
+	pinMode(53, OUTPUT);
+}
+
+inline void togglePinA()
+{
+	static bool toggle = false;
+	if (toggle)
+	{
+		SET_PIN_53 // digitalWrite(53,HIGH);
+	}
+	else
+	{
+		CLR_PIN_53 // digitalWrite(53,LOW);
+	}
+	toggle = !toggle;
+}
+
+#endif /* PURE_SCOPEPINS_H */
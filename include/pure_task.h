@@ -3,15 +3,20 @@
 
 #include <Arduino.h>
 
+#include <pure_metrics.h>
+#include <pure_ramfunc.h>
+#include <pure_timebase.h>
+
 namespace PurpleReign
 {
 
 	class Task
 	{
 	private:
-		unsigned long m_periodInMicros;
-		unsigned long m_nextTickInMicros;
+		uint32_t m_periodInCycles;
+		cycles_t m_nextTickInCycles;
 		void (*m_function)();
+		int m_overrunMetric; // metricId_t counting the missed ticks, -1 = none
 
 	public:
 		// static void updateTime();
@@ -20,9 +25,11 @@ namespace PurpleReign
 		void init();
 		void setFunction(void (*function)());
 		void setPeriod(unsigned long periodInMicros);
-		void schedule(); // Schedules based on actual time of method invocation. Calling schedule() will recalculate the current time for each invocation.
+		void setOverrunMetric(metricId_t metric) { m_overrunMetric = metric; } // Counts the missed ticks (overruns) of the task in the given metric
+		PURE_HOT_FUNC void schedule();			   // Schedules based on actual time of method invocation. Calling schedule() will read the current time for each invocation.
+		PURE_HOT_FUNC void schedule(cycles_t now); // Schedules based on the given current time (see Timebase::now()). Lets loop() read the time once for all tasks.
 	};
 
 }
 
-#endif /* PURE_TASK_H */
\ No newline at end of file
+#endif /* PURE_TASK_H */
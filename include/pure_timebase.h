@@ -0,0 +1,75 @@
+#ifndef PURE_TIMEBASE_H
+#define PURE_TIMEBASE_H
+
+// #define PURE_VIRTUAL_CLOCK // Replace the DWT cycle counter by a virtual clock, only advanced by Timebase::setVirtualNow()/advanceVirtualNow(). For testing timing code (e.g. on a host).
+
+#ifdef PURE_VIRTUAL_CLOCK
+#include <stdint.h> // No Arduino dependency, so the timing code builds on a host (env:native)
+#define PURE_TIMEBASE_MCK 84000000UL // The Due's VARIANT_MCK, so cycle counts match the target
+#else
+#include <Arduino.h>
+#define PURE_TIMEBASE_MCK VARIANT_MCK
+#endif
+
+namespace PurpleReign
+{
+
+	typedef uint64_t cycles_t; // Time stamp or duration in CPU (master clock) cycles
+
+	// The single time source of the firmware, built on the Cortex-M3 DWT cycle counter (CYCCNT).
+	//
+	// Reading CYCCNT is a single load; unlike micros() it neither masks interrupts nor reads SysTick, and it resolves one CPU cycle (~12 ns at 84 MHz).
+	// CYCCNT is 32 bits and wraps every 2^32 / 84 MHz = ~51 s. now() extends it to 64 bits by counting wraps, which requires now() to be called at least once per wrap period.
+	// Since now() is called from every Task::schedule(), this is always true while loop() runs.
+	//
+	// now() updates the wrap state and is therefore NOT interrupt safe; ISRs must use now32(). 32-bit time stamps are fine for durations below ~51 s (compute with unsigned subtraction).
+	class Timebase
+	{
+	private:
+		static uint32_t s_lastCycles32; // CYCCNT at the previous now() call
+		static uint32_t s_wraps;		// Number of CYCCNT wraps, the upper 32 bits of now()
+#ifdef PURE_VIRTUAL_CLOCK
+		static cycles_t s_virtualNow;
+#endif
+
+	public:
+		static const uint32_t cyclesPerMicro = PURE_TIMEBASE_MCK / 1000000;
+
+		static void init(); // Enables the cycle counter. Call once, first thing in setup().
+
+		// Raw 32-bit cycle counter, wraps every ~51 s. Interrupt safe.
+		static inline uint32_t now32()
+		{
+#ifdef PURE_VIRTUAL_CLOCK
+			return (uint32_t)s_virtualNow;
+#else
+			return DWT->CYCCNT;
+#endif
+		}
+
+		// 64-bit cycle counter, never wraps in practice. Not interrupt safe.
+		static inline cycles_t now()
+		{
+			uint32_t cycles32 = now32();
+			if (cycles32 < s_lastCycles32)
+				s_wraps++; // CYCCNT wrapped since the previous call
+			s_lastCycles32 = cycles32;
+			return (((cycles_t)s_wraps) << 32) | cycles32;
+		}
+
+		static inline uint32_t nowMicros() { return (uint32_t)(now() / cyclesPerMicro); } // Like micros(), wraps every ~71 minutes
+
+		static inline uint32_t microsToCycles32(uint32_t micros) { return micros * cyclesPerMicro; } // micros must be below ~51 s
+		static inline cycles_t microsToCycles(uint32_t micros) { return ((cycles_t)micros) * cyclesPerMicro; }
+		static inline uint32_t cyclesToMicros32(uint32_t cycles) { return cycles / cyclesPerMicro; }
+		static inline cycles_t cyclesToMicros(cycles_t cycles) { return cycles / cyclesPerMicro; } // 64-bit division, avoid in hot paths
+
+#ifdef PURE_VIRTUAL_CLOCK
+		static void setVirtualNow(cycles_t now);
+		static void advanceVirtualNow(cycles_t cycles);
+#endif
+	};
+
+}
+
+#endif /* PURE_TIMEBASE_H */
@@ -0,0 +1,120 @@
+#ifndef PURE_UMP_H
+#define PURE_UMP_H
+
+#include <stdint.h>
+
+namespace PurpleReign
+{
+
+	// Encoders for MIDI 2.0 Universal MIDI Packets (UMP), the packet format of the USB MIDI 2.0 alternate setting.
+	// The USB stack only has the USB-MIDI 1.0 interface, so nothing is sent as UMP yet; the firmware uses scaleUp() for the high resolution (e.g. 16-bit velocity) event values.
+	//
+	// MIDI 2.0 channel voice messages (message type 4) are 64 bits, i.e. two 32-bit words, and carry 16-bit velocities and 32-bit controller, pressure and pitch bend values.
+	// A 14-bit controller change is thus one 64-bit packet instead of two (MSB + LSB) USB-MIDI 1.0 packets. Lower resolution values are scaled up with the
+	// MIDI 2.0 "min-center-max" bit repeat scheme, so 0, the center value and the max value map exactly.
+	//
+	// Words are to be sent in order, word 0 first. All messages are sent on one group (0..15), the UMP equivalent of a USB-MIDI cable.
+	class Ump
+	{
+	public:
+		static const uint32_t typeSystem = 0x1;		// System common and realtime, 32 bits
+		static const uint32_t typeMidi1Voice = 0x2; // MIDI 1.0 channel voice, 32 bits
+		static const uint32_t typeData64 = 0x3;		// 7-bit SysEx, 64 bits
+		static const uint32_t typeMidi2Voice = 0x4; // MIDI 2.0 channel voice, 64 bits
+
+		// Number of 32-bit words of a message, from its first word
+		static inline int messageWords(uint32_t word0)
+		{
+			static const uint8_t words[16] = {1, 1, 1, 2, 2, 4, 1, 1, 2, 2, 2, 3, 3, 4, 4, 4};
+			return words[word0 >> 28];
+		}
+
+		// Scales an unsigned value from srcBits to dstBits (dstBits > srcBits, dstBits <= 32), see the MIDI 2.0 specification, "Min-Center-Max Upscaling"
+		static inline uint32_t scaleUp(uint32_t value, int srcBits, int dstBits)
+		{
+			int scaleBits = dstBits - srcBits;
+			uint32_t shifted = value << scaleBits;
+			if (value <= (1u << (srcBits - 1)))
+				return shifted; // At or below the center: plain shift
+			int repeatBits = srcBits - 1;
+			uint32_t repeat = value & ((1u << repeatBits) - 1);
+			if (scaleBits > repeatBits)
+				repeat <<= scaleBits - repeatBits;
+			else
+				repeat >>= repeatBits - scaleBits;
+			while (repeat != 0)
+			{
+				shifted |= repeat;
+				repeat >>= repeatBits;
+			}
+			return shifted;
+		}
+
+		static inline uint32_t midi2Word0(uint8_t group, uint8_t status, uint8_t channel, uint8_t index, uint8_t extra)
+		{
+			return (typeMidi2Voice << 28) | ((uint32_t)(group & 0x0F) << 24) | ((uint32_t)(status | (channel & 0x0F)) << 16) | ((uint32_t)index << 8) | extra;
+		}
+
+		// MIDI 2.0 channel voice messages. Each writes two words.
+		static inline void noteOn(uint32_t *words, uint8_t group, uint8_t channel, uint8_t note, uint16_t velocity)
+		{
+			words[0] = midi2Word0(group, 0x90, channel, note & 0x7F, 0); // No attribute
+			words[1] = (uint32_t)velocity << 16;
+		}
+		static inline void noteOff(uint32_t *words, uint8_t group, uint8_t channel, uint8_t note, uint16_t velocity)
+		{
+			words[0] = midi2Word0(group, 0x80, channel, note & 0x7F, 0);
+			words[1] = (uint32_t)velocity << 16;
+		}
+		static inline void controlChange(uint32_t *words, uint8_t group, uint8_t channel, uint8_t ccNum, uint32_t value)
+		{
+			words[0] = midi2Word0(group, 0xB0, channel, ccNum & 0x7F, 0);
+			words[1] = value;
+		}
+		static inline void polyPressure(uint32_t *words, uint8_t group, uint8_t channel, uint8_t note, uint32_t value)
+		{
+			words[0] = midi2Word0(group, 0xA0, channel, note & 0x7F, 0);
+			words[1] = value;
+		}
+		static inline void pitchBend(uint32_t *words, uint8_t group, uint8_t channel, uint32_t value)
+		{
+			words[0] = midi2Word0(group, 0xE0, channel, 0, 0);
+			words[1] = value;
+		}
+
+		static inline void programChange(uint32_t *words, uint8_t group, uint8_t channel, uint8_t program)
+		{
+			words[0] = midi2Word0(group, 0xC0, channel, 0, 0); // No bank select
+			words[1] = (uint32_t)(program & 0x7F) << 24;
+		}
+		static inline void channelPressure(uint32_t *words, uint8_t group, uint8_t channel, uint32_t value)
+		{
+			words[0] = midi2Word0(group, 0xD0, channel, 0, 0);
+			words[1] = value;
+		}
+
+		// 32-bit messages: MIDI 1.0 channel voice (status including the channel) and system common and realtime messages
+		static inline uint32_t midi1Voice(uint8_t group, uint8_t status, uint8_t data1, uint8_t data2)
+		{
+			return (typeMidi1Voice << 28) | ((uint32_t)(group & 0x0F) << 24) | ((uint32_t)status << 16) | ((uint32_t)data1 << 8) | data2;
+		}
+		static inline uint32_t system(uint8_t group, uint8_t status, uint8_t data1, uint8_t data2)
+		{
+			return (typeSystem << 28) | ((uint32_t)(group & 0x0F) << 24) | ((uint32_t)status << 16) | ((uint32_t)data1 << 8) | data2;
+		}
+
+		// 7-bit SysEx (64 bits) of up to 6 data bytes, F0 and F7 excluded. start and end tell whether the packet starts and/or ends the message.
+		static inline void sysex7(uint32_t *words, uint8_t group, const uint8_t *data, int numBytes, bool start, bool end)
+		{
+			uint32_t status = start ? (end ? 0x0 : 0x1) : (end ? 0x3 : 0x2); // Complete, start, end or continue
+			uint8_t bytes[6] = {0, 0, 0, 0, 0, 0};
+			for (int ix = 0; ix < numBytes && ix < 6; ix++)
+				bytes[ix] = data[ix];
+			words[0] = (typeData64 << 28) | ((uint32_t)(group & 0x0F) << 24) | (status << 20) | ((uint32_t)numBytes << 16) | ((uint32_t)bytes[0] << 8) | bytes[1];
+			words[1] = ((uint32_t)bytes[2] << 24) | ((uint32_t)bytes[3] << 16) | ((uint32_t)bytes[4] << 8) | bytes[5];
+		}
+	};
+
+}
+
+#endif /* PURE_UMP_H */
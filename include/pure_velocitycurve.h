@@ -0,0 +1,91 @@
+#ifndef PURE_VELOCITYCURVE_H
+#define PURE_VELOCITYCURVE_H
+
+#include <stdint.h>
+
+// #define VELOCITY_CURVE_INTERPOLATE // Use the coarse curve tables (1/8 of full size) and interpolate linearly between their points, instead of using the full resolution tables.
+
+namespace PurpleReign
+{
+
+	// Velocity curve types. The order must match the curve order in tools/gen_velocity_curves.py (which generates src/pure_velocitycurve_tables.cpp).
+	enum velocityCurveType_t
+	{
+		LIN_STD, // Linear, 127 -> 1 over the full stopwatch range
+		LIN_1,	 // Linear, 127 -> 1 over half the stopwatch range
+		LIN_2,	 // Linear, 127 -> 1 over a quarter of the stopwatch range
+		LOG_STD, // Logarithmic (concave), mild
+		LOG_1,	 // Logarithmic (concave), medium
+		LOG_2,	 // Logarithmic (concave), strong
+		EXP_8,	 // Exponential (convex), base 126*8
+		NUM_VELOCITY_CURVES
+	};
+
+	const int velocityStopWatchMaxValue = 1000;								 // Note that lowest value is 0
+	const int sizeVelocityStopWatchMaxValue = velocityStopWatchMaxValue + 1; // size is one larger than max value
+	const unsigned long velocityStopWatchTickMicros = 250;					 // Time of one stopwatch tick
+
+	const int velocityCurveCoarseShift = 3;															// log2 of the number of stopwatch values between two points in a coarse curve table
+	const int velocityCurveCoarseStep = 1 << velocityCurveCoarseShift;								// Number of stopwatch values between two points in a coarse curve table
+	const int sizeVelocityCurveCoarse = (velocityStopWatchMaxValue >> velocityCurveCoarseShift) + 1; // Number of points in a coarse curve table
+
+	// The generated, const (and thus flash resident) curve banks. Only one of them is compiled in, depending on VELOCITY_CURVE_INTERPOLATE.
+#ifdef VELOCITY_CURVE_INTERPOLATE
+	extern const uint8_t velocityCurveBankCoarse[NUM_VELOCITY_CURVES][sizeVelocityCurveCoarse];
+#else
+	extern const uint8_t velocityCurveBank[NUM_VELOCITY_CURVES][sizeVelocityStopWatchMaxValue];
+#endif
+	extern const uint16_t velocityCurveBank16[NUM_VELOCITY_CURVES][sizeVelocityCurveCoarse]; // 16-bit (MIDI 2.0) velocities, always compiled in
+
+	const int velocityStopWatchFracBits = 8; // Fraction bits of a fixed point stopwatch value, see VelocityCurve::velocity16()
+
+	// Maps a key velocity stopwatch value to a MIDI velocity, using one of the curves in the flash resident curve bank.
+	// Selecting another curve only swaps a pointer, so it is cheap enough to do at any time (also from within the scan loop).
+	class VelocityCurve
+	{
+	private:
+		const uint8_t *m_map;
+		const uint16_t *m_map16;
+		int m_curveType;
+
+	public:
+		VelocityCurve();
+		VelocityCurve(int curveType);
+		void select(int curveType); // Select curve (velocityCurveType_t). Out of range types are ignored.
+		int curveType();
+#ifndef PURE_VIRTUAL_CLOCK
+		void dump(); // Prints the curve to SerialUSB (not in host builds)
+#endif
+
+		// stopwatch must be in the range [0..velocityStopWatchMaxValue]
+		inline uint8_t velocity(int stopwatch) const
+		{
+#ifdef VELOCITY_CURVE_INTERPOLATE
+			const uint8_t *map = m_map; // Read the curve pointer once, so a concurrent select() cannot mix two curves
+			int ix = stopwatch >> velocityCurveCoarseShift;
+			int frac = stopwatch & (velocityCurveCoarseStep - 1);
+			if (frac == 0)
+				return map[ix]; // Exactly on a table point (also covers the last point, which has no successor)
+			return map[ix] + (((map[ix + 1] - map[ix]) * frac) / velocityCurveCoarseStep);
+#else
+			return m_map[stopwatch];
+#endif
+		}
+
+		// 16-bit velocity (1..65535) of a fixed point stopwatch value with velocityStopWatchFracBits fraction bits, in the range [0..velocityStopWatchMaxValue << velocityStopWatchFracBits].
+		// The fraction gives a finer velocity than the 7-bit velocity() can resolve; it is interpolated between the points of the (coarse) 16-bit curve table.
+		inline uint16_t velocity16(uint32_t stopwatchFrac) const
+		{
+			const uint16_t *map = m_map16;
+			const int fracBits = velocityCurveCoarseShift + velocityStopWatchFracBits;
+			uint32_t ix = stopwatchFrac >> fracBits;
+			int32_t frac = stopwatchFrac & ((1 << fracBits) - 1);
+			if (frac == 0)
+				return map[ix];
+			return map[ix] + (((int32_t)map[ix + 1] - (int32_t)map[ix]) * frac) / (1 << fracBits);
+		}
+	};
+
+}
+
+#endif /* PURE_VELOCITYCURVE_H */
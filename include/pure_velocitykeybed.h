@@ -1,15 +1,142 @@
 #ifndef PURE_VELOCITYKEYBED_H
 #define PURE_VELOCITYKEYBED_H
 
+#include <Arduino.h>
+
+#include <pure_keybedgeometry.h>
+#include <pure_ramfunc.h>
+#include <pure_timebase.h>
+#include <pure_velocitycurve.h>
+
+#define ENABLE_KEY_DEBOUNCE
+#define ENABLE_GLITCH_REJECTION
+#define ENABLE_CHATTER_STATS // Requires ENABLE_KEY_DEBOUNCE
+
 namespace PurpleReign
 {
 
+	const unsigned long keybedDriveLineSettleMicros = 1; // Settle time after switching drive line, when a scan can not pipeline the switch with processing of the previous drive line
+	const int keybedAutoTuneMinClosures = 8;			 // Min number of closures of a switch before its mute time is auto-tuned
+	const int keybedGlitchMaxTransitions = 3;			 // Max number of switch transitions on one drive line between two scans that is accepted without confirmation
+
+	// Chatter statistics of a switch. Bounces are the state changes seen (and ignored) while the switch is muted after a closure.
+	struct switchChatterStats_t
+	{
+		uint16_t closures;		  // Number of closures (that started a mute)
+		uint16_t bounces;		  // Number of bounces
+		uint32_t maxBounceCycles; // Longest time from a closure to its last bounce. Bounces are only seen during the mute, so this is at most the mute time.
+	};
+
+	struct keybedGlitchStats_t
+	{
+		uint32_t rejected;	// Number of drive line reads rejected as glitches (implausible number of transitions, not confirmed by the next scan)
+		uint32_t confirmed; // Number of drive line reads with an implausible number of transitions, confirmed by the next scan (and thus accepted)
+	};
+
+	// Velocity sensitive keybed scan engine for a two-switch-per-key (MK/BK) matrix, parameterized by a KeybedGeometry (see pure_keybedgeometry.h).
+	//
+	// Velocity is measured by a per-key stopwatch, started when the BK (top) switch closes and stopped when the MK (bottom) switch closes.
+	// The stopwatch value is mapped to a MIDI velocity by the selected VelocityCurve.
+	// Notes are reported through the note-on/note-off functions as key addresses (see KeybedGeometry::keyAddress()), leaving note numbers and channels to the caller.
+	//
+	// Adaptive scanning: scan() scans the full matrix and is meant to be called at a (slow) background rate. scanInFlight() rescans only the drive lines of rows
+	// having keys "in flight" (a started stopwatch or an active switch mute) and is meant to be called at a much higher rate. Since rows are then scanned at different rates,
+	// stopwatches and mute timers are based on (32-bit cycle counter) time stamps instead of on scan counts. Switch transitions are time stamped in the middle of the interval since the previous scan of
+	// the same drive line, which halves the expected timing error of transitions detected at the background rate (i.e. BK closures of idle rows).
+	//
+	// Glitch rejection (ENABLE_GLITCH_REJECTION): A glitch on the column bus flips many bits of a column port read at once, which per-switch debouncing can not tell from playing.
+	// So each read is compared to the accepted column bits of its drive line as a whole first. If more than keybedGlitchMaxTransitions switches changed, the read is held back
+	// (the row is kept in flight, so it is rescanned at the in-flight rate) and only accepted if the next scan of the drive line reads the same bits. Otherwise it is discarded as a glitch.
+	// The common case (no change at all) costs a single compare per drive line.
+	template <class Geometry>
 	class VelocityKeybed
 	{
 	public:
-		int init();
+		typedef Geometry geometry_t;
+
+		static const int MK = 0, BK = 1;			 // Make or Break switch index numbering
+		static const int RELEASED = 0, PRESSED = 1; // Key states
+
+	private:
+		struct rowMkbk_t
+		{
+			uint8_t row;
+			uint8_t mkbk;
+		};
+
+		rowMkbk_t m_driveLineSeq[Geometry::numDriveLines]; // <Row,Mkbk> tuple per drive line, in drive line order (Mkbk is the innermost loop)
+		uint8_t m_allDriveLines[Geometry::numDriveLines];	// All drive lines, in drive line order (a full scan)
+
+		uint8_t m_keyState[Geometry::numKeySlots];							  // RELEASED or PRESSED, per key
+		uint8_t m_keyVelocityStopwatchRunning[Geometry::numKeySlots];			  // Stopwatch started (at BK closure) and not yet stopped (at MK closure or BK reopening), per key
+		uint32_t m_keyVelocityStopwatchStart[Geometry::numKeySlots];			  // Time stamp (Timebase::now32()) of stopwatch start, per key
+		uint8_t m_switchMuted[Geometry::numSwitches][Geometry::numKeySlots];		  // Switch is muted (state changes are ignored), per switch
+		uint32_t m_switchMuteEnd[Geometry::numSwitches][Geometry::numKeySlots];	  // Time stamp (Timebase::now32()) when the mute ends, per switch
+		uint8_t m_switchState[Geometry::numSwitches][Geometry::numKeySlots];		  // Switch state (HIGH = open, LOW = closed) from previous scan, per switch
+		uint32_t m_switchMuteCycles[Geometry::numSwitches];						  // Mute time after a switch transition, per switch type (MK/BK)
+#ifdef ENABLE_CHATTER_STATS
+		uint32_t m_switchMuteCyclesPerSwitch[Geometry::numSwitches][Geometry::numKeySlots]; // Mute time after a switch transition, per switch (auto-tuned, or the per type mute time)
+		switchChatterStats_t m_chatterStats[Geometry::numSwitches][Geometry::numKeySlots];
+#endif
+
+		uint32_t m_driveLineScanTime[Geometry::numDriveLines]; // Time stamp (Timebase::now32()) of the latest scan, per drive line
+		uint32_t m_rowInFlightBM;									 // Bit Matrix with one bit per row, set if the row has any key in flight
+
+#ifdef ENABLE_GLITCH_REJECTION
+		uint32_t m_driveLineColBM[Geometry::numDriveLines];	   // Accepted (packed) column bits, per drive line
+		uint32_t m_driveLinePendingColBM[Geometry::numDriveLines]; // Column bits with an implausible number of transitions, awaiting confirmation by the next scan, per drive line
+		uint32_t m_driveLinePendingTime[Geometry::numDriveLines];  // Transition time of the pending column bits, per drive line
+		uint32_t m_driveLinePendingBM;							   // Bit Matrix with one bit per drive line, set if the drive line has pending column bits
+		keybedGlitchStats_t m_glitchStats;
+#endif
+
+		uint32_t m_eventTime;	   // Time stamp (Timebase::now32()) of the switch transition that triggered the current note on/off callback
+		uint32_t m_eventStopwatch; // Unrounded stopwatch value of the current note on, with velocityStopWatchFracBits fraction bits
+
+		uint32_t m_rowPortBitPattern; // Remember the row port bit pattern from previous lap in the current scan loop (or, if current lap is the first; from the last lap in the previous scan loop)
+
+		const VelocityCurve *m_velocityCurve;
+		void (*m_noteOnFunction)(int keyAddress, uint8_t velocity);
+		void (*m_noteOffFunction)(int keyAddress);
+
+		inline uint32_t switchMuteCycles(int mkbk, int key)
+		{
+#ifdef ENABLE_CHATTER_STATS
+			return m_switchMuteCyclesPerSwitch[mkbk][key];
+#else
+			return m_switchMuteCycles[mkbk];
+#endif
+		}
+		inline bool scanSwitch(int con, int row, int mkbk, int col, int keySwitch, uint32_t now, uint32_t transitionTime);
+		PURE_HOT_FUNC void scanDriveLines(const uint8_t *driveLines, int numLines);
+
+	public:
+		VelocityKeybed();
+		void init(); // Configures the row and column ports and enables the first drive line. Call once before the first scan().
+		void setVelocityCurve(const VelocityCurve *velocityCurve);
+		void setNoteOnFunction(void (*function)(int keyAddress, uint8_t velocity));
+		void setNoteOffFunction(void (*function)(int keyAddress));
+		void setSwitchMuteTime(int mkbk, unsigned long muteMicros); // Sets the mute time of all switches of the type (MK/BK). Overrides any auto-tuned mute times.
+#ifdef ENABLE_CHATTER_STATS
+		const switchChatterStats_t &chatterStats(int mkbk, int keyAddress) { return m_chatterStats[mkbk][keyAddress]; }
+		unsigned long switchMuteTime(int mkbk, int keyAddress) { return Timebase::cyclesToMicros32(m_switchMuteCyclesPerSwitch[mkbk][keyAddress]); }
+		void resetChatterStats();
+		int autoTuneSwitchMuteTimes(unsigned long minMuteMicros, unsigned long maxMuteMicros); // Derives per switch mute times from the chatter statistics. Returns the number of switches tuned.
+#endif
+		uint64_t packSwitchStates(); // Packs (up to) the first 64 switches into 64 bits, for logging
+		PURE_HOT_FUNC void scan();		 // Scans the full matrix once. Call at the background scan rate.
+		PURE_HOT_FUNC void scanInFlight(); // Scans only the rows having keys in flight (returns immediately if there are none). Call at the in-flight scan rate.
+		static_assert(Geometry::numRows <= 32, "m_rowInFlightBM holds one bit per row");
+		bool isAnyKeyInFlight();
+#ifdef ENABLE_GLITCH_REJECTION
+		const keybedGlitchStats_t &glitchStats() { return m_glitchStats; }
+#endif
+		uint32_t eventTime() { return m_eventTime; } // Capture time of the current note on/off. Only valid when called from within the note on/off callback.
+		uint32_t eventStopwatch() { return m_eventStopwatch; } // Fixed point stopwatch value of the current note on, for VelocityCurve::velocity16(). Only valid within the note on callback.
 	};
 
 }
 
-#endif /* PURE_VELOCITYKEYBED_H */
\ No newline at end of file
+#include <pure_velocitykeybed.tpp>
+
+#endif /* PURE_VELOCITYKEYBED_H */
@@ -0,0 +1,428 @@
+// Template implementation of PurpleReign::VelocityKeybed. Included by pure_velocitykeybed.h, do not include directly.
+
+#include <pure_scopepins.h>
+
+template <class Geometry>
+PurpleReign::VelocityKeybed<Geometry>::VelocityKeybed()
+{
+	for (int driveLine = 0; driveLine < Geometry::numDriveLines; driveLine++)
+	{
+		m_driveLineSeq[driveLine].row = driveLine / Geometry::numSwitches;
+		m_driveLineSeq[driveLine].mkbk = driveLine % Geometry::numSwitches;
+		m_allDriveLines[driveLine] = driveLine;
+		m_driveLineScanTime[driveLine] = 0;
+	}
+	for (int key = 0; key < Geometry::numKeySlots; key++)
+	{
+		m_keyState[key] = RELEASED;
+		m_keyVelocityStopwatchRunning[key] = 0;
+		m_keyVelocityStopwatchStart[key] = 0;
+		for (int mkbk = 0; mkbk < Geometry::numSwitches; mkbk++)
+		{
+			m_switchMuted[mkbk][key] = 0;
+			m_switchMuteEnd[mkbk][key] = 0;
+			m_switchState[mkbk][key] = HIGH;
+		}
+	}
+	m_switchMuteCycles[MK] = Timebase::microsToCycles32(20 * velocityStopWatchTickMicros); // 20 ticks of the (former fixed rate) keybed scan = 5 ms
+	m_switchMuteCycles[BK] = Timebase::microsToCycles32(20 * velocityStopWatchTickMicros);
+#ifdef ENABLE_CHATTER_STATS
+	for (int key = 0; key < Geometry::numKeySlots; key++)
+	{
+		for (int mkbk = 0; mkbk < Geometry::numSwitches; mkbk++)
+			m_switchMuteCyclesPerSwitch[mkbk][key] = m_switchMuteCycles[mkbk];
+	}
+	resetChatterStats();
+#endif
+	m_rowInFlightBM = 0;
+	m_rowPortBitPattern = Geometry::rowPortInitialBitPattern;
+	m_velocityCurve = nullptr;
+	m_noteOnFunction = nullptr;
+	m_noteOffFunction = nullptr;
+	m_eventTime = 0;
+	m_eventStopwatch = 0;
+#ifdef ENABLE_GLITCH_REJECTION
+	for (int driveLine = 0; driveLine < Geometry::numDriveLines; driveLine++)
+	{
+		m_driveLineColBM[driveLine] = (uint32_t)((((uint64_t)1) << (Geometry::numConnectors * Geometry::numCols)) - 1); // All switches open (HIGH)
+		m_driveLinePendingColBM[driveLine] = 0;
+		m_driveLinePendingTime[driveLine] = 0;
+	}
+	m_driveLinePendingBM = 0;
+	m_glitchStats.rejected = 0;
+	m_glitchStats.confirmed = 0;
+#endif
+}
+
+template <class Geometry>
+void PurpleReign::VelocityKeybed<Geometry>::init()
+{
+	// The PIO controllers only sample their input pins (PIO_PDSR) while their peripheral clock runs. pinMode() is not used here, so enable the clocks explicitly
+	// instead of relying on another module (e.g. attachInterrupt()) having done it.
+	pmc_enable_periph_clk(Geometry::rowPortId);
+	pmc_enable_periph_clk(Geometry::colPortId);
+
+	// Row port: all drive lines are outputs, initially inactive (HIGH)
+	Pio *rowPort = Geometry::rowPort();
+	rowPort->PIO_PER = Geometry::rowPortBitMask;  // PIO controls the pins (instead of a peripheral)
+	rowPort->PIO_SODR = Geometry::rowPortBitMask; // HIGH = inactive
+	rowPort->PIO_OER = Geometry::rowPortBitMask;  // Enable output
+
+	// Column port: inputs without pullup resistors, since an external buffer IC is connected to the input pins
+	Pio *colPort = Geometry::colPort();
+	colPort->PIO_PER = Geometry::colPortBitMask();
+	colPort->PIO_ODR = Geometry::colPortBitMask();
+	colPort->PIO_PUDR = Geometry::colPortBitMask();
+
+	// Enable the drive line for the very first row scan
+	m_rowPortBitPattern = Geometry::rowPortInitialBitPattern; // Prepare to enable only the initial first row port bit (at the same time remembering the pattern between scans)...
+	rowPort->PIO_CODR = m_rowPortBitPattern;					  // ... and do it!
+
+	uint32_t now = Timebase::now32();
+	for (int driveLine = 0; driveLine < Geometry::numDriveLines; driveLine++)
+		m_driveLineScanTime[driveLine] = now;
+}
+
+template <class Geometry>
+void PurpleReign::VelocityKeybed<Geometry>::setVelocityCurve(const VelocityCurve *velocityCurve)
+{
+	m_velocityCurve = velocityCurve;
+}
+
+template <class Geometry>
+void PurpleReign::VelocityKeybed<Geometry>::setNoteOnFunction(void (*function)(int keyAddress, uint8_t velocity))
+{
+	m_noteOnFunction = function;
+}
+
+template <class Geometry>
+void PurpleReign::VelocityKeybed<Geometry>::setNoteOffFunction(void (*function)(int keyAddress))
+{
+	m_noteOffFunction = function;
+}
+
+template <class Geometry>
+void PurpleReign::VelocityKeybed<Geometry>::setSwitchMuteTime(int mkbk, unsigned long muteMicros)
+{
+	if (mkbk != MK && mkbk != BK)
+		return;
+	m_switchMuteCycles[mkbk] = Timebase::microsToCycles32(muteMicros);
+#ifdef ENABLE_CHATTER_STATS
+	for (int key = 0; key < Geometry::numKeySlots; key++)
+		m_switchMuteCyclesPerSwitch[mkbk][key] = m_switchMuteCycles[mkbk];
+#endif
+}
+
+#ifdef ENABLE_CHATTER_STATS
+
+template <class Geometry>
+void PurpleReign::VelocityKeybed<Geometry>::resetChatterStats()
+{
+	for (int key = 0; key < Geometry::numKeySlots; key++)
+	{
+		for (int mkbk = 0; mkbk < Geometry::numSwitches; mkbk++)
+		{
+			m_chatterStats[mkbk][key].closures = 0;
+			m_chatterStats[mkbk][key].bounces = 0;
+			m_chatterStats[mkbk][key].maxBounceCycles = 0;
+		}
+	}
+}
+
+// Mute time = longest bounce + 50 % + one stopwatch tick, limited to [minMuteMicros..maxMuteMicros]. Switches with too few closures keep their mute time.
+// Bounces are only seen during the mute, so a switch that bounced (almost) until the end of its mute may bounce longer still; it gets maxMuteMicros.
+// Tune with the per type mute time set to (at least) maxMuteMicros, so the statistics cover the longest mute time that can be the result.
+template <class Geometry>
+int PurpleReign::VelocityKeybed<Geometry>::autoTuneSwitchMuteTimes(unsigned long minMuteMicros, unsigned long maxMuteMicros)
+{
+	const uint32_t minMuteCycles = Timebase::microsToCycles32(minMuteMicros);
+	const uint32_t maxMuteCycles = Timebase::microsToCycles32(maxMuteMicros);
+	const uint32_t marginCycles = Timebase::microsToCycles32(velocityStopWatchTickMicros);
+	int numTuned = 0;
+	for (int key = 0; key < Geometry::numKeys; key++)
+	{
+		for (int mkbk = 0; mkbk < Geometry::numSwitches; mkbk++)
+		{
+			const switchChatterStats_t &stats = m_chatterStats[mkbk][key];
+			if (stats.closures < keybedAutoTuneMinClosures)
+				continue;
+			uint32_t muteCycles = stats.maxBounceCycles + (stats.maxBounceCycles / 2) + marginCycles;
+			if ((uint64_t)stats.maxBounceCycles * 10 >= (uint64_t)m_switchMuteCyclesPerSwitch[mkbk][key] * 9)
+				muteCycles = maxMuteCycles;
+			if (muteCycles < minMuteCycles)
+				muteCycles = minMuteCycles;
+			if (muteCycles > maxMuteCycles)
+				muteCycles = maxMuteCycles;
+			m_switchMuteCyclesPerSwitch[mkbk][key] = muteCycles;
+			numTuned++;
+		}
+	}
+	return numTuned;
+}
+
+#endif
+
+template <class Geometry>
+bool PurpleReign::VelocityKeybed<Geometry>::isAnyKeyInFlight()
+{
+	return m_rowInFlightBM != 0;
+}
+
+template <class Geometry>
+uint64_t PurpleReign::VelocityKeybed<Geometry>::packSwitchStates()
+{
+	// Bit packing (bit=s<x>k<y>) will be: s0k0..s0k<N-1>|s1k0..s1k<N-1>, truncated to the first 64 switches
+	uint64_t switchStatesPacked64 = 0;
+	int numPacked = 0;
+	for (int mkbk = 0; mkbk < Geometry::numSwitches; mkbk++)
+	{
+		for (int key = 0; key < Geometry::numKeySlots && numPacked < 64; key++, numPacked++)
+		{
+			switchStatesPacked64 <<= 1;
+			switchStatesPacked64 |= m_switchState[mkbk][key];
+		}
+	}
+	return switchStatesPacked64;
+}
+
+// Returns true if the switch (or its key) is in flight after the scan, i.e. if the switch is muted or the key velocity stopwatch is running.
+template <class Geometry>
+inline bool PurpleReign::VelocityKeybed<Geometry>::scanSwitch(int con, int row, int mkbk, int col, int keySwitch, uint32_t now, uint32_t transitionTime)
+{
+	const int key = Geometry::keyAddress(con, row, col);
+
+#ifdef ENABLE_KEY_DEBOUNCE
+
+	////////////////////////////
+	// Handle switch mute timers
+	////////////////////////////
+
+	if (m_switchMuted[mkbk][key] && (int32_t)(now - m_switchMuteEnd[mkbk][key]) >= 0)
+		m_switchMuted[mkbk][key] = 0; // mute time has ended
+#endif
+
+	int prevKeySwitch = m_switchState[mkbk][key]; // recall the switch state (for the current output/input pin-pair) from previous scan
+	m_switchState[mkbk][key] = keySwitch;		  // update the switch state history (for the current output/input pin-pair)
+
+#ifdef ENABLE_CHATTER_STATS
+	if (keySwitch != prevKeySwitch && m_switchMuted[mkbk][key])
+	{ // A bounce
+		switchChatterStats_t &stats = m_chatterStats[mkbk][key];
+		uint32_t bounceCycles = now - (m_switchMuteEnd[mkbk][key] - m_switchMuteCyclesPerSwitch[mkbk][key]); // Time since the closure (= mute start)
+		if (stats.bounces < UINT16_MAX)
+			stats.bounces++;
+		if (bounceCycles > stats.maxBounceCycles)
+			stats.maxBounceCycles = bounceCycles;
+	}
+#endif
+
+	//////////////////////////////
+	// Handle keypresses/releases
+	/////////////////////////////
+
+	if (keySwitch != prevKeySwitch && !m_switchMuted[mkbk][key] && key < Geometry::numKeys)
+	{ // if there is a new value from this scan, compared to previous scan AND switch is not muted AND key is wired
+
+		int currentKeyState = m_keyState[key];
+
+		//////////////////////////////////////////////////////////
+		// key down, bottom switch, from RELEASED state => note-on
+		if (keySwitch == LOW && mkbk == MK && currentKeyState == RELEASED)
+		{
+#ifdef ENABLE_KEY_DEBOUNCE
+			m_switchMuted[mkbk][key] = 1; // set+start MK switch mute
+			m_switchMuteEnd[mkbk][key] = now + switchMuteCycles(MK, key);
+#ifdef ENABLE_CHATTER_STATS
+			if (m_chatterStats[mkbk][key].closures < UINT16_MAX)
+				m_chatterStats[mkbk][key].closures++;
+#endif
+#endif
+			int stopwatch = 0; // 0 = not started (MK closed without a preceding BK closure)
+			m_eventStopwatch = 0;
+			if (m_keyVelocityStopwatchRunning[key])
+			{ // Stop the stopwatch. 1 = min, velocityStopWatchMaxValue = max
+				const uint32_t stopwatchTickCycles = Timebase::microsToCycles32(velocityStopWatchTickMicros);
+				uint32_t elapsed = transitionTime - m_keyVelocityStopwatchStart[key];
+				stopwatch = 1 + ((elapsed + (stopwatchTickCycles / 2)) / stopwatchTickCycles);
+				if (stopwatch > velocityStopWatchMaxValue)
+					stopwatch = velocityStopWatchMaxValue;
+				uint64_t stopwatchFrac = (1 << velocityStopWatchFracBits) + (((uint64_t)elapsed << velocityStopWatchFracBits) / stopwatchTickCycles);
+				m_eventStopwatch = stopwatchFrac < ((uint64_t)velocityStopWatchMaxValue << velocityStopWatchFracBits) ? (uint32_t)stopwatchFrac : (velocityStopWatchMaxValue << velocityStopWatchFracBits);
+				m_keyVelocityStopwatchRunning[key] = 0;
+			}
+			m_eventTime = transitionTime;
+			m_noteOnFunction(key, m_velocityCurve->velocity(stopwatch));
+			m_keyState[key] = PRESSED; // Set key state to new value (key has been properly pressed)
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////////////////
+		// key down, bottom switch, from PRESSED state => incomplete retrigger attempt of note-on, discard
+		else if (keySwitch == LOW && mkbk == MK && currentKeyState == PRESSED)
+		{
+			; // Do nothing
+		}
+
+		//////////////////////////////////////////////////////////////////////////////////////
+		// key down, top switch, from (should always be) RELEASED state => prepare for note-on
+		else if (keySwitch == LOW && mkbk == BK && currentKeyState == RELEASED)
+		{
+#ifdef ENABLE_KEY_DEBOUNCE
+			m_switchMuted[mkbk][key] = 1; // set+start BK switch mute
+			m_switchMuteEnd[mkbk][key] = now + switchMuteCycles(BK, key);
+#ifdef ENABLE_CHATTER_STATS
+			if (m_chatterStats[mkbk][key].closures < UINT16_MAX)
+				m_chatterStats[mkbk][key].closures++;
+#endif
+#endif
+			m_keyVelocityStopwatchStart[key] = transitionTime; // (Re)start key velocity clock (for anticipated note on)
+			m_keyVelocityStopwatchRunning[key] = 1;
+		}
+
+		/////////////////////////////////////////////////////
+		// key up, top switch, from PRESSED state => note-off
+		else if (keySwitch == HIGH && mkbk == BK && currentKeyState == PRESSED)
+		{
+			m_eventTime = transitionTime;
+			m_noteOffFunction(key);
+			m_keyState[key] = RELEASED; // Set key state to new value (key has been properly released)
+		}
+
+		/////////////////////////////////////////////////////////////
+		// key up, top switch, from RELEASED state => aborted note-on
+		else if (keySwitch == HIGH && mkbk == BK && currentKeyState == RELEASED)
+		{
+			m_keyVelocityStopwatchRunning[key] = 0; // Reset key velocity clock (aborted note on)
+		}
+	}
+
+	// A stopwatch that has passed its max value no longer needs any timing precision, so such a key (e.g. held half way down) does not keep its row in flight
+	return m_switchMuted[mkbk][key] || (m_keyVelocityStopwatchRunning[key] && (now - m_keyVelocityStopwatchStart[key]) < Timebase::microsToCycles32(velocityStopWatchMaxValue * velocityStopWatchTickMicros));
+}
+
+// Scans the given drive lines, in the given order. Both drive lines (MK and BK) of a row must be given, MK first.
+//
+// The drive line switch is pipelined with the processing of the switches: The next drive line is activated right after reading the column port, so it has settled by the time
+// of the next read. After the last drive line, the first drive line of a full scan is activated "in advance", so a full scan never needs to wait for the row port to settle.
+template <class Geometry>
+void PurpleReign::VelocityKeybed<Geometry>::scanDriveLines(const uint8_t *driveLines, int numLines)
+{
+	Pio *rowPort = Geometry::rowPort();
+	Pio *colPort = Geometry::colPort();
+	uint32_t now = Timebase::now32(); // A scan takes a few microseconds at most, so one time stamp is enough for all drive lines
+
+	uint32_t firstRowPortBitPattern = Geometry::rowPortInitialBitPattern << driveLines[0];
+	if (m_rowPortBitPattern != firstRowPortBitPattern)
+	{ // First drive line has not been activated in advance, do it now and let it settle
+		rowPort->PIO_SODR = m_rowPortBitPattern;
+		m_rowPortBitPattern = firstRowPortBitPattern;
+		rowPort->PIO_CODR = m_rowPortBitPattern;
+		delayMicroseconds(keybedDriveLineSettleMicros);
+	}
+
+	uint32_t rowInFlightBM = m_rowInFlightBM;
+
+	for (int lap = 0; lap < numLines; lap++)
+	{
+		togglePinB();
+
+		const int driveLine = driveLines[lap];
+
+		// Read the column port and pack the columns of all connectors into the lowest (numConnectors * numCols) bits, see KeybedGeometry::packColumns()
+		uint32_t colKeySwitchBM = Geometry::packColumns(colPort->PIO_PDSR); // Bit Matrix corresponding to the values read from key switch columns from all connectors
+
+		// Pipelining: Switch drive line already now, so the row port has settled by the time the next lap reads the column port.
+		rowPort->PIO_SODR = m_rowPortBitPattern;																					  // Deactivate "old" port bit by setting to HIGH (= Set Output Data Register).
+		m_rowPortBitPattern = (lap + 1 < numLines) ? (Geometry::rowPortInitialBitPattern << driveLines[lap + 1]) : 0; // Calculate next bit pattern. Becomes 0 after the last drive line.
+		rowPort->PIO_CODR = m_rowPortBitPattern;																					  // Activate new port bit by setting to LOW (= Clear Output Data Register).
+
+		const int row = m_driveLineSeq[driveLine].row;	 // let row reference current lap
+		const int mkbk = m_driveLineSeq[driveLine].mkbk; // let mkbk reference current lap
+
+		uint32_t transitionTime = m_driveLineScanTime[driveLine] + ((now - m_driveLineScanTime[driveLine]) >> 1); // Any transition happened somewhere between the previous scan of this drive line and now
+		m_driveLineScanTime[driveLine] = now;
+
+		bool driveLineInFlight = false;
+
+#ifdef ENABLE_GLITCH_REJECTION
+		const uint32_t driveLineBit = ((uint32_t)1) << driveLine;
+		if (m_driveLinePendingBM & driveLineBit)
+		{ // The previous read had an implausible number of transitions: Accept it if this read confirms it, otherwise it was a glitch
+			m_driveLinePendingBM &= ~driveLineBit;
+			if (colKeySwitchBM == m_driveLinePendingColBM[driveLine])
+			{
+				m_glitchStats.confirmed++;
+				m_driveLineColBM[driveLine] = colKeySwitchBM;
+				transitionTime = m_driveLinePendingTime[driveLine]; // The transitions happened before the previous read
+			}
+			else
+				m_glitchStats.rejected++;
+		}
+		if (colKeySwitchBM != m_driveLineColBM[driveLine])
+		{
+			if (__builtin_popcount(colKeySwitchBM ^ m_driveLineColBM[driveLine]) > keybedGlitchMaxTransitions)
+			{ // Implausible, hold it back until the next scan of the drive line
+				m_driveLinePendingBM |= driveLineBit;
+				m_driveLinePendingColBM[driveLine] = colKeySwitchBM;
+				m_driveLinePendingTime[driveLine] = transitionTime;
+				colKeySwitchBM = m_driveLineColBM[driveLine]; // Process the accepted bits meanwhile
+				driveLineInFlight = true;					  // Rescan the row at the in-flight rate
+			}
+			else
+				m_driveLineColBM[driveLine] = colKeySwitchBM;
+		}
+#endif
+
+		// Scan columns based on previously read column port
+		for (int con = 0; con < Geometry::numConnectors; con++)
+		{
+			for (int col = 0; col < Geometry::numCols; col++)
+			{
+				int keySwitch = colKeySwitchBM & 0x01; // Mask out LSB from colKeySwitchBM
+				colKeySwitchBM >>= 1;				   // Shift entire colKeySwitchBM variable one bit right
+				driveLineInFlight |= scanSwitch(con, row, mkbk, col, keySwitch, now, transitionTime);
+			}
+		}
+
+		// The MK drive line is scanned first in each row, so it (re)initializes the row's in flight bit and the BK drive line adds to it
+		if (mkbk == MK)
+			rowInFlightBM = (rowInFlightBM & ~(((uint32_t)1) << row)) | (((uint32_t)driveLineInFlight) << row);
+		else
+			rowInFlightBM |= ((uint32_t)driveLineInFlight) << row;
+
+		togglePinB();
+	}
+
+	m_rowInFlightBM = rowInFlightBM;
+
+	// since this was the last drive line; reset m_rowPortBitPattern to the initial state to prepare for the next full scan
+	m_rowPortBitPattern = Geometry::rowPortInitialBitPattern; // Preprare for activating the "next" (= initial) port bit pattern, aka restarting the loop "in advance"...
+	rowPort->PIO_CODR = m_rowPortBitPattern;				  // ...and do it!
+}
+
+template <class Geometry>
+void PurpleReign::VelocityKeybed<Geometry>::scan()
+{
+	togglePinA();
+	scanDriveLines(m_allDriveLines, Geometry::numDriveLines);
+	togglePinA();
+}
+
+template <class Geometry>
+void PurpleReign::VelocityKeybed<Geometry>::scanInFlight()
+{
+	uint32_t rowInFlightBM = m_rowInFlightBM;
+	if (rowInFlightBM == 0)
+		return;
+
+	uint8_t driveLines[Geometry::numDriveLines];
+	int numLines = 0;
+	for (int row = 0; rowInFlightBM != 0; row++, rowInFlightBM >>= 1)
+	{
+		if (rowInFlightBM & 0x01)
+		{
+			for (int mkbk = 0; mkbk < Geometry::numSwitches; mkbk++)
+				driveLines[numLines++] = row * Geometry::numSwitches + mkbk;
+		}
+	}
+	scanDriveLines(driveLines, numLines);
+}
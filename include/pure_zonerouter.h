@@ -0,0 +1,74 @@
+#ifndef PURE_ZONEROUTER_H
+#define PURE_ZONEROUTER_H
+
+#include <Arduino.h>
+
+#include <pure_doublebuffer.h>
+
+namespace PurpleReign
+{
+
+	// A keyboard zone: Keys [lowKey..highKey] (key addresses) play MIDI note (keyAddress + noteOffset) on channel.
+	// Overlapping zones are layers, adjacent zones are splits, and noteOffset sets the transposition.
+	struct zone_t
+	{
+		uint8_t lowKey;
+		uint8_t highKey;
+		uint8_t channel; // 0..15
+		int8_t noteOffset;
+	};
+
+	// Routes key events to MIDI (note, channel) outputs.
+	//
+	// The zone setup is compiled into a flat table with the list of outputs of each key, so the scan path does a single indexed lookup per event,
+	// no matter how many zones are configured. A new zone setup is compiled into the shadow copy of the table and swapped in atomically (see DoubleBuffer).
+	//
+	// The route of a note on is remembered per key and reused for its note off, so a key held across a zone change is released on the notes it started.
+	class ZoneRouter
+	{
+	public:
+		static const int maxKeys = 128;	 // Key addresses 0..127
+		static const int maxLayers = 4;	 // Max number of outputs per key
+		static const int maxZones = 8;
+
+		struct output_t
+		{
+			uint8_t note;
+			uint8_t channel;
+		};
+
+		struct route_t
+		{
+			uint8_t numOutputs;
+			output_t output[maxLayers];
+		};
+
+	private:
+		struct routeTable_t
+		{
+			route_t route[maxKeys];
+		};
+
+		DoubleBuffer<routeTable_t> m_table;
+		route_t m_noteOnRoute[maxKeys]; // Route taken by the latest note on, per key
+
+	public:
+		ZoneRouter();
+
+		// Compiles and activates a zone setup. Returns false (and keeps the active setup) if a zone is invalid or a key would get more than maxLayers outputs.
+		bool setZones(const zone_t *zones, int numZones);
+
+		// The outputs of a note on of the key. Not range checked, keyAddress must be below maxKeys.
+		inline const route_t &noteOnRoute(int keyAddress)
+		{
+			m_noteOnRoute[keyAddress] = m_table.active().route[keyAddress];
+			return m_noteOnRoute[keyAddress];
+		}
+
+		// The outputs of a note off of the key, i.e. those of its latest note on
+		inline const route_t &noteOffRoute(int keyAddress) { return m_noteOnRoute[keyAddress]; }
+	};
+
+}
+
+#endif /* PURE_ZONEROUTER_H */
@@ -8,72 +8,36 @@
 #include <cassert>
 
 #include <pure_adc.h>
+#include <pure_analogkeybed.h>
+#include <pure_config.h>
+#include <pure_ctrlgovernor.h>
+#include <pure_digitalinputs.h>
+#include <pure_doublebuffer.h>
+#include <pure_encoders.h>
+#include <pure_log.h>
+#include <pure_metrics.h>
+#include <pure_midiclock.h>
 #include <pure_midictrl.h>
+#include <pure_midimerge.h>
 #include <pure_midiqueue.h>
+#include <pure_midiserialout.h>
+#include <pure_ramfunc.h>
+#include <pure_scopepins.h>
 #include <pure_task.h>
+#include <pure_timebase.h>
+#include <pure_ump.h>
+#include <pure_velocitycurve.h>
 #include <pure_velocitykeybed.h>
+#include <pure_zonerouter.h>
 
 //////////////////////////////////////////////
 // Debug
 //////////////////////////////////////////////
 
-#define PURE_DEBUG
-
-void debugPrint(char *c)
-{
-#if defined(PURE_DEBUG)
-	SerialUSB.print(c);
-#endif
-}
-
-void debugPrint(int i)
-{
-#if defined(PURE_DEBUG)
-	SerialUSB.print(i);
-#endif
-}
-
-void debugPrint(uint16_t i)
-{
-#if defined(PURE_DEBUG)
-	SerialUSB.print(i);
-#endif
-}
-
-void debugPrint(double f)
-{
-#if defined(PURE_DEBUG)
-	SerialUSB.print(f);
-#endif
-}
-
-void debugPrintLn(char *c)
-{
-#if defined(PURE_DEBUG)
-	SerialUSB.println(c);
-#endif
-}
-
-void debugPrintLn(int i)
-{
-#if defined(PURE_DEBUG)
-	SerialUSB.println(i);
-#endif
-}
-
-void debugPrintLn(uint16_t i)
-{
-#if defined(PURE_DEBUG)
-	SerialUSB.println(i);
-#endif
-}
-
-void debugPrintLn(double d)
-{
-#if defined(PURE_DEBUG)
-	SerialUSB.println(d);
-#endif
-}
+// Diagnostics are logged with PURE_LOG_*() (see include/pure_log.h): level and subsystems are selected at compile time (PURE_LOG_LEVEL, PURE_LOG_SUBSYSTEMS),
+// and enabled log sites only store a binary record, which is sent by logFlushTask and decoded on the host by tools/decode_log.py.
+// Runtime metrics (see include/pure_metrics.h) are always counted, and can be queried in the field, see METRICS_QUERY.
+// #define PURE_FAST_BOOT // Production boot: No start up delays and no hello world note, diagnostics are deferred until the keybed is being scanned. Scanning starts within a few ms of reset.
 
 //////////////////////////////////////////////
 // MIDI and buffers
@@ -105,10 +69,6 @@ const int ccNumGeneralPurpose4MSB = 19;
 const int ccNumGeneralPurpose4 = ccNumGeneralPurpose4MSB;
 const int ccNumGeneralPurpose4LSB = ccNumGeneralPurpose4MSB + 32;
 
-// MIDI CC handling
-
-bool gcEnable14BitCc = false; // Global configuration ("gc") to enable 14 bit CC handling. If disabled 7 bit CC handling will be used.
-
 // MIDI data structures and functions
 
 union midiPacket4_t
@@ -117,7 +77,12 @@ union midiPacket4_t
 	uint8_t data8bit[4];
 };
 
-CircularBuffer<uint32_t, 100> midiBuffer4;
+PurpleReign::MidiQueue midiQueue; // Outgoing MIDI events (midiEvent_t), encoded and sent by midiQueue.pump() from loop() to USB and the sinks added with midiQueue.addSink()
+
+#define CTRL_GOVERNOR // Rate limit the controller events (per controller and for all controllers together) and keep queue headroom for notes, see PurpleReign::CtrlGovernor
+#ifdef CTRL_GOVERNOR
+PurpleReign::CtrlGovernor ctrlGovernor;
+#endif
 
 struct adcToCtrlMap_t
 {
@@ -127,53 +92,41 @@ struct adcToCtrlMap_t
 	int numAdcRangeBorders = 0;									  // Current number of ADC range borders. Should be one more than number of ADC ranges. TODO: Is this variable unnecessary as it can be deduced?
 	uint16_t adcRangeBorder[maxNumAdcRangeBorders];				  // Dynamically defines the current list of ADC ranges [adcRangeBorder[0]..adcRangeBorder[1]] , [adcRangeBorder[1]..adcRangeBorder[2]] , ... , [adcRangeBorder[numAdcRangeBorders-2]..adcRangeBorder[numAdcRangeBorders-1]]
 	uint16_t ctrlRangeBorderHighest = 0;						  // Dynamically defines the currently highest border of the controller ranges.
-	double k[maxNumAdcRanges];									  // Slope of the linear equation that maps ADC values in the ranges defined by adcRangeBorder[] to controller values.
+	int32_t k[maxNumAdcRanges];									  // Slope of the linear equation that maps ADC values in the ranges defined by adcRangeBorder[] to controller values. Fixed point Q16 (see ctrlSlopeQ16()), so adcToCtrl() needs no (soft) floating point.
 	uint16_t m[maxNumAdcRanges];								  // Y-intercept of the linear equation that maps ADC values in the ranges defined by adcRangeBorder[] to controller values.
 };
 
-void printCtrlMap(adcToCtrlMap_t *aTCM)
+// ctrlSlopeQ16(): The slope k = ctrlDelta / adcDelta of a map range, in Q16 fixed point. |k| stays below 2^14 (14-bit controller values, integer ADC steps), so it fits in 32 bits.
+inline int32_t ctrlSlopeQ16(int ctrlDelta, int adcDelta)
 {
-	debugPrintLn("vv-Dumping adcToCtrlMap:");
-	debugPrint("maxNumAdcRanges: ");
-	debugPrintLn(aTCM->maxNumAdcRanges);
-	debugPrint("maxNumAdcRangeBorders: ");
-	debugPrintLn(aTCM->maxNumAdcRangeBorders);
-	debugPrint("numAdcRanges: ");
-	debugPrintLn(aTCM->numAdcRanges);
-	debugPrint("numAdcRangeBorders: ");
-	debugPrintLn(aTCM->numAdcRangeBorders);
-	// debugPrint("adcRangeBorder[]: ");
-	for (int i = 0; i < aTCM->maxNumAdcRangeBorders; i++)
-	{
-		debugPrint("adcRangeBorder[");
-		debugPrint(i);
-		debugPrint("]: ");
-		debugPrintLn(aTCM->adcRangeBorder[i]);
-	}
-	debugPrint("ctrlRangeBorderHighest: ");
-	debugPrintLn(aTCM->ctrlRangeBorderHighest);
-	for (int i = 0; i < aTCM->maxNumAdcRanges; i++)
-	{
-		debugPrint("k[");
-		debugPrint(i);
-		debugPrint("]: ");
-		debugPrintLn(aTCM->k[i]);
-	}
-	for (int i = 0; i < aTCM->maxNumAdcRanges; i++)
-	{
-		debugPrint("m[");
-		debugPrint(i);
-		debugPrint("]: ");
-		debugPrintLn(aTCM->m[i]);
-	}
-	debugPrintLn("^^-Done dumping adcToCtrlMap");
+	return (int32_t)ctrlDelta * 65536 / adcDelta;
+}
+
+inline float ctrlSlopeToFloat(int32_t kQ16) { return kQ16 / 65536.0f; } // For the log
+
+void logCtrlMap(const adcToCtrlMap_t *aTCM)
+{
+	PURE_LOG_DEBUG(PURE_LOG_CTRL, CTRL_MAP_HEADER, aTCM->numAdcRanges, aTCM->numAdcRangeBorders, aTCM->ctrlRangeBorderHighest);
+	for (int i = 0; i < aTCM->numAdcRanges; i++)
+		PURE_LOG_DEBUG(PURE_LOG_CTRL, CTRL_MAP_RANGE, i, aTCM->adcRangeBorder[i], ctrlSlopeToFloat(aTCM->k[i]), aTCM->m[i]);
+	if (aTCM->numAdcRangeBorders > 0)
+		PURE_LOG_DEBUG(PURE_LOG_CTRL, CTRL_MAP_TOP, aTCM->numAdcRangeBorders - 1, aTCM->adcRangeBorder[aTCM->numAdcRangeBorders - 1]);
 }
 
 const int atcmIxPitchbend = 0;
+const int atcmIxModulation = 1;
+const int atcmIxLinear = 2; // The default map of the faders and pots (and of any other CC)
 const int numAdcToCtrlMapArrElements = 16; // Defines the maximum number of different ADC value to MIDI controller value mappings that can be done simultaneously.
-adcToCtrlMap_t adcToCtrlMapArr[numAdcToCtrlMapArrElements];
 
-int atcmArrIxPerCC[highestCcNumber];
+// Controller settings, read by the ADC scan. Changed only through ctrlSettings (see PurpleReign::DoubleBuffer), so a reader never sees a half updated map.
+struct ctrlSettings_t
+{
+	bool enable14BitCc = false;								  // Enable 14 bit CC handling. If disabled 7 bit CC handling will be used.
+	adcToCtrlMap_t adcToCtrlMapArr[numAdcToCtrlMapArrElements]; // ADC value to controller value maps
+	int atcmArrIxPerCC[highestCcNumber + 1] = {};				  // adcToCtrlMapArr index per CC
+};
+
+PurpleReign::DoubleBuffer<ctrlSettings_t> ctrlSettings;
 
 struct adcCtrlPair_t
 {
@@ -202,7 +155,7 @@ void setAdcToCtrlMap1(adcToCtrlMap_t *aTCM, uint16_t adcBorder0, uint16_t ctrlBo
 	aTCM->numAdcRangeBorders = aTCM->numAdcRanges + 1;
 	aTCM->adcRangeBorder[0] = adcBorder0;
 	aTCM->m[0] = ctrlBorder0;
-	aTCM->k[0] = static_cast<float>(ctrlBorder1 - ctrlBorder0) / (adcBorder1 - adcBorder0); //k = (y1 - y0) / (x1 - x0)
+	aTCM->k[0] = ctrlSlopeQ16(ctrlBorder1 - ctrlBorder0, adcBorder1 - adcBorder0); //k = (y1 - y0) / (x1 - x0)
 	aTCM->adcRangeBorder[1] = adcBorder1;
 	aTCM->ctrlRangeBorderHighest = ctrlBorder1;
 }
@@ -228,13 +181,13 @@ void setAdcToCtrlMap3(adcToCtrlMap_t *aTCM, uint16_t adcBorder0, uint16_t ctrlBo
 	aTCM->numAdcRangeBorders = aTCM->numAdcRanges + 1;
 	aTCM->adcRangeBorder[0] = adcBorder0;
 	aTCM->m[0] = ctrlBorder0;
-	aTCM->k[0] = static_cast<float>(ctrlBorder1 - ctrlBorder0) / (adcBorder1 - adcBorder0); //k = (y1 - y0) / (x1 - x0)
+	aTCM->k[0] = ctrlSlopeQ16(ctrlBorder1 - ctrlBorder0, adcBorder1 - adcBorder0); //k = (y1 - y0) / (x1 - x0)
 	aTCM->adcRangeBorder[1] = adcBorder1;
 	aTCM->m[1] = ctrlBorder1;
-	aTCM->k[1] = static_cast<float>(ctrlBorder2 - ctrlBorder1) / (adcBorder2 - adcBorder1); //k = (y2 - y1) / (x2 - x1)
+	aTCM->k[1] = ctrlSlopeQ16(ctrlBorder2 - ctrlBorder1, adcBorder2 - adcBorder1); //k = (y2 - y1) / (x2 - x1)
 	aTCM->adcRangeBorder[2] = adcBorder2;
 	aTCM->m[2] = ctrlBorder2;
-	aTCM->k[2] = static_cast<float>(ctrlBorder3 - ctrlBorder2) / (adcBorder3 - adcBorder2); //k = (y3 - y2) / (x3 - x2)
+	aTCM->k[2] = ctrlSlopeQ16(ctrlBorder3 - ctrlBorder2, adcBorder3 - adcBorder2); //k = (y3 - y2) / (x3 - x2)
 	aTCM->adcRangeBorder[3] = adcBorder3;
 	aTCM->ctrlRangeBorderHighest = ctrlBorder3;
 }
@@ -260,43 +213,43 @@ void setAdcToCtrlMap10(adcToCtrlMap_t *aTCM,
 	// border 0 (first border)
 	aTCM->adcRangeBorder[0] = adcBorder0;
 	aTCM->m[0] = ctrlBorder0;
-	aTCM->k[0] = static_cast<float>(ctrlBorder1 - ctrlBorder0) / (adcBorder1 - adcBorder0); //k = (y1 - y0) / (x1 - x0)
+	aTCM->k[0] = ctrlSlopeQ16(ctrlBorder1 - ctrlBorder0, adcBorder1 - adcBorder0); //k = (y1 - y0) / (x1 - x0)
 	// border 1
 	aTCM->adcRangeBorder[1] = adcBorder1;
 	aTCM->m[1] = ctrlBorder1;
-	aTCM->k[1] = static_cast<float>(ctrlBorder2 - ctrlBorder1) / (adcBorder2 - adcBorder1); //k = (y2 - y1) / (x2 - x1)
+	aTCM->k[1] = ctrlSlopeQ16(ctrlBorder2 - ctrlBorder1, adcBorder2 - adcBorder1); //k = (y2 - y1) / (x2 - x1)
 	// border 2
 	aTCM->adcRangeBorder[2] = adcBorder2;
 	aTCM->m[2] = ctrlBorder2;
-	aTCM->k[2] = static_cast<float>(ctrlBorder3 - ctrlBorder2) / (adcBorder3 - adcBorder2); //k = (y3 - y2) / (x3 - x2)
+	aTCM->k[2] = ctrlSlopeQ16(ctrlBorder3 - ctrlBorder2, adcBorder3 - adcBorder2); //k = (y3 - y2) / (x3 - x2)
 	// border 3
 	aTCM->adcRangeBorder[3] = adcBorder3;
 	aTCM->m[3] = ctrlBorder3;
-	aTCM->k[3] = static_cast<float>(ctrlBorder4 - ctrlBorder3) / (adcBorder4 - adcBorder3); //k = (y4 - y3) / (x4 - x3)
+	aTCM->k[3] = ctrlSlopeQ16(ctrlBorder4 - ctrlBorder3, adcBorder4 - adcBorder3); //k = (y4 - y3) / (x4 - x3)
 	// border 4
 	aTCM->adcRangeBorder[4] = adcBorder4;
 	aTCM->m[4] = ctrlBorder4;
-	aTCM->k[4] = static_cast<float>(ctrlBorder5 - ctrlBorder4) / (adcBorder5 - adcBorder4); //k = (y5 - y4) / (x5 - x4)
+	aTCM->k[4] = ctrlSlopeQ16(ctrlBorder5 - ctrlBorder4, adcBorder5 - adcBorder4); //k = (y5 - y4) / (x5 - x4)
 	// border 5
 	aTCM->adcRangeBorder[5] = adcBorder5;
 	aTCM->m[5] = ctrlBorder5;
-	aTCM->k[5] = static_cast<float>(ctrlBorder6 - ctrlBorder5) / (adcBorder6 - adcBorder5); //k = (y6 - y5) / (x6 - x5)
+	aTCM->k[5] = ctrlSlopeQ16(ctrlBorder6 - ctrlBorder5, adcBorder6 - adcBorder5); //k = (y6 - y5) / (x6 - x5)
 	// border 6
 	aTCM->adcRangeBorder[6] = adcBorder6;
 	aTCM->m[6] = ctrlBorder6;
-	aTCM->k[6] = static_cast<float>(ctrlBorder7 - ctrlBorder6) / (adcBorder7 - adcBorder6); //k = (y7 - y6) / (x7 - x6)
+	aTCM->k[6] = ctrlSlopeQ16(ctrlBorder7 - ctrlBorder6, adcBorder7 - adcBorder6); //k = (y7 - y6) / (x7 - x6)
 	// border 7
 	aTCM->adcRangeBorder[7] = adcBorder7;
 	aTCM->m[7] = ctrlBorder7;
-	aTCM->k[7] = static_cast<float>(ctrlBorder8 - ctrlBorder7) / (adcBorder8 - adcBorder7); //k = (y8 - y7) / (x8 - x7)
+	aTCM->k[7] = ctrlSlopeQ16(ctrlBorder8 - ctrlBorder7, adcBorder8 - adcBorder7); //k = (y8 - y7) / (x8 - x7)
 	// border 8
 	aTCM->adcRangeBorder[8] = adcBorder8;
 	aTCM->m[8] = ctrlBorder8;
-	aTCM->k[8] = static_cast<float>(ctrlBorder9 - ctrlBorder8) / (adcBorder9 - adcBorder8); //k = (y9 - y8) / (x9 - x8)
+	aTCM->k[8] = ctrlSlopeQ16(ctrlBorder9 - ctrlBorder8, adcBorder9 - adcBorder8); //k = (y9 - y8) / (x9 - x8)
 	// border 9
 	aTCM->adcRangeBorder[9] = adcBorder9;
 	aTCM->m[9] = ctrlBorder9;
-	aTCM->k[9] = static_cast<float>(ctrlBorder10 - ctrlBorder9) / (adcBorder10 - adcBorder9); //k = (y10 - y9) / (x10 - x9)
+	aTCM->k[9] = ctrlSlopeQ16(ctrlBorder10 - ctrlBorder9, adcBorder10 - adcBorder9); //k = (y10 - y9) / (x10 - x9)
 	// last border
 	aTCM->adcRangeBorder[10] = adcBorder10;
 	aTCM->ctrlRangeBorderHighest = ctrlBorder10;
@@ -323,40 +276,21 @@ void setAdcToCtrlMap10(adcToCtrlMap_t *aTCM,
 //
 void setAdcToCtrlMap(adcToCtrlMap_t *aTCM, int numBorders, borderList_t bL)
 {
-	debugPrintLn("Entering setAdcToCtrlMap()");
+	PURE_LOG_TRACE(PURE_LOG_CTRL, CTRL_MAP_SET_BEGIN, numBorders);
 	assert(numBorders >= 2);
 	assert(aTCM);
 	aTCM->numAdcRanges = numBorders - 1;
 	aTCM->numAdcRangeBorders = numBorders;
 	for (int border = 0; border < (numBorders - 1); border++)
 	{
-		debugPrint("bL[");
-		debugPrint(border);
-		debugPrint("].adcValue: ");
-		debugPrintLn(bL[border].adcValue);
 		aTCM->adcRangeBorder[border] = bL[border].adcValue;
-		debugPrint("aTCM->adcRangeBorder[");
-		debugPrint(border);
-		debugPrint("]: ");
-		debugPrintLn(aTCM->adcRangeBorder[border]);
-		debugPrint("bL[");
-		debugPrint(border);
-		debugPrint("].ctrlValue: ");
-		debugPrintLn(bL[border].ctrlValue);
 		aTCM->m[border] = bL[border].ctrlValue;
-		debugPrint("aTCM->m[");
-		debugPrint(border);
-		debugPrint("]: ");
-		debugPrintLn(aTCM->m[border]);
-		aTCM->k[border] = static_cast<float>(bL[border + 1].ctrlValue - bL[border].ctrlValue) / (bL[border + 1].adcValue - bL[border].adcValue); //k<n> = (y<n+1> - y<n>) / (x<n+1> - x<n>)
-		debugPrint("aTCM->k[");
-		debugPrint(border);
-		debugPrint("]: ");
-		debugPrintLn(aTCM->k[border]);
+		aTCM->k[border] = ctrlSlopeQ16(bL[border + 1].ctrlValue - bL[border].ctrlValue, bL[border + 1].adcValue - bL[border].adcValue); //k<n> = (y<n+1> - y<n>) / (x<n+1> - x<n>)
+		PURE_LOG_DEBUG(PURE_LOG_CTRL, CTRL_MAP_BORDER, border, aTCM->adcRangeBorder[border], aTCM->m[border], ctrlSlopeToFloat(aTCM->k[border]));
 	}
 	aTCM->adcRangeBorder[numBorders - 1] = bL[numBorders - 1].adcValue;
 	aTCM->ctrlRangeBorderHighest = bL[numBorders - 1].ctrlValue;
-	debugPrintLn("Exiting setAdcToCtrlMap()");
+	PURE_LOG_TRACE(PURE_LOG_CTRL, CTRL_MAP_SET_END);
 }
 
 // uint16_t is the return value type of choice since the greatest controller value (pitch-bend included) in MIDI 1.0 do not exceed 14 bit size.
@@ -367,14 +301,15 @@ void setAdcToCtrlMap(adcToCtrlMap_t *aTCM, int numBorders, borderList_t bL)
 // (adcValue * aTCM->k[ix]) + aTCM->m[ix]), where (adcValue = aTCM->adcRangeBorder[ix]) for all ix = [0..numAdcRanges]
 // Please check your calculations when setting the gain, offset and border values to make sure that these worst case scenarios do not overflow.
 //
-uint16_t adcToCtrl(adcToCtrlMap_t *aTCM, uint16_t adcValue)
+// Integer arithmetic only: with PURE_RAM_HOT_PATH the function runs from SRAM, and a call to a soft-float helper would run from flash.
+PURE_HOT_FUNC uint16_t adcToCtrl(const adcToCtrlMap_t *aTCM, uint16_t adcValue)
 {
 	if (adcValue < aTCM->adcRangeBorder[0])
 		return (aTCM->m[0]);
 	for (uint8_t ix = 1; ix < aTCM->numAdcRangeBorders; ix++)
 	{																								  // Iterate over the number of ADC range borders, starting at 1 since we already checked ix = 0.
 		if (adcValue < aTCM->adcRangeBorder[ix])													  // ADC value is between two borders; the current index and the previous one, which we should have already checked (in previous iteration or before iteration started). So a single comparison operator suffices to find each succeeding interval.
-			return (((adcValue - aTCM->adcRangeBorder[ix - 1]) * aTCM->k[ix - 1]) + aTCM->m[ix - 1]); // since the range
+			return aTCM->m[ix - 1] + (int32_t)(((int64_t)(adcValue - aTCM->adcRangeBorder[ix - 1]) * aTCM->k[ix - 1] + 0x8000) >> 16); // Q16, rounded. A 32x32->64 multiply (SMULL), no library call.
 	}
 	// If no previous range was matched, then ADC value belongs to the highest range and should return the calculated value at the highest ADC border, "pegged".
 	return aTCM->ctrlRangeBorderHighest;
@@ -405,185 +340,98 @@ size_t sendMidiPacket4(midiPacket4_t midiPacket4)
 	return MidiUSB.write(midiPacket4.data8bit, 4);
 }
 
-void enqueueNoteOn(byte note, byte velocity, byte channel)
+void enqueueNoteOn(byte note, byte velocity, uint16_t velocity16, byte channel, uint32_t captureTime)
 {
-	midiPacket4_t data;
-	data.data8bit[0] = 0x09;
-	data.data8bit[1] = 0x90 | channel;
-	data.data8bit[2] = note;
-	data.data8bit[3] = velocity;
-	midiBuffer4.push(data.data32bit);
+	midiQueue.push(PurpleReign::MidiEvent::noteOn(channel, note, velocity, velocity16, captureTime));
 }
 
-void enqueueNoteOff(byte note, byte velocity, byte channel)
+void enqueueNoteOff(byte note, byte velocity, uint16_t velocity16, byte channel, uint32_t captureTime)
 {
-	midiPacket4_t data;
-	data.data8bit[0] = 0x08;
-	data.data8bit[1] = 0x80 | channel;
-	data.data8bit[2] = note;
-	data.data8bit[3] = velocity;
-	midiBuffer4.push(data.data32bit);
+	midiQueue.push(PurpleReign::MidiEvent::noteOff(channel, note, velocity, velocity16, captureTime));
 }
 
-void enqueuePitchBend(uint16_t adcVal, byte channel)
+// enqueueCtrlEvent(): Enqueue a controller event, through the rate governor if there is one
+inline void enqueueCtrlEvent(const PurpleReign::midiEvent_t &event)
 {
-	static uint16_t prevCtrlVal = 0;
-
-	midiPacket4_t data;
-	uint16_t ctrlVal = adcToCtrl(&adcToCtrlMapArr[atcmIxPitchbend], adcVal);
-	if (ctrlVal != prevCtrlVal)
-	{
-		// debugPrint("New val: ");
-		// debugPrint(ctrlVal);
-		// debugPrint("   Old val: ");
-		// debugPrintLn(prevCtrlVal);
-		data.data8bit[0] = 0x0E;
-		data.data8bit[1] = 0xE0 | channel;
-		data.data8bit[2] = ctrlVal & 0x7Fu;		   // filter out the 7 LSbits (="fine")
-		data.data8bit[3] = (ctrlVal >> 7) & 0x7Fu; // filter out the 7 MSbits (="coarse")
-		midiBuffer4.push(data.data32bit);
-		prevCtrlVal = ctrlVal;
-	}
+#ifdef CTRL_GOVERNOR
+	ctrlGovernor.push(event);
+#else
+	PurpleReign::Metrics::increment(PurpleReign::METRIC_CTRL_EMITTED);
+	midiQueue.push(event);
+#endif
 }
 
-// According to MIDI 1.0 specs and MSB/LSB CC message pairs (assuming receiver cares about these things):
-//  * MSB needs not be resent if only LSB is sent. Receiver should interpret it as a "fine adjustment".
-//  * If MSB is sent ("coarse adjustment"), LSB will automatically be "reset" to 0 by receiver.
-//  To implement this, each CC needs to remember its latest MSB sent, to see if a new one needs to be resent.
-//
-// User is able to select (globally) if 7-bit or 14-bit resolution should be assumed (aka 7-bit vs 14-bit CC "mode")
-
-void enqueueCC(uint8_t ccNum, uint16_t adcVal, byte channel)
+void enqueuePolyPressure(byte note, byte pressure, byte channel)
 {
-	static uint8_t prevCcValMsb[highestMsbCcNumber + 1]; // Remember the previous CC MSB value. Will be 0-initialized (once) by compiler.
-	midiPacket4_t data;
-	data.data8bit[0] = 0x0B;
-	data.data8bit[1] = 0xB0 | channel;
-
-	uint16_t ctrlVal = adcToCtrl(&adcToCtrlMapArr[atcmArrIxPerCC[ccNum]], adcVal);
-	uint8_t ccValMsb = (ctrlVal >> 7) & (0x7Fu); // Extract the 7 highest bits of the 14-bit controller value and shift it down.
-	uint8_t ccValLsb = ctrlVal & 0x7Fu;			 // Extract the 7 lowest bits of the 14-bit controller value.
-
-	if (ccNum <= highestMsbCcNumber) // If CC# is within MSB range
-	{
-		if (ccValMsb != prevCcValMsb[ccNum]) // if MSB value for CC (ccNum) has changed since last function call (otherwise no use in sending any new MIDI message)...
-		{
-			prevCcValMsb[ccNum] = ccValMsb; // Update the "previous CC MSB value"
-			data.data8bit[2] = ccNum;
-			data.data8bit[3] = ccValMsb;	  // The 7-bit MSB
-			midiBuffer4.push(data.data32bit); // push CC MSB message (msg #1)
-		}
-		//  Assuming 14-bit mode is enabled; the application (almost) always need to resend the LSB message:
-		//  * If MSB has changed it needs to resend LSB since the assumption by the receiver otherwise will be that LSB is reset to 0
-		//    - Only if MSB has changed and the LSB is exactly = 0 there is no need to resend LSB message, but this is probably a rare case in 14-bit mode and can be ignored.
-		//  * If MSB did not change it can be inferred that the LSB must have changed (since *this* function is only called if ADC value has changed)
-		//  So, the conclusion is: Iff 14-bit mode is enabled, always send LSB.
-		if (gcEnable14BitCc)
-		{
-			data.data8bit[2] = ccNum + lowestLsbCcNumber;
-			data.data8bit[3] = ccValLsb;	  // The 7-bit LSB
-			midiBuffer4.push(data.data32bit); // push CC LSB message (msg #2)
-		}
-	}
+	enqueueCtrlEvent(PurpleReign::MidiEvent::polyPressure(channel, note, pressure, PurpleReign::Timebase::now32()));
 }
 
-void enqueueSimpleCC(uint16_t adcVal, byte channel)
+void enqueuePitchBend(uint16_t adcVal, byte channel)
 {
-	midiPacket4_t data;
-	data.data8bit[0] = 0x0B;
-	data.data8bit[1] = 0xB0 | channel;
+	static uint16_t prevCtrlVal = 0;
 
-	if (true)
+	uint16_t ctrlVal = adcToCtrl(&ctrlSettings.active().adcToCtrlMapArr[atcmIxPitchbend], adcVal);
+	if (ctrlVal != prevCtrlVal)
 	{
-		// prevCcValMsb[ccNum] = ccValMsb; // Update the "previous CC MSB value"
-		data.data8bit[2] = 1;						// 1 = modulation
-		data.data8bit[3] = (adcVal >> 5) & (0x7Fu); // Extract the 7 highest bits of the 12-bit ADC value and shift it down (5 steps).
-		midiBuffer4.push(data.data32bit);			// push CC MSB message (msg #1)
+		PURE_LOG_TRACE(PURE_LOG_CTRL, PITCH_BEND_VALUE, ctrlVal, prevCtrlVal);
+		enqueueCtrlEvent(PurpleReign::MidiEvent::pitchBend(channel, ctrlVal, PurpleReign::Timebase::now32()));
+		prevCtrlVal = ctrlVal;
 	}
 }
 
-//
-// toggle pins for observability
-//
+// User is able to select (globally) if 7-bit or 14-bit resolution should be assumed (aka 7-bit vs 14-bit CC "mode"). The MIDI 1.0 MSB/LSB message pairs
+// are made by the encoder of each sink (see Midi1Encoder).
 
-#define REG_PIO_PIN_52_SODR REG_PIOB_SODR
-#define REG_PIO_PIN_52_CODR REG_PIOB_CODR
-#define REG_PIO_PIN_53_SODR REG_PIOB_SODR
-#define REG_PIO_PIN_53_CODR REG_PIOB_CODR
-#define PIN_52_BITMASK ((uint32_t)1 << 21)
-#define PIN_53_BITMASK ((uint32_t)1 << 14)
-
-#define SET_PIN_52                            \
-	{                                         \
-		REG_PIO_PIN_52_SODR = PIN_52_BITMASK; \
-	}
-#define CLR_PIN_52                            \
-	{                                         \
-		REG_PIO_PIN_52_CODR = PIN_52_BITMASK; \
-	}
-#define SET_PIN_53                            \
-	{                                         \
-		REG_PIO_PIN_53_SODR = PIN_53_BITMASK; \
-	}
-#define CLR_PIN_53                            \
-	{                                         \
-		REG_PIO_PIN_53_CODR = PIN_53_BITMASK; \
-	}
-
-void initPinB()
+// enqueueCcValue(): Enqueue a 14-bit controller value, from any source (ADC, encoder, ...)
+//
+// CC 0..31 are queued with their 14-bit value (and, in 14-bit mode, EVENT_FLAG_LSB), in 7-bit mode only if the MSB changed. CC 64..127 have no LSB and are queued
+// as 7-bit values (the MSB of the value), if changed. Changes are tracked per channel and CC.
+void enqueueCcValue(uint8_t ccNum, uint16_t ctrlVal, byte channel)
 {
-	pinMode(52, OUTPUT);
-}
+	static uint8_t prevCcValMsb[16][highestCcNumber + 1]; // Remember the previous CC MSB value per channel. Will be 0-initialized (once) by compiler.
 
-void togglePinB()
-{
-	static bool toggle = false;
-	if (toggle)
+	const ctrlSettings_t &settings = ctrlSettings.active(); // One consistent snapshot of the settings for this call
+	uint8_t ccValMsb = (ctrlVal >> 7) & (0x7Fu);			// Extract the 7 highest bits of the 14-bit controller value and shift it down.
+
+	uint8_t &prevMsb = prevCcValMsb[channel & 0x0F][ccNum & highestCcNumber];
+	if (ccNum <= highestMsbCcNumber) // If CC# is within MSB range
 	{
-		SET_PIN_52 // digitalWrite(52,HIGH);
+		if (!settings.enable14BitCc && ccValMsb == prevMsb)
+			return; // 7-bit mode: only the MSB is sent, and it did not change, so the event would encode to nothing
+		prevMsb = ccValMsb;
+		enqueueCtrlEvent(PurpleReign::MidiEvent::controlChange(channel, ccNum, ctrlVal, settings.enable14BitCc ? PurpleReign::EVENT_FLAG_LSB : 0, PurpleReign::Timebase::now32()));
 	}
-	else
+	else if (ccNum >= lowestLsbCcNumber + highestMsbCcNumber + 1 && ccNum <= highestCcNumber) // 7-bit only CC range (64..127)
 	{
-		CLR_PIN_52 // digitalWrite(52,LOW);
+		if (ccValMsb != prevMsb)
+		{
+			prevMsb = ccValMsb;
+			enqueueCtrlEvent(PurpleReign::MidiEvent::controlChange(channel, ccNum, ctrlVal, 0, PurpleReign::Timebase::now32()));
+		}
 	}
-	toggle = !toggle;
 }
 
-void initPinA()
+void enqueueCC(uint8_t ccNum, uint16_t adcVal, byte channel)
 {
-	pinMode(53, OUTPUT);
+	const ctrlSettings_t &settings = ctrlSettings.active();
+	enqueueCcValue(ccNum, adcToCtrl(&settings.adcToCtrlMapArr[settings.atcmArrIxPerCC[ccNum]], adcVal), channel);
 }
 
-void togglePinA()
+// enqueueCcRelative(): Enqueue a relative CC in "binary offset" encoding (64 = no change, 65 = +1, 63 = -1, ...)
+// Not rate limited, since a held back delta could not be replaced by a newer one without losing movement. The encoders are polled at a low rate anyway.
+void enqueueCcRelative(uint8_t ccNum, int delta, byte channel)
 {
-	static bool toggle = false;
-	if (toggle)
-	{
-		SET_PIN_53 // digitalWrite(53,HIGH);
-	}
-	else
-	{
-		CLR_PIN_53 // digitalWrite(53,LOW);
-	}
-	toggle = !toggle;
+	if (delta > 63)
+		delta = 63;
+	if (delta < -63)
+		delta = -63;
+	PurpleReign::Metrics::increment(PurpleReign::METRIC_CTRL_EMITTED);
+	midiQueue.push(PurpleReign::MidiEvent::controlChange7(channel, ccNum, 64 + delta, PurpleReign::Timebase::now32()));
 }
 
-// Tries to send the oldest midi packet. Shifts it from the head of the queue if successful. Otherwise leaves queue intact (to have a new go next invocation).
-void sendOldestMidiPacket()
+void enqueueSimpleCC(uint16_t adcVal, byte channel)
 {
-	midiPacket4_t midiPacket4;
-	if (!midiBuffer4.isEmpty())
-	{
-		midiPacket4.data32bit = midiBuffer4.first();
-	}
-	else
-		return;
-	if (MidiUSB.write(midiPacket4.data8bit, 4) > 0)
-	{
-		// togglePinA();
-		midiBuffer4.shift();
-	}
-	return;
+	enqueueCtrlEvent(PurpleReign::MidiEvent::controlChange7(channel, 1, (adcVal >> 5) & (0x7Fu), PurpleReign::Timebase::now32())); // 1 = modulation. The 7 highest bits of the 12-bit ADC value.
 }
 
 //
@@ -592,13 +440,70 @@ void sendOldestMidiPacket()
 
 // #define LOG_MISSED_TICKS
 // #define LOG_KEYSWITCHES
+// #define LOG_LATENCY_STATS
+// #define LOG_CLOCK_STATS
+// #define LOG_CHATTER_STATS
+// #define LOG_GOVERNOR_STATS
+// #define LOG_MIDI_TRACE	 // Print every outgoing MIDI event to SerialUSB (a MidiQueue sink)
+#define MIDI_MERGE			 // Merge the DIN MIDI input (31250 baud on the UART, pins 0/1; the other UARTs' pins are taken by the muxes and the keybed) into the USB output, see PurpleReign::MidiMerge
+#define MIDI_DIN_OUTPUT	 // Also send the MIDI output to the DIN MIDI output (UART TX, pin 1), with running status, see PurpleReign::MidiSerialOut
+// #define MIDI_DIN_THRU	 // Also send the merged DIN input back to the DIN output (soft thru). Off by default, since a device with thru or echo enabled would then create a MIDI loop.
+#define METRICS_QUERY		 // Answer metrics snapshot requests (CMD_GET_METRICS over USB-MIDI SysEx, or the query byte on SerialUSB), see PurpleReign::Metrics
+// #define MIDI_USB_THRU	 // Also merge the non-SysEx USB-MIDI input into the USB output. Off by default, since a host that echoes its output would then create a MIDI loop.
+#define MIDI_CLOCK_OUTPUT	 // Generate MIDI clock (24 PPQN) and transport messages, see PurpleReign::MidiClock
+#define KEYBED_ADAPTIVE_SCAN // Scan idle keybed rows at a slow background rate and rows with keys in flight at a high rate. If undefined, the full keybed is scanned at the major tick rate.
+// #define KEYBED_ANALOG	 // Keys with position sensors (e.g. hall-effect) on the analog muxes instead of the MK/BK switch matrix, see PurpleReign::AnalogKeybed. The muxes then carry the keys instead of the faders.
+
+#ifdef KEYBED_ANALOG
+#undef KEYBED_ADAPTIVE_SCAN // The analog keybed is sampled at a fixed rate
+#endif
+
+const int _tickDeltaMajor = 250;			 // Major tick delta in microseconds
+const int _tickDeltaADC = 10000;			 // ADC tick delta in microseconds
+const int _tickDeltaKeybedIdle = 250;		 // Keybed background (full scan) tick delta in microseconds, when KEYBED_ADAPTIVE_SCAN is defined. Not above the full scan rate without KEYBED_ADAPTIVE_SCAN
+											 // (_tickDeltaMajor): the first switch transition of an idle row (a BK closure, or the MK opening of a held key's release) is found at this rate
+											 // and stamped within +-125 us (the midpoint of the interval), the other switch of a key in flight within +-25 us (_tickDeltaKeybedInFlight).
+const int _tickDeltaKeybedInFlight = 50;	 // Keybed in flight rows scan tick delta in microseconds, when KEYBED_ADAPTIVE_SCAN is defined
+const int _tickDeltaKeybedAnalog = 500;		 // Analog keybed scan tick delta in microseconds (the per key sample rate), when KEYBED_ANALOG is defined. Must not be below the mux cycle time (16 * analogSlotMicros).
+const int _tickDeltaEncoders = 10000;		 // Rotary encoder (decoder counter) poll tick delta in microseconds
+const int _tickDeltaMidiIn = 1000;			 // Incoming MIDI (configuration SysEx) tick delta in microseconds
+const int _midiInBytesPerTick = 32;			 // Max number of incoming MIDI bytes parsed per tick, bounds the time taken from the keybed scan
+const int _tickDeltaLogFlush = 10000;		 // Log flush tick delta in microseconds
+const int _logRecordsPerFlush = 8;			 // Max number of log records sent per tick (~30 bytes each)
+const int _tickDeltaMetrics = 10000;		 // Metrics tick delta in microseconds (scan rate gauge, SerialUSB query poll)
+const int _tickDeltaBootDiagnostics = 100000; // Deferred boot diagnostics tick delta in microseconds, when PURE_FAST_BOOT is defined
+const uint32_t _deferredBootDiagnosticsMicros = 3000000; // Time after reset of the deferred boot diagnostics (gives the host time to open the serial port)
+const int _tickDeltaLatencyStats = 1000000; // Latency statistics log tick delta in microseconds, when LOG_LATENCY_STATS is defined
+const int _tickDeltaChatterStats = 10000000; // Switch chatter statistics log tick delta in microseconds, when LOG_CHATTER_STATS is defined
+const int _tickDeltaClockStats = 1000000;	// MIDI clock statistics log tick delta in microseconds, when LOG_CLOCK_STATS is defined
+const int _tickDeltaGovernorStats = 1000000; // Controller governor statistics log tick delta in microseconds, when LOG_GOVERNOR_STATS is defined
+
+const uint32_t midiClockInitialTempo = 12000; // MIDI clock tempo at boot, in 1/100 BPM
+
+const unsigned long digitalInputDebounceMicros = 5000; // Debounce filter time of the pedal and button inputs
+
+#ifdef KEYBED_ANALOG
+const unsigned long analogSlotMicros = 25; // Mux address slot period. One conversion sequence per slot, so every key is sampled every 400 us.
+#else
+const unsigned long analogSlotMicros = 100; // Mux address slot period. One conversion sequence per slot; with all addresses in use, FAST inputs are sampled every 1.6 ms.
+#endif
+const uint16_t analogChangeThreshold = 16; // Change (in 12-bit ADC units) of a mux input needed to send a new value
+
+const unsigned long encoderFilterMaxCycles = 63; // Width (in master clock cycles, max 63) of the pulses rejected by the rotary encoder input filters
 
-const int _tickDeltaMajor = 250; // Major tick delta in microseconds
-const int _tickDeltaMinor = 50;	 // Minor tick delta in microseconds
-const int _tickDeltaADC = 10000; // ADC tick delta in microseconds
+const uint32_t midiConstantLatencyMicros = 0; // Fixed latency from key switch transition (or controller change) to USB output. 0 = off (send as soon as possible). See PurpleReign::MidiQueue.
+
+const uint32_t ctrlGovernorRate = 100;	   // Messages per second per controller, when CTRL_GOVERNOR is defined
+const uint8_t ctrlGovernorBurst = 4;	   // Messages a controller may send back to back, after a pause
+const uint32_t ctrlGovernorClassRate = 500; // Messages per second of all controllers together. About half of what a DIN link carries (~1000 three byte messages/s).
+const uint8_t ctrlGovernorClassBurst = 16;
+const int ctrlGovernorNoteHeadroom = 32;   // MidiQueue places (events) controllers never take, i.e. two full USB banks of notes
+
+const unsigned long midiSerialBaudRate = 31250;
+const int midiMergeLimit = PurpleReign::MidiMerge::maxMessagePackets; // Merged traffic is only forwarded while the MidiQueue holds fewer packets, so local notes wait behind at most 2 USB banks of it
 
 // uint16_t adcValCh0, adcValCh1, adcValCh2, adcValCh3, adcValCh4, adcValCh5 = 0;
-uint16_t adcValPrevCh0, adcValPrevCh1, adcValPrevCh2, adcValPrevCh3, adcValPrevCh4, adcValPrevCh5 = 0;
+uint16_t adcValPrevCh0, adcValPrevCh1 = 0;
 
 bool adcChange(uint16_t threshold, uint16_t adcVal, uint16_t adcValPrev)
 {
@@ -824,381 +729,123 @@ void logMissedTicks(int timeStamp, int ticks)
 
 #ifdef LOG_KEYSWITCHES
 
-void logKeySwitches(int timeStamp, switchArray_t sa)
+void logKeySwitches(int timeStamp, uint64_t packedSwitchStates)
 {
-	addEntryToLog(timeStamp, SwitchStateType, packSwitchArray(sa));
+	addEntryToLog(timeStamp, SwitchStateType, packedSwitchStates);
 }
 
 #endif
 
 namespace keybed
 {
-	// initialize the keybed scanning variables
-	const int numConnectors = 2;				// number of switch matrix connectors on keybed
-	const int numRows = 4;						// number of key switch matrix rows per connector, disregarding the number of switches per key
-	const int numSwitches = 2;					// Number of key switches per key (2 switches => 1 make, 1 break)
-	const int numCols = 8;						// number of key switch matrix columns
-	const int MK = 0, BK = 1;					// Make or Break row index numering
-	const int RELEASED = 0, PRESSED = 1;		// Key states
-	const int switchMuteTimerStartValueMK = 20; // * Major tick delta
-	const int switchMuteTimerStartValueBK = 20; // * Major tick delta
-
-#define ROW_PORT_INITIAL_BIT_PATTERN (((uint32_t)1) << 1)
-#define ROW_PORT_BIT_MASK (((uint32_t)0b11111111) << 1)
-#define ROW_PORT_DISABLE_OUTPUT_DATA_REG REG_PIOD_SODR // Disabling is done by setting port pin to HIGH (*Set* Output Data Register; SODR)
-#define ROW_PORT_ENABLE_OUTPUT_DATA_REG REG_PIOD_CODR  // Enabling is done by clearing port pin to LOW (*Clear* Output Data Register; CODR)
-
-	// int _rowPin; // remember the row Pin from previous lap in the current scan loop (or, if current lap is the first; from the last lap in the previous scan loop)
-	static uint32_t _rowPortBitPattern; // Remember the row port bit pattern from previous lap in the current scan loop (or, if current lap is the first; from the last lap in the previous scan loop)
-
-	struct rowMkbk_t
-	{
-		int row;
-		int mkbk;
-	};
+	typedef PurpleReign::Keybed61Geometry geometry_t; // Select the keybed geometry here, see pure_keybedgeometry.h
 
-	rowMkbk_t rowMkbkLoopSeq[(numCols * numSwitches) + 1] = { // Sequence of <Row,Mkbk> tuples representing the sequence of a full iteration of one connector (where Mkbk is the innermost loop). The sequence is "wrapped around" itself with the first element also added to the end of the sequence. This makes the sequence one element longer than what would be "normal".
-		{0, MK},
-		{0, BK},
-		{1, MK},
-		{1, BK},
-		{2, MK},
-		{2, BK},
-		{3, MK},
-		{3, BK},
-		{0, MK}};
-
-	// int rowPinList[numRows][numSwitches] = {{37,35},{33,31},{29,27},{25,23}}; // Pairs of {MK,BK} switches sorted in increasing switch matrix "row" order (row 0, row 1, ...). These pins are the "write" pins that will be used for output, one by one forced to LOW during scan (not more than one pin is allowed to be LOW at any given moment in time).
-	// int colPinList[numConnectors][numCols] = {{22,24,26,28,30,32,34,36},{38,40,42,44,46,48,50,52}}; // These are the "read" pins that will be used for input (potentially with internal pullup resistors enabled), During scan reading "LOW" will mean a pressed key switch.
-
-	int rowPinList[numRows][numSwitches] = {{26, 27}, {28, 14}, {15, 29}, {11, 12}};							   // Pairs of {MK,BK} switches sorted in increasing switch matrix "row" order (row 0, row 1, ...). These pins are the "write" pins that will be used for output, one by one forced to LOW during scan (not more than one pin is allowed to be LOW at any given moment in time).
-	int colPinList[numConnectors][numCols] = {{33, 34, 35, 36, 37, 38, 39, 40}, {51, 50, 49, 48, 47, 46, 45, 44}}; // These are the "read" pins that will be used for input (potentially with internal pullup resistors enabled), During scan reading "LOW" will mean a pressed key switch.
-
-	///////////////////////////////////////////////////////////////////////////////////
-	//
-	// Row/Column switch matrix scanning pin mapping for parallell read
-	//
-	// Row: Pin
-	//
-	// 0: D.1
-	// 1: D.2
-	// 2: D.3
-	// 3: D.4
-	// 4: D.5
-	// 5: D.6
-	// 6: D.7
-	// 7: D.8
-
-	// Connector/Column: Pin
-	//
-	// N.B. Connector 0 pins are inverted
-	//
-	// 0/0: C.1
-	// 0/1: C.2
-	// 0/2: C.3
-	// 0/3: C.4
-	// 0/4: C.5
-	// 0/5: C.6
-	// 0/6: C.7
-	// 0/7: C.8
-	//
-	// 1/0: C.12
-	// 1/1: C.13
-	// 1/2: C.14
-	// 1/3: C.15
-	// 1/4: C.16
-	// 1/5: C.17
-	// 1/6: C.18
-	// 1/7: C.19
-
-	//////////////////////////////
-	// KeyArray types and funtions
-	//////////////////////////////
-
-	typedef int keyArray_t[numConnectors][numRows][numCols]; // type representing the matrix of keybed keys, disregarding the number of switches per key, storing a single (32-bit) integer per key
-
-	keyArray_t addressArray = {
-		{{0, 1, 2, 3, 4, 5, 6, 7},
-		 {8, 9, 10, 11, 12, 13, 14, 15},
-		 {16, 17, 18, 19, 20, 21, 22, 23},
-		 {24, 25, 26, 27, 28, 29, 30, 31}},
-		{{32, 33, 34, 35, 36, 37, 38, 39},
-		 {40, 41, 42, 43, 44, 45, 46, 47},
-		 {48, 49, 50, 51, 52, 53, 54, 55},
-		 {56, 57, 58, 59, 60, 61, 52, 53}}};
-
-	keyArray_t keyState = {
-		{{RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED},
-		 {RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED},
-		 {RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED},
-		 {RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED}},
-		{{RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED},
-		 {RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED},
-		 {RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED},
-		 {RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED, RELEASED}}};
-
-	keyArray_t keyVelocityStopwatch = {
-		{{0, 0, 0, 0, 0, 0, 0, 0},
-		 {0, 0, 0, 0, 0, 0, 0, 0},
-		 {0, 0, 0, 0, 0, 0, 0, 0},
-		 {0, 0, 0, 0, 0, 0, 0, 0}},
-		{{0, 0, 0, 0, 0, 0, 0, 0},
-		 {0, 0, 0, 0, 0, 0, 0, 0},
-		 {0, 0, 0, 0, 0, 0, 0, 0},
-		 {0, 0, 0, 0, 0, 0, 0, 0}}};
-
-	typedef unsigned char switchArray_t[numConnectors][numRows][numSwitches][numCols]; // type representing the matrix of switches on the keybed
-
-	switchArray_t switchMuteTimer = {
-		{{{0, 0, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 0, 0}},
-		 {{0, 0, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 0, 0}},
-		 {{0, 0, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 0, 0}},
-		 {{0, 0, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 0, 0}}},
-		{{{0, 0, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 0, 0}},
-		 {{0, 0, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 0, 0}},
-		 {{0, 0, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 0, 0}},
-		 {{0, 0, 0, 0, 0, 0, 0, 0}, {0, 0, 0, 0, 0, 0, 0, 0}}}};
-
-	switchArray_t switchArray = // switch array for the matrix representing the entire 5 octave keybed
-		{{{{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}},
-		  {{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}},
-		  {{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}},
-		  {{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}}},
-		 {{{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}},
-		  {{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}},
-		  {{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}},
-		  {{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}}}};
-
-	switchArray_t switchArrayFake = // switch array for the matrix representing the entire 5 octave keybed, simulating the real switches
-		{{{{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}},
-		  {{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}},
-		  {{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}},
-		  {{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}}},
-		 {{{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}},
-		  {{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}},
-		  {{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}},
-		  {{HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}, {HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH, HIGH}}}};
-
-	//////////////////////////////////
-	// velocityMap types and functions
-	//////////////////////////////////
-
-	const int velocityStopWatchMaxValue = 1000;								 // Note that lowest value is 0
-	const int sizeVelocityStopWatchMaxValue = velocityStopWatchMaxValue + 1; // size is one larger than max value
-	typedef uint8_t velocityMap_t[sizeVelocityStopWatchMaxValue];			 // type mapping a velocity stop-watch value to actual MIDI velocity
-	velocityMap_t velocityMap;
-
-	enum mapType_t
-	{
-		LIN_STD,
-		LIN_1,
-		LIN_2,
-		LOG_STD,
-		LOG_1,
-		LOG_2,
-		EXP_8
-	};
+	const int defaultNoteOffset = 24; // MIDI note number of the key with address 0, in the default zone
+	const int defaultNoteChannel = 1;
 
-	void initVelocityMap(velocityMap_t &map, int mapType)
+	static_assert(geometry_t::numKeySlots <= PurpleReign::ZoneRouter::maxKeys, "The zone router has a route per key address");
+
+	PurpleReign::VelocityCurve velocityCurve(PurpleReign::EXP_8); // Maps key velocity stopwatch values to MIDI velocity. Use velocityCurve.select() to switch curve at runtime.
+	PurpleReign::VelocityKeybed<geometry_t> velocityKeybed; // Not scanned when KEYBED_ANALOG is defined, but still holds the (unused) switch settings of the configuration
+	PurpleReign::ZoneRouter zoneRouter;						 // Maps keys to (note, channel) outputs, see setDefaultConfig() for the default zone
+
+#ifdef KEYBED_ANALOG
+	const int analogNumKeys = 61;			   // Key address = mux input (mux * 16 + mux address)
+	const int analogKeyDefaultSpan = 1200;	   // Raw ADC value change from rest to bottom, for keys without a calibration
+	const int analogKeyTriggerPosition = 512;  // Note on point, in PurpleReign::analogKeyPositionMax units of the key travel
+	const int analogKeyReleasePosition = 384;  // Note off point
+	static_assert(analogNumKeys <= PurpleReign::Adc::maxInputs, "One mux input per key");
+	PurpleReign::AnalogKeybed analogKeybed;
+#endif
+
+	inline uint32_t eventTime()
 	{
-		int expN;
-		switch (mapType)
-		{
-		case LIN_STD:
-			for (int stopWatchIx = 0; stopWatchIx < sizeVelocityStopWatchMaxValue; stopWatchIx++)
-			{
-				velocityMap[stopWatchIx] = (1 - (static_cast<float>(stopWatchIx) / velocityStopWatchMaxValue)) * 127;
-			}
-			break;
-		case EXP_8:
-			expN = 8;
-			for (int stopWatchIx = 0; stopWatchIx < sizeVelocityStopWatchMaxValue; stopWatchIx++)
-			{
-				velocityMap[stopWatchIx] = ((1.f / expN) * pow(126 * expN, (1 - (static_cast<float>(stopWatchIx) / velocityStopWatchMaxValue)))) + 1;
-			}
-		default:
-			break;
-		}
+#ifdef KEYBED_ANALOG
+		return analogKeybed.eventTime();
+#else
+		return velocityKeybed.eventTime();
+#endif
 	}
 
-	void dumpVelocityMap(velocityMap_t velocityMap)
+	inline uint32_t eventStopwatch()
 	{
-		for (int stopWatchIx = 0; stopWatchIx < velocityStopWatchMaxValue; stopWatchIx++)
-		{
-			SerialUSB.print(velocityMap[stopWatchIx]);
-			SerialUSB.print(" ");
-		}
+#ifdef KEYBED_ANALOG
+		return analogKeybed.eventStopwatch();
+#else
+		return velocityKeybed.eventStopwatch();
+#endif
 	}
 
-}
-
-void scanKeybed()
-{
-#define ENABLE_KEY_DEBOUNCE
-#define DISABLE_HIZ
-
-	using namespace keybed;
-
-	int row;
-	int mkbk;
-	// int colKeySwitch[numConnectors][numCols];
-
-	// Scan the keybed
-
-	// Scan the row/mkbk pins
+	void noteOn(int keyAddress, uint8_t velocity)
+	{
+		const PurpleReign::ZoneRouter::route_t &route = zoneRouter.noteOnRoute(keyAddress);
+		uint32_t stopwatch = eventStopwatch();
+		uint16_t velocity16 = stopwatch != 0 ? velocityCurve.velocity16(stopwatch) : PurpleReign::Ump::scaleUp(velocity, 7, 16); // 0 = no stopwatch measurement
+		for (int ix = 0; ix < route.numOutputs; ix++)
+			enqueueNoteOn(route.output[ix].note, velocity, velocity16, route.output[ix].channel, eventTime());
+	}
 
-#ifdef LOG_KEYSWITCHES
-	int _thisTick = microSeconds;
+	void noteOff(int keyAddress)
+	{
+#ifdef KEYBED_ANALOG
+		uint8_t velocity = analogKeybed.releaseVelocity();
+#else
+		uint8_t velocity = 64;
 #endif
-	togglePinA();
+		const PurpleReign::ZoneRouter::route_t &route = zoneRouter.noteOffRoute(keyAddress);
+		for (int ix = 0; ix < route.numOutputs; ix++)
+			enqueueNoteOff(route.output[ix].note, velocity, PurpleReign::Ump::scaleUp(velocity, 7, 16), route.output[ix].channel, eventTime());
+	}
 
-	// loop over (numRows*numSwitches), to scan rows and mkbk switches ( Note: <numConnectors> connectors are scanned in parallell).
-	for (int rowMkbk = 0; rowMkbk < (numRows * numSwitches); rowMkbk++)
+	void aftertouch(int keyAddress, uint8_t pressure)
 	{
+		const PurpleReign::ZoneRouter::route_t &route = zoneRouter.noteOffRoute(keyAddress); // The route of the sounding notes
+		for (int ix = 0; ix < route.numOutputs; ix++)
+			enqueuePolyPressure(route.output[ix].note, pressure, route.output[ix].channel);
+	}
 
-		togglePinB();
-
-		// read REG_PIOC_PDSR
-		uint32_t pioc_input = REG_PIOC_PDSR;
-
-		// pack data to 16 LSB bits, starting from this 32 bit value (straight from PIOC input register, port "C" name is implicit):
-		// PIOC input port bits: [31..20][19..12][11..9][8..1][0]
-		//                                ^^^^^^         ^^^^
-		// Interpretation:         (switch1,col7..0)  (switch0,col7..0)
-
-		// ending with this 16 bit value (port "C" name is implicit) in dedicated column variable:
-		// PIOC input port bits: [19..12][8..1]
-		// column variable bits:  15..8   7..0
-		// Interpretation:   (sw1,c7..0) (sw0,c7..0)
-		//
-
-		uint16_t colKeySwitchBM = 0;							// Bit Matrix corresponding to the values read from key switch columns from all switches (all switches + all columns)
-		colKeySwitchBM |= ((pioc_input >> (8 - 7)) & 0x00FF);	// pack 8 LSB bits
-		colKeySwitchBM |= ((pioc_input >> (19 - 15)) & 0xFF00); // pack 8 MSB bits
+}
 
-		// togglePinA();
+#ifdef KEYBED_ANALOG
 
-		// row = rowMkbkLoopSeq[rowMkbk + 1].row;  // let row reference next lap
-		// mkbk = rowMkbkLoopSeq[rowMkbk + 1].mkbk; // let mkbk reference next lap
-		ROW_PORT_DISABLE_OUTPUT_DATA_REG = _rowPortBitPattern;				// Deactivate "old" port bit by setting to HIGH (= Set Output Data Register). // deactivateRowPin(_rowPin);
-		_rowPortBitPattern = (_rowPortBitPattern << 1) & ROW_PORT_BIT_MASK; // Calculate next bit pattern // _rowPin = rowPinList[row][mkbk];
-		ROW_PORT_ENABLE_OUTPUT_DATA_REG = _rowPortBitPattern;				// Activate new port bit by setting to LOW (= Clear Output Data Register). // activateRowPin(_rowPin); // prepare for next lap by enabling the output pin already now. For the last lap the output pin will be set for the first lap of the next loop (see the definition of "rowMkbkLoopSeq[]"")
+void scanKeybed()
+{
+	keybed::analogKeybed.scan();
+	PurpleReign::Metrics::increment(PurpleReign::METRIC_KEYBED_SCANS);
+}
 
-		// SerialUSB.print(_rowPortBitPattern,BIN);
-		// SerialUSB.print("..");
+PurpleReign::Task keybedTask(scanKeybed, _tickDeltaKeybedAnalog);
 
-		row = rowMkbkLoopSeq[rowMkbk].row;	 // let row reference current lap
-		mkbk = rowMkbkLoopSeq[rowMkbk].mkbk; // let mkbk reference current lap
+#else
 
-		// Scan columns based on previously read column pins
-		for (int con = 0; con < numConnectors; con++)
-		{
-			for (int col = 0; col < numCols; col++)
-			{
-
-				// int keySwitch = colKeySwitch[con][col];
-				int keySwitch = colKeySwitchBM & 0x01; // Mask out LSB from colKeySwitchBM
-				colKeySwitchBM >>= 1;				   // Shift entire colKeySwitchBM variable one bit right
-
-				if (con == 0)
-					keySwitch = 1 - keySwitch; // negate keySwitch for connector 0 , assuming 74HC14 is in series with conenctor 0 output. (74HC14 vs 74hc9015 workaround)
-#ifdef ENABLE_KEY_DEBOUNCE
-
-				///////////////////////////////////////////////////////
-				// Handle key mute timers and key velocity stop watches
-				///////////////////////////////////////////////////////
-
-				if (switchMuteTimer[con][row][mkbk][col] > 0)
-					switchMuteTimer[con][row][mkbk][col]--; // decrement switchMuteTimer until reaches zero
-				if (mkbk == MK)
-				{ // Velocity: Only act on MK switch scan, to avoid double stopwatch increments per key (NOTE! this does not mean that velocity stopwatch is only handled when MK switch is closed, just that it is handled only once per key)
-					int stopwatch = keyVelocityStopwatch[con][row][col];
-					if (stopwatch > 0 && stopwatch < velocityStopWatchMaxValue)
-						keyVelocityStopwatch[con][row][col]++; // increment keyVelocityStopwatch within limits, 0 = not started; 1 = min, 1000 = max
-				}
+void scanKeybed()
+{
+#ifdef LOG_KEYSWITCHES
+	int _thisTick = PurpleReign::Timebase::nowMicros();
 #endif
 
-				int prevKeySwitch = switchArray[con][row][mkbk][col]; // recall the switch state (for the current output/input pin-pair) from previous scan
-				switchArray[con][row][mkbk][col] = keySwitch;		  // update the switchArray history (for the current output/input pin-pair)
-
-				// midiLogSwitchChange(con,row,mkbk,col,keySwitch,prevKeySwitch);
-
-				//////////////////////////////
-				// Handle keypresses/releases
-				/////////////////////////////
-
-				if (keySwitch != prevKeySwitch && switchMuteTimer[con][row][mkbk][col] == 0)
-				{ // if there is a new value from this scan, compared to previous scan AND switch is not muted
-
-					int currentKeyState = keyState[con][row][col];
-
-					//////////////////////////////////////////////////////////
-					// key down, bottom switch, from RELEASED state => note-on
-					if (keySwitch == LOW && mkbk == MK && currentKeyState == RELEASED)
-					{
-#ifdef ENABLE_KEY_DEBOUNCE
-						switchMuteTimer[con][row][mkbk][col] = switchMuteTimerStartValueMK; // set+start MK switchMuteTimer
-#endif
-						int address = addressArray[con][row][col];
-						enqueueNoteOn(address + 24, velocityMap[keyVelocityStopwatch[con][row][col]], 1);
-						keyState[con][row][col] = PRESSED; // Set key state to new value (key has been properly pressed)
-					}
-
-					//////////////////////////////////////////////////////////////////////////////////////////////////
-					// key down, bottom switch, from PRESSED state => incomplete retrigger attempt of note-on, discard
-					else if (keySwitch == LOW && mkbk == MK && currentKeyState == PRESSED)
-					{
-						; // Do nothing
-					}
-
-					//////////////////////////////////////////////////////////////////////////////////////
-					// key down, top switch, from (should always be) RELEASED state => prepare for note-on
-					else if (keySwitch == LOW && mkbk == BK && currentKeyState == RELEASED)
-					{
-#ifdef ENABLE_KEY_DEBOUNCE
-						switchMuteTimer[con][row][mkbk][col] = switchMuteTimerStartValueBK; // set+start BK switchMuteTimer
-#endif
-						keyVelocityStopwatch[con][row][col] = 1; // (Re)start key velocity clock (for anticipated note on)
-					}
-
-					/////////////////////////////////////////////////////
-					// key up, top switch, from PRESSED state => note-off
-					else if (keySwitch == HIGH && mkbk == BK && currentKeyState == PRESSED)
-					{
-						enqueueNoteOff(addressArray[con][row][col] + 24, 64, 1);
-						keyState[con][row][col] = RELEASED; // Set key state to new value (key has been properly released)
-					}
-
-					/////////////////////////////////////////////////////////////
-					// key up, top switch, from RELEASED state => aborted note-on
-					else if (keySwitch == HIGH && mkbk == BK && currentKeyState == RELEASED)
-					{
-						keyVelocityStopwatch[con][row][col] = 0; // Reset key velocity clock (aborted note on)
-					}
-				}
-			} // end columns scan
-		}	  // end connectors scan
-
-		togglePinB();
-
-	} // end rowMkbk loop
-
-	// since this was the last rowMkBk lap; reset _rowPortBitPattern to initial state again to prepare for next loop() invocation
-	ROW_PORT_DISABLE_OUTPUT_DATA_REG = _rowPortBitPattern && (ROW_PORT_BIT_MASK); // deactivate current port bit (if at all needed)
-	_rowPortBitPattern = ROW_PORT_INITIAL_BIT_PATTERN;							  // Preprare for activating the "next" (= initial) port bit pattern, aka restarting the loop "in advance"...
-	ROW_PORT_ENABLE_OUTPUT_DATA_REG = _rowPortBitPattern;						  // ...and do it!
-
-	// SerialUSB.print(_rowPortBitPattern,BIN);
-	// SerialUSB.println("::");
+	keybed::velocityKeybed.scan();
+	PurpleReign::Metrics::increment(PurpleReign::METRIC_KEYBED_SCANS);
 
 #ifdef LOG_KEYSWITCHES
-	logKeySwitches(_thisTick, switchArrayLo);
+	logKeySwitches(_thisTick, keybed::velocityKeybed.packSwitchStates());
 #endif
+}
 
-	togglePinA();
+void scanKeybedInFlight()
+{
+	keybed::velocityKeybed.scanInFlight();
+	PurpleReign::Metrics::increment(PurpleReign::METRIC_KEYBED_INFLIGHT_SCANS);
 }
 
+#ifdef KEYBED_ADAPTIVE_SCAN
+PurpleReign::Task keybedTask(scanKeybed, _tickDeltaKeybedIdle);
+PurpleReign::Task keybedInFlightTask(scanKeybedInFlight, _tickDeltaKeybedInFlight);
+#else
 PurpleReign::Task keybedTask(scanKeybed, _tickDeltaMajor);
+#endif
+
+#endif
 
 //  * Read ADC channel values, store in memory, interpret the values and enqueue MIDI controller messages
 //  * Restart ADC convertion
@@ -1212,6 +859,8 @@ void scanAdc()
 		// enqueueSimpleCC(adcValCh0, 1);
 		adcValPrevCh0 = adcValCh0;
 	}
+	else
+		PurpleReign::Metrics::increment(PurpleReign::METRIC_CTRL_FILTERED);
 
 	// handle ADC channel 1 (modulation)
 	int adcValCh1 = adc_get_channel_value(ADC, ADC_CHANNEL_1); // Connected to modulation
@@ -1221,142 +870,666 @@ void scanAdc()
 		// enqueueSimpleCC(adcValCh1, 1);
 		adcValPrevCh1 = adcValCh1;
 	}
-	// handle ADC channel 2 (GP1)
-	int adcValCh2 = adc_get_channel_value(ADC, ADC_CHANNEL_2); // Connected to modulation
-	if (adcValCh2 != adcValPrevCh2)
-		// enqueueCC(ccNumGeneralPurpose1, adcValCh2, 1);
-		adcValPrevCh2 = adcValCh2;
-
-	// handle ADC channel 3 (GP2)
-	int adcValCh3 = adc_get_channel_value(ADC, ADC_CHANNEL_3); // Connected to modulation
-	if (adcValCh3 != adcValPrevCh3)
-		// enqueueCC(ccNumGeneralPurpose2, adcValCh3, 1);
-		adcValPrevCh3 = adcValCh3;
-
-	// handle ADC channel 4 (GP3)
-	int adcValCh4 = adc_get_channel_value(ADC, ADC_CHANNEL_4); // Connected to modulation
-	if (adcValCh4 != adcValPrevCh4)
-		// enqueueCC(ccNumGeneralPurpose3, adcValCh4, 1);
-		adcValPrevCh4 = adcValCh4;
-
-	// handle ADC channel 5 (GP4)
-	int adcValCh5 = adc_get_channel_value(ADC, ADC_CHANNEL_5); // Connected to modulation
-	if (adcValCh5 != adcValPrevCh5)
-		// enqueueCC(ccNumGeneralPurpose4, adcValCh5, 1);
-		adcValPrevCh5 = adcValCh5;
-
-	// Restart ADC conversion
-	adc_start(ADC);
+	else
+		PurpleReign::Metrics::increment(PurpleReign::METRIC_CTRL_FILTERED);
+	PurpleReign::Metrics::add(PurpleReign::METRIC_ADC_SAMPLES, 2);
+
+	// No restart of the ADC conversion needed, since conversions are triggered by the analogInputs timer. The general purpose controllers (formerly ADC channels 2-5) are on the muxes.
 }
 
 PurpleReign::Task adcTask(scanAdc, _tickDeltaADC);
 
-// send a MIDI note whenever possible, but not faster than every _nextTickMinor microsec.
-void sendMidi()
+// Faders and pots behind external 16:1 analog multiplexers, see PurpleReign::Adc. Select lines on PA13, PA12, PA11, PA10 (the unused Serial1/Serial2 pins).
+// The mux outputs are on ADC channels 2 and 3 (pins A5, A4). Up to two more muxes fit on ADC channels 4 and 5 (pins A3, A2).
+#ifdef KEYBED_ANALOG
+
+// Four muxes (ADC channels 2-5) carry the key position sensors, one input per key. Filled in by setup().
+const PurpleReign::analogMux_t analogMuxConfig = {4, {ADC_CHANNEL_2, ADC_CHANNEL_3, ADC_CHANNEL_4, ADC_CHANNEL_5}, {16, 17, 18, 19}};
+
+PurpleReign::analogInput_t analogInputConfig[keybed::analogNumKeys];
+
+#else
+
+const PurpleReign::analogMux_t analogMuxConfig = {2, {ADC_CHANNEL_2, ADC_CHANNEL_3}, {16, 17, 18, 19}};
+
+const PurpleReign::analogInput_t analogInputConfig[] = {
+	{0, 16, 1, PurpleReign::ANALOG_RATE_FAST},   // Mux 0: Faders, CC 16..31 (14-bit capable)
+	{1, 17, 1, PurpleReign::ANALOG_RATE_FAST},
+	{2, 18, 1, PurpleReign::ANALOG_RATE_FAST},
+	{3, 19, 1, PurpleReign::ANALOG_RATE_FAST},
+	{4, 20, 1, PurpleReign::ANALOG_RATE_FAST},
+	{5, 21, 1, PurpleReign::ANALOG_RATE_FAST},
+	{6, 22, 1, PurpleReign::ANALOG_RATE_FAST},
+	{7, 23, 1, PurpleReign::ANALOG_RATE_FAST},
+	{8, 24, 1, PurpleReign::ANALOG_RATE_FAST},
+	{9, 25, 1, PurpleReign::ANALOG_RATE_FAST},
+	{10, 26, 1, PurpleReign::ANALOG_RATE_FAST},
+	{11, 27, 1, PurpleReign::ANALOG_RATE_FAST},
+	{12, 28, 1, PurpleReign::ANALOG_RATE_FAST},
+	{13, 29, 1, PurpleReign::ANALOG_RATE_FAST},
+	{14, 30, 1, PurpleReign::ANALOG_RATE_FAST},
+	{15, 31, 1, PurpleReign::ANALOG_RATE_FAST},
+	{16, 102, 1, PurpleReign::ANALOG_RATE_NORMAL},  // Mux 1: Pots, CC 102..109
+	{17, 103, 1, PurpleReign::ANALOG_RATE_NORMAL},
+	{18, 104, 1, PurpleReign::ANALOG_RATE_NORMAL},
+	{19, 105, 1, PurpleReign::ANALOG_RATE_NORMAL},
+	{20, 106, 1, PurpleReign::ANALOG_RATE_NORMAL},
+	{21, 107, 1, PurpleReign::ANALOG_RATE_NORMAL},
+	{22, 108, 1, PurpleReign::ANALOG_RATE_NORMAL},
+	{23, 109, 1, PurpleReign::ANALOG_RATE_NORMAL},
+	{24, 110, 1, PurpleReign::ANALOG_RATE_SLOW},	  // Mux 1: Setup pots, CC 110..117
+	{25, 111, 1, PurpleReign::ANALOG_RATE_SLOW},
+	{26, 112, 1, PurpleReign::ANALOG_RATE_SLOW},
+	{27, 113, 1, PurpleReign::ANALOG_RATE_SLOW},
+	{28, 114, 1, PurpleReign::ANALOG_RATE_SLOW},
+	{29, 115, 1, PurpleReign::ANALOG_RATE_SLOW},
+	{30, 116, 1, PurpleReign::ANALOG_RATE_SLOW},
+	{31, 117, 1, PurpleReign::ANALOG_RATE_SLOW}
+};
+
+#endif
+
+PurpleReign::Adc analogInputs;
+
+void ADC_Handler()
 {
-	// togglePinB();
-	sendOldestMidiPacket();
-	MidiUSB.flush();
-	// togglePinB();
+	analogInputs.conversionInterrupt();
 }
 
-PurpleReign::Task midiTask(sendMidi, _tickDeltaMinor);
+#ifdef KEYBED_ANALOG
+uint16_t keyPosition(int keyAddress)
+{
+	return analogInputs.value(keyAddress);
+}
+#endif
 
-///// SETUP!!! ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
-void setup()
+PurpleReign::MidiCtrl midiCtrl;
+
+#ifdef MIDI_MERGE
+PurpleReign::MidiMerge midiMerge;
+int midiMergeSerialSource = -1;
+#ifdef MIDI_USB_THRU
+int midiMergeUsbSource = -1;
+
+void mergeUsbPacket(uint32_t packet)
 {
-	using namespace keybed;
+	midiMerge.receivePacket(midiMergeUsbSource, packet);
+}
+#endif
+#endif
 
-	initVelocityMap(velocityMap, EXP_8);
+#ifdef MIDI_DIN_OUTPUT
+PurpleReign::MidiSerialOut midiSerialOut;
 
-	delay(5000);
+bool sendDinEvent(const PurpleReign::midiEvent_t &event)
+{
+#ifndef MIDI_DIN_THRU
+	if (event.flags & PurpleReign::EVENT_FLAG_FROM_DIN)
+		return true; // Taken without sending, see MIDI_DIN_THRU
+#endif
+	return midiSerialOut.send(event);
+}
+#endif
 
-	SerialUSB.begin(115200); // Initialize serial debug port
-	SerialUSB.println("Serial debug port initialized!");
+#ifdef LOG_MIDI_TRACE
+bool traceEvent(const PurpleReign::midiEvent_t &event)
+{
+	SerialUSB.print(PurpleReign::Timebase::cyclesToMicros32(event.time));
+	SerialUSB.print(" T");
+	SerialUSB.print(event.type);
+	SerialUSB.print(" ch ");
+	SerialUSB.print(event.channel);
+	SerialUSB.print(" ix ");
+	SerialUSB.print(event.index);
+	SerialUSB.print(" d ");
+	SerialUSB.print(event.data);
+	SerialUSB.print(" v ");
+	SerialUSB.println(event.value);
+	return true;
+}
+#endif
 
-	dumpVelocityMap(velocityMap);
+// Pedals and panel buttons, see PurpleReign::DigitalInputs. Pins are on PIOA/PIOB, away from the keybed ports (PIOC, PIOD) and the scope pins (52, 53).
+const PurpleReign::digitalInput_t digitalInputConfig[] = {
+	{22, PurpleReign::INPUT_ACTION_CC, 64, 1, 1},			  // PB26: Sustain pedal
+	{23, PurpleReign::INPUT_ACTION_CC, 66, 1, 1},			  // PA14: Sostenuto pedal
+	{24, PurpleReign::INPUT_ACTION_CC, 67, 1, 1},			  // PA15: Soft pedal
+	{42, PurpleReign::INPUT_ACTION_PROGRAM_DOWN, 0, 1, 1}, // PA19: Program down button
+	{43, PurpleReign::INPUT_ACTION_PROGRAM_UP, 0, 1, 1}	  // PA20: Program up button
+};
 
-#if defined(LOG_KEYSWITCHES) || defined(LOG_MISSED_TICKS) || defined(PURE_DEBUG)
-	SerialUSB.begin(115200); // Initialize serial debug port
-	SerialUSB.println("Serial debug port initialized!");
+PurpleReign::DigitalInputs digitalInputs;
+
+// Rotary encoders, see PurpleReign::Encoders
+constexpr PurpleReign::encoder_t encoderConfig[] = {
+	{0, 74, 1, PurpleReign::ENCODER_ABSOLUTE, 4}, // TC0 (pins 2, 13): Filter cutoff (brightness)
+	{1, 16, 1, PurpleReign::ENCODER_RELATIVE, 4}  // TC2 (pins 5, 4): Macro (general purpose 1), relative. Remove with Keybed88Geometry, whose connector 2 uses these pins.
+};
+
+#ifndef KEYBED_ANALOG
+static_assert((PurpleReign::Encoders::pioCMask(encoderConfig, sizeof(encoderConfig) / sizeof(encoderConfig[0])) & keybed::geometry_t::colPortBitMask()) == 0, "An encoder decoder input is a keybed column input");
 #endif
 
-	////////////////////////////////////////////////////////////////
-	// Configure PIO
-	////////////////////////////////////////////////////////////////
+PurpleReign::Encoders encoders;
+
+void pollEncoders()
+{
+	encoders.poll();
+}
+
+PurpleReign::Task encoderTask(pollEncoders, _tickDeltaEncoders);
+
+#ifdef MIDI_CLOCK_OUTPUT
+
+PurpleReign::MidiClock midiClock;
+
+void TC3_Handler()
+{
+	midiClock.timerInterrupt();
+}
+
+#endif
+
+////////////////////////////////////
+// Configuration
+////////////////////////////////////
+
+PurpleReign::config_t config; // The active configuration, kept in step with all settings changes. This is what PurpleReign::ConfigStore::save() persists.
+bool configLoaded = false;	  // True if the configuration was loaded from flash at boot, false if the defaults are used
+
+// Factory defaults, used when there is no valid configuration block in flash
+void setDefaultConfig(PurpleReign::config_t &cfg)
+{
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.velocityCurveType = PurpleReign::EXP_8;
+	cfg.enable14BitCc = 0;
+	cfg.switchMuteMicros[keybed::velocityKeybed.MK] = 20 * PurpleReign::velocityStopWatchTickMicros;
+	cfg.switchMuteMicros[keybed::velocityKeybed.BK] = 20 * PurpleReign::velocityStopWatchTickMicros;
+
+	// Assign adcToControllerMapArray indices to controllers: the linear map to every CC (the mux faders and pots, CC 16..31 and 102..117, included), but modulation.
+	// N.B.! index 0 is reserved for Pitch Bend!
+	for (int cc = 0; cc < PurpleReign::configNumCcs; cc++)
+		cfg.ctrlMapIxPerCc[cc] = atcmIxLinear;
+	cfg.ctrlMapIxPerCc[ccNumModulation] = atcmIxModulation;
+
+	cfg.ctrlMap[atcmIxPitchbend] = {4, 0, {{0x16 << 5, 0}, {0x42 << 5, 8192}, {0x46 << 5, 8192}, {0x72 << 5, 16383}}}; // ADC value of 2048 is the center value with +/- 48 as "dead zone".
+	cfg.ctrlMap[atcmIxModulation] = {2, 0, {{0x1E << 5, 16383}, {0x44 << 5, 0}}};
+	cfg.ctrlMap[atcmIxLinear] = {2, 0, {{10, 0}, {4085, 16383}}};
+
+	cfg.numZones = 1; // One zone over the whole keybed
+	cfg.zone[0] = {0, PurpleReign::ZoneRouter::maxKeys - 1, keybed::defaultNoteChannel, keybed::defaultNoteOffset};
+}
+
+void applyCtrlMapConfig(ctrlSettings_t &settings, int mapIx)
+{
+	const PurpleReign::configCtrlMap_t &ctrlMap = config.ctrlMap[mapIx];
+	if (ctrlMap.numBorders < 2)
+		return; // Map not set
+	borderList_t borderList;
+	for (int border = 0; border < ctrlMap.numBorders; border++)
+	{
+		borderList[border].adcValue = ctrlMap.border[border].adcValue;
+		borderList[border].ctrlValue = ctrlMap.border[border].ctrlValue;
+	}
+	setAdcToCtrlMap(&settings.adcToCtrlMapArr[mapIx], ctrlMap.numBorders, borderList);
+}
+
+// Applies all of the active configuration
+void applyConfig()
+{
+	ctrlSettings_t &settings = ctrlSettings.edit();
+	settings.enable14BitCc = (config.enable14BitCc != 0);
+	for (int cc = 0; cc < PurpleReign::configNumCcs; cc++)
+		settings.atcmArrIxPerCC[cc] = config.ctrlMapIxPerCc[cc];
+	for (int mapIx = 0; mapIx < PurpleReign::configNumCtrlMaps; mapIx++)
+		applyCtrlMapConfig(settings, mapIx);
+	ctrlSettings.publish();
+
+	keybed::velocityCurve.select(config.velocityCurveType);
+	if (!keybed::zoneRouter.setZones(config.zone, config.numZones))
+		keybed::zoneRouter.setZones(nullptr, 0); // Only if the stored zones are invalid (the checksum matched, so this should not happen)
+	keybed::velocityKeybed.setSwitchMuteTime(keybed::velocityKeybed.MK, config.switchMuteMicros[keybed::velocityKeybed.MK]);
+	keybed::velocityKeybed.setSwitchMuteTime(keybed::velocityKeybed.BK, config.switchMuteMicros[keybed::velocityKeybed.BK]);
+}
 
-	// Initialize keybed scanning pins by making them all inactive
+static_assert(PurpleReign::configNumCtrlMaps == numAdcToCtrlMapArrElements, "One stored map per adcToCtrlMapArr element");
+static_assert(PurpleReign::configMaxNumCtrlMapBorders == adcToCtrlMap_t::maxNumAdcRangeBorders, "Stored maps hold as many borders as adcToCtrlMap_t");
+static_assert(PurpleReign::configNumCcs == highestCcNumber + 1, "A stored map index per CC");
+
+// Validates and applies a configuration SysEx message, see PurpleReign::MidiCtrl for the message format. Returns false if the message is invalid.
+bool applyConfigMessage(uint8_t command, const uint8_t *data, int length)
+{
+	using PurpleReign::MidiCtrl;
+
+	switch (command)
+	{
+	case MidiCtrl::CMD_SET_14BIT_CC:
+		if (length != 1)
+			return false;
+		config.enable14BitCc = (data[0] != 0);
+		ctrlSettings.edit().enable14BitCc = (config.enable14BitCc != 0);
+		ctrlSettings.publish();
+		return true;
+
+	case MidiCtrl::CMD_SELECT_VELOCITY_CURVE:
+		if (length != 1 || data[0] >= PurpleReign::NUM_VELOCITY_CURVES)
+			return false;
+		config.velocityCurveType = data[0];
+		keybed::velocityCurve.select(config.velocityCurveType);
+		return true;
+
+	case MidiCtrl::CMD_SET_SWITCH_MUTE_TIME:
+		if (length != 4 || data[0] > keybed::velocityKeybed.BK)
+			return false;
+		config.switchMuteMicros[data[0]] = MidiCtrl::unpack21(&data[1]);
+		keybed::velocityKeybed.setSwitchMuteTime(data[0], config.switchMuteMicros[data[0]]);
+		return true;
+
+	case MidiCtrl::CMD_ASSIGN_CC_MAP:
+		if (length != 2 || data[0] > highestCcNumber || data[1] >= numAdcToCtrlMapArrElements)
+			return false;
+		config.ctrlMapIxPerCc[data[0]] = data[1];
+		ctrlSettings.edit().atcmArrIxPerCC[data[0]] = data[1];
+		ctrlSettings.publish();
+		return true;
 
-	for (int row = 0; row < numRows; row++)
+	case MidiCtrl::CMD_SET_CTRL_MAP:
 	{
-		for (int mkbk = 0; mkbk < numSwitches; mkbk++)
+		if (length < 2)
+			return false;
+		int mapIx = data[0];
+		int numBorders = data[1];
+		if (mapIx >= numAdcToCtrlMapArrElements || numBorders < 2 || numBorders > adcToCtrlMap_t::maxNumAdcRangeBorders || length != 2 + (4 * numBorders))
+			return false;
+		PurpleReign::configCtrlMap_t ctrlMap;
+		ctrlMap.numBorders = numBorders;
+		ctrlMap.reserved = 0;
+		for (int border = 0; border < numBorders; border++)
 		{
-			int pin = rowPinList[row][mkbk];
-#ifdef DISABLE_HIZ
-			pinMode(pin, OUTPUT);
-			digitalWrite(pin, HIGH); // HIGH = inactive
-#else
-			pinMode(pin, INPUT);
-#endif
+			ctrlMap.border[border].adcValue = MidiCtrl::unpack14(&data[2 + (4 * border)]);
+			ctrlMap.border[border].ctrlValue = MidiCtrl::unpack14(&data[4 + (4 * border)]);
+			if (border > 0 && ctrlMap.border[border].adcValue <= ctrlMap.border[border - 1].adcValue)
+				return false; // ADC borders must be strictly increasing (or the slope is undefined)
 		}
+		for (int border = numBorders; border < PurpleReign::configMaxNumCtrlMapBorders; border++)
+			ctrlMap.border[border].adcValue = ctrlMap.border[border].ctrlValue = 0; // Keep the stored block deterministic
+		config.ctrlMap[mapIx] = ctrlMap;
+		applyCtrlMapConfig(ctrlSettings.edit(), mapIx);
+		ctrlSettings.publish();
+		return true;
 	}
 
-	// Configure column scan pins as inputs. Configure it without pullup resistors since an external buffer IC will be connected to input pins.
-	for (int con = 0; con < numConnectors; con++)
+	case MidiCtrl::CMD_STORE_CONFIG:
+		if (length != 0)
+			return false;
+		return PurpleReign::ConfigStore::save(config); // Stalls all tasks while the flash is written
+
+	case MidiCtrl::CMD_RESET_CONFIG:
+		if (length != 0)
+			return false;
+		setDefaultConfig(config);
+		applyConfig();
+		return true;
+
+	case MidiCtrl::CMD_SET_ZONES:
 	{
-		for (int col = 0; col < numCols; col++)
+		if (length < 1 || data[0] > PurpleReign::ZoneRouter::maxZones || length != 1 + (4 * data[0]))
+			return false;
+		PurpleReign::zone_t zones[PurpleReign::ZoneRouter::maxZones];
+		int numZones = data[0];
+		for (int zone = 0; zone < numZones; zone++)
 		{
-			int pin = colPinList[con][col];
-			pinMode(pin, INPUT);
+			zones[zone].lowKey = data[1 + (4 * zone)];
+			zones[zone].highKey = data[2 + (4 * zone)];
+			zones[zone].channel = data[3 + (4 * zone)];
+			zones[zone].noteOffset = data[4 + (4 * zone)] - 64;
 		}
+		if (!keybed::zoneRouter.setZones(zones, numZones))
+			return false;
+		config.numZones = numZones;
+		for (int zone = 0; zone < PurpleReign::ZoneRouter::maxZones; zone++)
+			config.zone[zone] = zone < numZones ? zones[zone] : PurpleReign::zone_t{0, 0, 0, 0};
+		return true;
 	}
 
-	// Enable row pin for very first row scan
+#ifdef ENABLE_CHATTER_STATS
+	case MidiCtrl::CMD_AUTOTUNE_MUTE_TIMES:
+	{
+		if (length != 6)
+			return false;
+		uint32_t minMuteMicros = MidiCtrl::unpack21(&data[0]);
+		uint32_t maxMuteMicros = MidiCtrl::unpack21(&data[3]);
+		if (minMuteMicros > maxMuteMicros)
+			return false;
+		keybed::velocityKeybed.autoTuneSwitchMuteTimes(minMuteMicros, maxMuteMicros);
+		return true;
+	}
+#endif
 
-	// int rowMkbk = 0;
-	// int row = rowMkbkLoopSeq[rowMkbk].row;
-	// int mkbk = rowMkbkLoopSeq[rowMkbk].mkbk;
-	// _rowPin=rowPinList[row][mkbk];
-	// activateRowPin(_rowPin);
+#ifdef METRICS_QUERY
+	case MidiCtrl::CMD_GET_METRICS:
+	{
+		if (length != 1 || data[0] > 1)
+			return false;
+		uint8_t reply[4 + PurpleReign::Metrics::sysexSnapshotLength + 1] = {0xF0, MidiCtrl::sysexManufacturerId, MidiCtrl::sysexProductId, MidiCtrl::CMD_GET_METRICS};
+		int replyLength = 4 + PurpleReign::Metrics::sysexSnapshot(&reply[4], PurpleReign::Metrics::sysexSnapshotLength);
+		reply[replyLength++] = 0xF7;
+		if (!midiQueue.pushSysex(reply, replyLength, PurpleReign::EVENT_FLAG_USB_ONLY, PurpleReign::Timebase::now32()))
+			return false; // No room, the host asks again
+		if (data[0] == 1)
+			PurpleReign::Metrics::resetPeaks();
+		return true;
+	}
+#endif
 
-	ROW_PORT_DISABLE_OUTPUT_DATA_REG = ROW_PORT_BIT_MASK; // Disable all row port bits (the mask is equal to all bits set to "1")
-	_rowPortBitPattern = ROW_PORT_INITIAL_BIT_PATTERN;	  // Now prepare to enable only the initial first row port bit (at the same time setting the global variable that will remember the pattern between various loops)...
-	ROW_PORT_ENABLE_OUTPUT_DATA_REG = _rowPortBitPattern; // ... and do it!
+#ifdef MIDI_CLOCK_OUTPUT
+	case MidiCtrl::CMD_SET_TEMPO:
+		if (length != 3)
+			return false;
+		midiClock.setTempo(MidiCtrl::unpack21(data));
+		return true;
 
-	// SerialUSB.print(_rowPortBitPattern,BIN);
-	// SerialUSB.println("::");
+	case MidiCtrl::CMD_TRANSPORT:
+		if (length != 1 || data[0] > 2)
+			return false;
+		if (data[0] == 0)
+			midiClock.stop();
+		else if (data[0] == 1)
+			midiClock.start();
+		else
+			midiClock.resume();
+		return true;
 
-	initPinA();
-	initPinB();
+	case MidiCtrl::CMD_TAP_TEMPO:
+		if (length != 0)
+			return false;
+		midiClock.tap();
+		return true;
+#endif
 
-	/////////////////////////////////////////////////////////////////////////
-	// Configure midi controller mappings
-	/////////////////////////////////////////////////////////////////////////
+	default:
+		return false; // Unknown command
+	}
+}
 
-	// Assign adcToControllerMapArray indices to controllers
-	// N.B.! index 0 is reserved for Pitch Bend!
-	atcmArrIxPerCC[ccNumModulation] = 1;
-	atcmArrIxPerCC[ccNumGeneralPurpose1] = 2;
-	atcmArrIxPerCC[ccNumGeneralPurpose2] = 2;
-	atcmArrIxPerCC[ccNumGeneralPurpose3] = 2;
-	atcmArrIxPerCC[ccNumGeneralPurpose3] = 2;
+void pollMidiIn()
+{
+	midiCtrl.poll(_midiInBytesPerTick);
+}
+
+PurpleReign::Task midiInTask(pollMidiIn, _tickDeltaMidiIn);
+
+#if PURE_LOG_LEVEL > 0
+void flushLog()
+{
+	if (SerialUSB) // Keep the records until the host has opened the port
+		PurpleReign::Log::flush(&SerialUSB, _logRecordsPerFlush);
+}
+
+PurpleReign::Task logFlushTask(flushLog, _tickDeltaLogFlush);
+#endif
+
+// Runtime metrics: Derives the scan rate gauge from the scan counter, and (with METRICS_QUERY) answers snapshot requests on SerialUSB:
+// the host sends metricsQueryByte (or metricsQueryResetByte, which also restarts the peak metrics) and gets a binary frame, see PurpleReign::Metrics.
+const uint8_t metricsQueryByte = 'M';
+const uint8_t metricsQueryResetByte = 'R';
+
+void updateMetrics()
+{
+	static uint32_t prevTime = PurpleReign::Timebase::now32();
+	static uint32_t prevScans = 0;
 
-	// TODO: Make these values part of a dynamic callibration procedure and store them in EEPROM or similar
+	uint32_t now = PurpleReign::Timebase::now32();
+	uint32_t elapsedMicros = PurpleReign::Timebase::cyclesToMicros32(now - prevTime);
+	if (elapsedMicros >= 1000000)
 	{
-		borderList_t tmpBorderList = {{0x16 << 5, 0}, {0x42 << 5, 8192}, {0x46 << 5, 8192}, {0x72 << 5, 16383}};
-		setAdcToCtrlMap(&adcToCtrlMapArr[atcmIxPitchbend], 4, tmpBorderList); // ADC value of 2048 is the center value with +/- 48 as "dead zone".
-		printCtrlMap(&adcToCtrlMapArr[1]);
+		uint32_t scans = PurpleReign::Metrics::value(PurpleReign::METRIC_KEYBED_SCANS);
+		PurpleReign::Metrics::set(PurpleReign::METRIC_KEYBED_SCAN_RATE, (uint64_t)(scans - prevScans) * 1000000 / elapsedMicros);
+		prevScans = scans;
+		prevTime = now;
 	}
+
+#ifdef METRICS_QUERY
+	while (SerialUSB.available() > 0)
 	{
-		borderList_t tmpBorderList = {{0x1E << 5, 16383}, {0x44 << 5, 0}};
-		setAdcToCtrlMap(&adcToCtrlMapArr[1], 2, tmpBorderList);
-		printCtrlMap(&adcToCtrlMapArr[1]);
+		int query = SerialUSB.read();
+		if (query == metricsQueryByte || query == metricsQueryResetByte)
+		{
+			PurpleReign::Metrics::sendFrame(&SerialUSB);
+			if (query == metricsQueryResetByte)
+				PurpleReign::Metrics::resetPeaks();
+		}
 	}
+#endif
+}
+
+PurpleReign::Task metricsTask(updateMetrics, _tickDeltaMetrics);
+
+#ifdef LOG_LATENCY_STATS
+
+void logLatencyStats()
+{
+	const PurpleReign::midiQueueStats_t &stats = midiQueue.stats();
+	SerialUSB.print("Latency:");
+	SerialUSB.print(midiQueue.constantLatency());
+	SerialUSB.print("us Released:");
+	SerialUSB.print(stats.released);
+	SerialUSB.print(" Missed_deadlines:");
+	SerialUSB.print(stats.missedDeadlines);
+	SerialUSB.print(" Max_lateness:");
+	SerialUSB.print(PurpleReign::Timebase::cyclesToMicros32(stats.maxLatenessCycles));
+	SerialUSB.println("us");
+}
+
+PurpleReign::Task latencyStatsTask(logLatencyStats, _tickDeltaLatencyStats);
+
+#endif
+
+#if defined(LOG_CHATTER_STATS) && defined(ENABLE_CHATTER_STATS)
+
+// One line per switch that has been closed: key address, switch (0 = MK, 1 = BK), closures, bounces, longest bounce and mute time
+void logChatterStats()
+{
+	using keybed::velocityKeybed;
+	for (int key = 0; key < keybed::geometry_t::numKeys; key++)
 	{
-		borderList_t tmpBorderList = {{10, 0}, {4085, 16383}};
-		setAdcToCtrlMap(&adcToCtrlMapArr[2], 2, tmpBorderList);
-		printCtrlMap(&adcToCtrlMapArr[1]);
+		for (int mkbk = 0; mkbk < keybed::geometry_t::numSwitches; mkbk++)
+		{
+			const PurpleReign::switchChatterStats_t &stats = velocityKeybed.chatterStats(mkbk, key);
+			if (stats.closures == 0)
+				continue;
+			SerialUSB.print("Key:");
+			SerialUSB.print(key);
+			SerialUSB.print(mkbk == velocityKeybed.MK ? " MK" : " BK");
+			SerialUSB.print(" Closures:");
+			SerialUSB.print(stats.closures);
+			SerialUSB.print(" Bounces:");
+			SerialUSB.print(stats.bounces);
+			SerialUSB.print(" Max_bounce:");
+			SerialUSB.print(PurpleReign::Timebase::cyclesToMicros32(stats.maxBounceCycles));
+			SerialUSB.print("us Mute:");
+			SerialUSB.print(velocityKeybed.switchMuteTime(mkbk, key));
+			SerialUSB.println("us");
+		}
 	}
+}
+
+PurpleReign::Task chatterStatsTask(logChatterStats, _tickDeltaChatterStats);
+
+#endif
+
+#if defined(LOG_CLOCK_STATS) && defined(MIDI_CLOCK_OUTPUT)
+
+// Clock jitter = timer interrupt jitter + variation of the delay from the interrupt to the USB write
+void logClockStats()
+{
+	const PurpleReign::midiClockStats_t &clockStats = midiClock.stats();
+	const PurpleReign::midiQueueStats_t &queueStats = midiQueue.stats();
+	uint32_t outputJitterCycles = queueStats.realtimeReleased ? queueStats.realtimeMaxDelayCycles - queueStats.realtimeMinDelayCycles : 0;
+	SerialUSB.print("Tempo:");
+	SerialUSB.print(midiClock.tempo());
+	SerialUSB.print(" Ticks:");
+	SerialUSB.print(clockStats.ticks);
+	SerialUSB.print(" Timer_jitter:");
+	SerialUSB.print(PurpleReign::Timebase::cyclesToMicros32(clockStats.maxTimerJitterCycles));
+	SerialUSB.print("us Output_jitter:");
+	SerialUSB.print(PurpleReign::Timebase::cyclesToMicros32(outputJitterCycles));
+	SerialUSB.print("us Realtime_dropped:");
+	SerialUSB.println(queueStats.realtimeDropped);
+}
+
+PurpleReign::Task clockStatsTask(logClockStats, _tickDeltaClockStats);
+
+#endif
+
+#if defined(LOG_GOVERNOR_STATS) && defined(CTRL_GOVERNOR)
+
+void logGovernorStats()
+{
+	const PurpleReign::ctrlGovernorStats_t &stats = ctrlGovernor.stats();
+	SerialUSB.print("Controllers passed:");
+	SerialUSB.print(stats.passed);
+	SerialUSB.print(" Throttled:");
+	SerialUSB.print(stats.throttled);
+	SerialUSB.print(" Headroom_throttled:");
+	SerialUSB.print(stats.headroomThrottled);
+	SerialUSB.print(" Coalesced:");
+	SerialUSB.print(stats.coalesced);
+	SerialUSB.print(" Released:");
+	SerialUSB.print(stats.released);
+	SerialUSB.print(" Untracked:");
+	SerialUSB.println(stats.untracked);
+}
+
+PurpleReign::Task governorStatsTask(logGovernorStats, _tickDeltaGovernorStats);
+
+#endif
+
+// Boot diagnostics, printed from setup() or, with PURE_FAST_BOOT, deferred until the keybed is already being scanned
+void printBootDiagnostics()
+{
+	SerialUSB.println("Serial debug port initialized!");
+	if (configLoaded)
+		PURE_LOG_INFO(PURE_LOG_CONFIG, CONFIG_LOADED);
+	else
+		PURE_LOG_INFO(PURE_LOG_CONFIG, CONFIG_DEFAULTS);
+	for (int mapIx = 0; mapIx < numAdcToCtrlMapArrElements; mapIx++)
+	{
+		if (config.ctrlMap[mapIx].numBorders >= 2)
+			logCtrlMap(&ctrlSettings.active().adcToCtrlMapArr[mapIx]);
+	}
+}
+
+#ifdef PURE_FAST_BOOT
+
+void runDeferredBootDiagnostics()
+{
+	static bool done = false;
+	if (done || PurpleReign::Timebase::nowMicros() < _deferredBootDiagnosticsMicros)
+		return;
+	printBootDiagnostics();
+	done = true;
+}
+
+PurpleReign::Task bootDiagnosticsTask(runDeferredBootDiagnostics, _tickDeltaBootDiagnostics);
+
+#endif
+
+///// SETUP!!! ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void setup()
+{
+	using namespace keybed;
+
+	PurpleReign::Timebase::init();
+
+#ifndef PURE_FAST_BOOT
+	delay(5000);
+#endif
+
+	SerialUSB.begin(115200); // Initialize serial debug port (does not wait for the host to open the port)
+
+	////////////////////////////////////////////////////////////////
+	// Configure PIO
+	////////////////////////////////////////////////////////////////
+
+	// Initialize keybed scanning pins (row port drive lines inactive, column port inputs) and enable the drive line for the very first row scan
+
+	midiQueue.init();
+	midiQueue.setConstantLatency(midiConstantLatencyMicros);
+#ifdef CTRL_GOVERNOR
+	ctrlGovernor.init(&midiQueue, ctrlGovernorNoteHeadroom);
+	ctrlGovernor.setDefaultRate(ctrlGovernorRate, ctrlGovernorBurst);
+	ctrlGovernor.setClassRate(ctrlGovernorClassRate, ctrlGovernorClassBurst);
+#endif
+	midiCtrl.setConfigFunction(applyConfigMessage);
+
+	keybedTask.setOverrunMetric(PurpleReign::METRIC_TASK_OVERRUNS_KEYBED);
+#ifdef KEYBED_ADAPTIVE_SCAN
+	keybedInFlightTask.setOverrunMetric(PurpleReign::METRIC_TASK_OVERRUNS_KEYBED_INFLIGHT);
+#endif
+	adcTask.setOverrunMetric(PurpleReign::METRIC_TASK_OVERRUNS_ADC);
+	encoderTask.setOverrunMetric(PurpleReign::METRIC_TASK_OVERRUNS_ENCODERS);
+	midiInTask.setOverrunMetric(PurpleReign::METRIC_TASK_OVERRUNS_MIDI_IN);
+#if PURE_LOG_LEVEL > 0
+	logFlushTask.setOverrunMetric(PurpleReign::METRIC_TASK_OVERRUNS_LOG_FLUSH);
+#endif
+#if defined(MIDI_MERGE) || defined(MIDI_DIN_OUTPUT)
+	Serial.begin(midiSerialBaudRate); // DIN MIDI input (RX) and output (TX)
+#endif
+#ifdef MIDI_DIN_OUTPUT
+	midiSerialOut.init(&Serial);
+	midiQueue.addSink(sendDinEvent);
+#endif
+#ifdef LOG_MIDI_TRACE
+	midiQueue.addSink(traceEvent);
+#endif
+#ifdef MIDI_MERGE
+	midiMerge.init(&midiQueue, midiMergeLimit);
+	midiMergeSerialSource = midiMerge.addSerialSource(&Serial, PurpleReign::MidiMerge::defaultQuota);
+	midiMerge.setSourceFlags(midiMergeSerialSource, PurpleReign::EVENT_FLAG_FROM_DIN);
+#ifdef MIDI_CLOCK_OUTPUT
+	midiMerge.setClockFilter(true); // The output clock is MidiClock's, so merged clock and transport messages are dropped instead of interleaved with it
+#endif
+#ifdef MIDI_USB_THRU
+	midiMergeUsbSource = midiMerge.addPacketSource(PurpleReign::MidiMerge::defaultQuota);
+	midiCtrl.setThruFunction(mergeUsbPacket);
+#endif
+#endif
+#ifdef MIDI_CLOCK_OUTPUT
+	midiClock.init(&midiQueue, midiClockInitialTempo);
+#endif
+	digitalInputs.init(digitalInputConfig, sizeof(digitalInputConfig) / sizeof(digitalInputConfig[0]), digitalInputDebounceMicros, &midiQueue);
+	encoders.setAbsoluteFunction(enqueueCcValue);
+	encoders.setRelativeFunction(enqueueCcRelative);
+	encoders.init(encoderConfig, sizeof(encoderConfig) / sizeof(encoderConfig[0]), encoderFilterMaxCycles);
+
+#ifdef KEYBED_ANALOG
+	analogKeybed.setVelocityCurve(&velocityCurve);
+	analogKeybed.setNoteOnFunction(noteOn);
+	analogKeybed.setNoteOffFunction(noteOff);
+	analogKeybed.setAftertouchFunction(aftertouch);
+	analogKeybed.setTriggerPoints(analogKeyTriggerPosition, analogKeyReleasePosition);
+	for (int key = 0; key < analogNumKeys; key++)
+		analogInputConfig[key] = {(uint8_t)key, PurpleReign::Adc::noCc, 0, PurpleReign::ANALOG_RATE_FAST};
+	// analogKeybed.init() takes the rest positions from the first samples, so it is called once the mux scan runs (see Configure ADC below)
+#else
+	velocityKeybed.setVelocityCurve(&velocityCurve);
+	velocityKeybed.setNoteOnFunction(noteOn);
+	velocityKeybed.setNoteOffFunction(noteOff);
+	velocityKeybed.init();
+#endif
+
+	initPinA();
+	initPinB();
+
+	/////////////////////////////////////////////////////////////////////////
+	// Load configuration (velocity curve, switch mute times, midi controller mappings)
+	/////////////////////////////////////////////////////////////////////////
+
+	configLoaded = PurpleReign::ConfigStore::load(config);
+	if (!configLoaded)
+		setDefaultConfig(config);
+	applyConfig();
 
 	/////////////////////////////////////////////////////////////////////////
 	// Configure ADC
@@ -1373,10 +1546,11 @@ void setup()
 		//  * Sets ADC_MR:STARTUP (based on uc_startup parameter)
 		//  ---------------------------------------
 		//  * Master Clock (MCK) = 84 MHz (VARIANT_MCK). Note: DUE external 12 MHz X-tal OSC multiplied by 7 through PLL/prescaler yields 84 MHz.
-		//  * ADC Clock = 1 MHz (ADC_FREQ_MIN) is good enough for ~100Hz sample rate on 16 channels (~1600 Hz ADC sample rate).
+		//  * ADC Clock = 20 MHz (ADC_FREQ_MAX). Each mux slot (see PurpleReign::Adc) converts all enabled channels, which must be done well within the slot period (~2 us per channel).
+		//    At 1 MHz (ADC_FREQ_MIN) a sequence of four channels would take ~80 us.
 		//  * Startup time = 0, since sleep mode will be disabled.
 
-		adc_init(ADC, VARIANT_MCK, ADC_FREQ_MIN, 0); // Note that doxygen comments for adc_init() erroneously refers to the formal parameter "ul_mck" as "main clock", but it really is "master clock".
+		adc_init(ADC, VARIANT_MCK, ADC_FREQ_MAX, 0); // Note that doxygen comments for adc_init() erroneously refers to the formal parameter "ul_mck" as "main clock", but it really is "master clock".
 
 		////////////////////////////////////////////////////////////////////////
 		//  ----------------------
@@ -1387,14 +1561,15 @@ void setup()
 		//  * 12-bit tracking time = 0.054 * Z_source + 205 (ns); where Z_source is source output impedance in ohms. See Atmel SAM3X data sheet section 45.7.2.1
 		//    - Assuming wire capacitance, inductance and resistance can be neglected (which might not be true!) Z_source comes only form the attached potentiometer, which are all around 10K ohm. If an analog input buffer is added between potentiometer and ADC input, the impedance will be a lot lower (equivalent to the output impedance of the buffer, a few 10's of ohms).
 		//    - Assuming 10K potentiometer without buffer circuit, Tracking time = 0.054 * 10,000 + 205 (ns) = 540 + 205 (ns) = 745 ns.
-		//      + Number of ADC clock cycles needed for tracking = 745 ns / (1 / ADC_FREQ [=1E6]) = (745 * 10E-9) s * (ADC_FREQ [=1E6]) Hz = 745 * 10E-3 = 0.745 (= 1 clock cycles, rounding up)
-		//      + Adjusting for 0-based value coding: 1 clock cycle is coded as 1 - 1 = 0.
+		//      + Number of ADC clock cycles needed for tracking = 745 ns / (1 / ADC_FREQ [=20E6]) = (745 * 10E-9) s * (ADC_FREQ [=20E6]) Hz = 14.9 (= 15 clock cycles, rounding up)
+		//      + Adjusting for 0-based value coding: 15 clock cycles is coded as 15 - 1 = 14.
+		//    - The on resistance of the analog muxes (~70 ohm for the 4067) is small compared to the potentiometers.
 		//
 		//  * Settling time: Probably irrelevant since ADC_MR:ANACH field (probably?) will be set to NONE since same analog configuration (probably?) will be used for all channels.
 		//
 		//  * Transfer time; Probably irrelevant since no DMA transfer will be used.
 
-		adc_configure_timing(ADC, 0, ADC_SETTLING_TIME_0, 0);
+		adc_configure_timing(ADC, 14, ADC_SETTLING_TIME_0, 0);
 
 		// Set ADC_MR:TRGEN to DIS (disable HW triggering and thus only allow SW triggering). Set ADC_MR:FREERUN to OFF (disable freerun mode).
 		adc_configure_trigger(ADC, ADC_TRIG_SW, ADC_MR_FREERUN_OFF);
@@ -1443,15 +1618,23 @@ void setup()
 
 		adcValPrevCh0 = adc_get_channel_value(ADC, ADC_CHANNEL_0); // Connected to pitch bend
 		adcValPrevCh1 = adc_get_channel_value(ADC, ADC_CHANNEL_1); // Connected to modulation wheel
-		adcValPrevCh2 = adc_get_channel_value(ADC, ADC_CHANNEL_2); // Connected to general purpose controller 1
-		adcValPrevCh3 = adc_get_channel_value(ADC, ADC_CHANNEL_3); // Connected to general purpose controller 2
-		adcValPrevCh4 = adc_get_channel_value(ADC, ADC_CHANNEL_4); // Connected to general purpose controller 3
-		adcValPrevCh5 = adc_get_channel_value(ADC, ADC_CHANNEL_5); // Connected to general purpose controller 4
+
+		// Enable the mux channels and start the timer triggered mux scan
+		analogInputs.setChangeFunction(enqueueCC);
+		analogInputs.init(analogMuxConfig, analogInputConfig, sizeof(analogInputConfig) / sizeof(analogInputConfig[0]), analogSlotMicros, analogChangeThreshold);
+#ifdef KEYBED_ANALOG
+		delayMicroseconds(2 * PurpleReign::Adc::muxAddresses * analogSlotMicros); // Let every key be sampled
+		keybed::analogKeybed.init(keybed::analogNumKeys, keyPosition, keybed::analogKeyDefaultSpan);
+#endif
 	}
 
+#ifndef PURE_FAST_BOOT
+	printBootDiagnostics();
+
 	delay(1000); // Wait for MIDI to stabilize
 
 	mynoteon(99, 99, 16); // Hello world!
+#endif
 
 	// _nextTickMajor = micros();												 // initiate next tick time = now
 	// _nextTickMinor = _nextTickMajor + _tickDeltaMinor; // At least in theory the very first _nextTickMinor will happen shortly after, but not exactly on, the first _nextTickMajor. Maybe put them in off-phase? Hmmm...
@@ -1461,7 +1644,41 @@ void setup()
 // THE LOOP!!! ////////////////////////////////////////////////////////////////////////////////////////////////////////
 void loop()
 {
-	keybedTask.schedule();
-	adcTask.schedule();
-	midiTask.schedule();
+	PurpleReign::cycles_t now = PurpleReign::Timebase::now(); // One time stamp for all tasks in this iteration
+
+	keybedTask.schedule(now);
+#ifdef KEYBED_ADAPTIVE_SCAN
+	keybedInFlightTask.schedule(now);
+#endif
+	adcTask.schedule(now);
+	encoderTask.schedule(now);
+	midiInTask.schedule(now);
+#if PURE_LOG_LEVEL > 0
+	logFlushTask.schedule(now);
+#endif
+	metricsTask.schedule(now);
+	digitalInputs.process(); // Returns at once when no input has changed
+	analogInputs.process();	 // Returns at once when no mux input has been sampled
+#ifdef CTRL_GOVERNOR
+	ctrlGovernor.process(); // Returns at once when no controller value is held back
+#endif
+#ifdef MIDI_MERGE
+	midiMerge.process(); // After the local producers, so the merge limit sees their packets
+#endif
+	midiQueue.pump(); // Returns at once when there is nothing to send (or release) or the USB endpoint is busy
+#ifdef LOG_LATENCY_STATS
+	latencyStatsTask.schedule(now);
+#endif
+#ifdef PURE_FAST_BOOT
+	bootDiagnosticsTask.schedule(now);
+#endif
+#if defined(LOG_CLOCK_STATS) && defined(MIDI_CLOCK_OUTPUT)
+	clockStatsTask.schedule(now);
+#endif
+#if defined(LOG_GOVERNOR_STATS) && defined(CTRL_GOVERNOR)
+	governorStatsTask.schedule(now);
+#endif
+#if defined(LOG_CHATTER_STATS) && defined(ENABLE_CHATTER_STATS)
+	chatterStatsTask.schedule(now);
+#endif
 }
\ No newline at end of file
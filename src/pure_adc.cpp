@@ -1,8 +1,173 @@
 #include "pure_adc.h"
 
+// The CMSIS ADC macro casts to the Adc register struct, which PurpleReign::Adc hides in its member functions
+static inline Adc *adcRegisters()
+{
+	return ADC;
+}
+
 using namespace PurpleReign;
 
-int PurpleReign::Adc::init()
+PurpleReign::Adc::Adc()
+{
+	m_mux.numMuxes = 0;
+	m_numSlots = 0;
+	m_slot = 0;
+	m_numInputs = 0;
+	m_reportedValidBM = 0;
+	m_threshold = 0;
+	for (int input = 0; input < maxInputs; input++)
+	{
+		m_inputIx[input] = -1;
+		m_value[input] = 0;
+	}
+	for (int word = 0; word < maxInputs / 32; word++)
+		m_updatedBM[word] = 0;
+	m_slotsConverted = 0;
+	m_changeFunction = nullptr;
+}
+
+inline void PurpleReign::Adc::selectAddress(int address)
+{
+	for (int line = 0; line < muxSelectLines; line++)
+	{
+		if (address & (1 << line))
+			m_selectPort[line]->PIO_SODR = m_selectMask[line];
+		else
+			m_selectPort[line]->PIO_CODR = m_selectMask[line];
+	}
+}
+
+int PurpleReign::Adc::init(const analogMux_t &mux, const analogInput_t *inputs, int numInputs, unsigned long slotMicros, uint16_t threshold)
 {
-	return 0;
-}
\ No newline at end of file
+	if (mux.numMuxes < 1 || mux.numMuxes > maxMuxes || numInputs > maxInputs)
+		return -1;
+	m_mux = mux;
+	m_threshold = threshold;
+
+	// Inputs, and the fastest rate class per mux address
+	uint8_t addressRateClass[muxAddresses];
+	for (int address = 0; address < muxAddresses; address++)
+		addressRateClass[address] = 0xFF; // Not visited
+	m_numInputs = numInputs;
+	for (int ix = 0; ix < numInputs; ix++)
+	{
+		const analogInput_t &input = inputs[ix];
+		if (input.input >= mux.numMuxes * muxAddresses || m_inputIx[input.input] >= 0)
+			return -1;
+		m_input[ix] = input;
+		m_inputIx[input.input] = ix;
+		int address = input.input % muxAddresses;
+		if (input.rateClass < addressRateClass[address])
+			addressRateClass[address] = input.rateClass;
+	}
+
+	// Slot schedule: each phase of the frame visits the addresses whose rate class samples in that phase
+	m_numSlots = 0;
+	for (int phase = 0; phase < framePhases; phase++)
+		for (int address = 0; address < muxAddresses; address++)
+			if (addressRateClass[address] == ANALOG_RATE_FAST ||
+				(addressRateClass[address] == ANALOG_RATE_NORMAL && phase % 2 == 0) ||
+				(addressRateClass[address] == ANALOG_RATE_SLOW && phase == 0))
+				m_slotAddress[m_numSlots++] = address;
+	if (m_numSlots == 0)
+		return -1;
+
+	// Select lines
+	for (int line = 0; line < muxSelectLines; line++)
+	{
+		const PinDescription &pinDescription = g_APinDescription[mux.selectPin[line]];
+		pinMode(mux.selectPin[line], OUTPUT);
+		m_selectPort[line] = pinDescription.pPort;
+		m_selectMask[line] = pinDescription.ulPin;
+	}
+	m_slot = 0;
+	selectAddress(m_slotAddress[0]); // Settles until the first trigger
+
+	// Mux channels, and the end of conversion interrupt of the last of them
+	::Adc *adc = adcRegisters();
+	int lastChannel = 0;
+	for (int mx = 0; mx < mux.numMuxes; mx++)
+	{
+		adc_enable_channel(adc, (adc_channel_num_t)mux.adcChannel[mx]);
+		if (mux.adcChannel[mx] > lastChannel)
+			lastChannel = mux.adcChannel[mx];
+	}
+	adc_configure_trigger(adc, ADC_TRIG_TIO_CH_2, 0);
+	adc->ADC_CDR[lastChannel]; // Clear any pending end of conversion
+	adc_enable_interrupt(adc, 1 << lastChannel);
+	NVIC_ClearPendingIRQ(ADC_IRQn);
+	NVIC_SetPriority(ADC_IRQn, 8); // Below the MIDI clock
+	NVIC_EnableIRQ(ADC_IRQn);
+
+	// Trigger timer: TIOA2 rises once per slot
+	uint32_t slotPeriod = (uint32_t)(((uint64_t)timerClockHz * slotMicros) / 1000000);
+	pmc_enable_periph_clk(ID_TC2); // TC0 channel 2
+	TC_Configure(TC0, 2, TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC | TC_CMR_TCCLKS_TIMER_CLOCK1 | TC_CMR_ACPA_CLEAR | TC_CMR_ACPC_SET);
+	TC_SetRA(TC0, 2, slotPeriod / 2);
+	TC_SetRC(TC0, 2, slotPeriod);
+	TC_Start(TC0, 2);
+	return m_numSlots;
+}
+
+void PurpleReign::Adc::setChangeFunction(void (*function)(uint8_t ccNum, uint16_t adcVal, uint8_t channel))
+{
+	m_changeFunction = function;
+}
+
+// Interrupt context
+void PurpleReign::Adc::conversionInterrupt()
+{
+	::Adc *adc = adcRegisters();
+	int address = m_slotAddress[m_slot];
+	if (++m_slot == m_numSlots)
+		m_slot = 0;
+	selectAddress(m_slotAddress[m_slot]); // The next address settles from now until the next trigger
+
+	for (int mx = 0; mx < m_mux.numMuxes; mx++)
+	{
+		int input = mx * muxAddresses + address;
+		m_value[input] = adc->ADC_CDR[m_mux.adcChannel[mx]] & 0x0FFF; // Reading the data register also clears the end of conversion flag
+		m_updatedBM[input >> 5] = m_updatedBM[input >> 5] | (1u << (input & 31));
+	}
+	m_slotsConverted = m_slotsConverted + 1;
+	Metrics::add(METRIC_ADC_SAMPLES, m_mux.numMuxes);
+}
+
+void PurpleReign::Adc::process()
+{
+	for (int word = 0; word < maxInputs / 32; word++)
+	{
+		if (m_updatedBM[word] == 0)
+			continue;
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		uint32_t updatedBM = m_updatedBM[word];
+		m_updatedBM[word] = 0;
+		__set_PRIMASK(primask);
+
+		while (updatedBM)
+		{
+			int input = word * 32 + __builtin_ctz(updatedBM);
+			updatedBM &= updatedBM - 1;
+			int ix = m_inputIx[input];
+			if (ix < 0 || m_input[ix].ccNum == noCc)
+				continue; // Sampled along with a used input of another mux, or not reported
+			uint16_t value = m_value[input];
+			uint64_t ixBit = ((uint64_t)1) << ix;
+			if (!(m_reportedValidBM & ixBit))
+			{
+				m_reportedValidBM |= ixBit;
+				m_reported[ix] = value;
+			}
+			else if (abs((int)value - (int)m_reported[ix]) > m_threshold)
+			{
+				m_reported[ix] = value;
+				if (m_changeFunction)
+					m_changeFunction(m_input[ix].ccNum, value, m_input[ix].channel);
+			}
+			else
+				Metrics::increment(METRIC_CTRL_FILTERED); // Within the noise threshold
+		}
+	}
+}
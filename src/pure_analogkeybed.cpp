@@ -0,0 +1,198 @@
+#include <pure_analogkeybed.h>
+
+using namespace PurpleReign;
+
+PurpleReign::AnalogKeybed::AnalogKeybed()
+{
+	m_numKeys = 0;
+	m_positionFunction = nullptr;
+	for (int key = 0; key < maxKeys; key++)
+	{
+		m_rest[key] = 0;
+		m_span[key] = 1;
+		m_keyState[key] = RELEASED;
+		m_pressure[key] = 0;
+		m_smoothedPosition[key] = 0;
+		for (int ix = 0; ix < derivativeSamples; ix++)
+			m_position[ix][key] = 0;
+	}
+	for (int ix = 0; ix < derivativeSamples; ix++)
+		m_scanTime[ix] = 0;
+	m_scanIx = 0;
+	m_triggerPosition = analogKeyPositionMax / 2;
+	m_releasePosition = analogKeyPositionMax * 3 / 8;
+	m_velocityTravel = analogKeyPositionMax / 4; // About the distance between the BK and MK switches of a switch based keybed
+	m_aftertouchStart = analogKeyPositionMax * 33 / 32; // A key resting on the bottom with normal force has no pressure
+	m_aftertouchFull = analogKeyPositionMax * 9 / 8;
+	m_eventTime = 0;
+	m_eventStopwatch = velocityStopWatchMaxValue << velocityStopWatchFracBits;
+	m_releaseVelocity = 64;
+	m_velocityCurve = nullptr;
+	m_noteOnFunction = nullptr;
+	m_noteOffFunction = nullptr;
+	m_aftertouchFunction = nullptr;
+}
+
+void PurpleReign::AnalogKeybed::init(int numKeys, uint16_t (*positionFunction)(int key), int defaultSpan)
+{
+	if (numKeys > maxKeys)
+		numKeys = maxKeys;
+	m_numKeys = numKeys;
+	m_positionFunction = positionFunction;
+	uint32_t now = Timebase::now32();
+	for (int ix = 0; ix < derivativeSamples; ix++)
+		m_scanTime[ix] = now;
+	for (int key = 0; key < numKeys; key++)
+	{
+		m_rest[key] = m_positionFunction(key);
+		m_span[key] = defaultSpan != 0 ? defaultSpan : 1;
+		for (int ix = 0; ix < derivativeSamples; ix++)
+			m_position[ix][key] = 0;
+	}
+}
+
+void PurpleReign::AnalogKeybed::setCalibration(int key, uint16_t rest, uint16_t bottom)
+{
+	if (key >= maxKeys || rest == bottom)
+		return;
+	m_rest[key] = rest;
+	m_span[key] = (int)bottom - (int)rest;
+}
+
+void PurpleReign::AnalogKeybed::setVelocityCurve(const VelocityCurve *velocityCurve)
+{
+	m_velocityCurve = velocityCurve;
+}
+
+void PurpleReign::AnalogKeybed::setNoteOnFunction(void (*function)(int keyAddress, uint8_t velocity))
+{
+	m_noteOnFunction = function;
+}
+
+void PurpleReign::AnalogKeybed::setNoteOffFunction(void (*function)(int keyAddress))
+{
+	m_noteOffFunction = function;
+}
+
+void PurpleReign::AnalogKeybed::setAftertouchFunction(void (*function)(int keyAddress, uint8_t pressure))
+{
+	m_aftertouchFunction = function;
+}
+
+bool PurpleReign::AnalogKeybed::setTriggerPoints(int triggerPosition, int releasePosition)
+{
+	if (releasePosition <= 0 || releasePosition >= triggerPosition || triggerPosition >= analogKeyPositionMax)
+		return false;
+	m_triggerPosition = triggerPosition;
+	m_releasePosition = releasePosition;
+	return true;
+}
+
+void PurpleReign::AnalogKeybed::setVelocityTravel(int travel)
+{
+	if (travel > 0)
+		m_velocityTravel = travel;
+}
+
+bool PurpleReign::AnalogKeybed::setAftertouchRange(int startPosition, int fullPosition)
+{
+	if (startPosition <= m_triggerPosition || fullPosition <= startPosition)
+		return false;
+	m_aftertouchStart = startPosition;
+	m_aftertouchFull = fullPosition;
+	return true;
+}
+
+inline int PurpleReign::AnalogKeybed::normalize(int key, int raw)
+{
+	int position = ((raw - m_rest[key]) * analogKeyPositionMax) / m_span[key];
+	return position < 0 ? 0 : position; // Noise around the rest value reads as rest. Positions beyond the bottom are kept, for aftertouch.
+}
+
+// Velocity of the key at the crossing of crossingPosition between the previous and the latest scan. Also sets m_eventTime to the (interpolated) crossing time,
+// and m_eventStopwatch to the unrounded stopwatch value.
+uint8_t PurpleReign::AnalogKeybed::crossingVelocity(int key, int crossingPosition, int travel, uint32_t now)
+{
+	int prevIx = (m_scanIx - 1) & (derivativeSamples - 1);
+	int oldestIx = (m_scanIx + 1) & (derivativeSamples - 1);
+	int prevPosition = m_position[prevIx][key];
+	int position = m_position[m_scanIx][key];
+	uint32_t prevTime = m_scanTime[prevIx];
+	m_eventTime = prevTime + (uint32_t)(((int64_t)(crossingPosition - prevPosition) * (int32_t)(now - prevTime)) / (position - prevPosition)); // position != prevPosition, since the crossing is between them
+
+	// Stopwatch value of the equivalent switch based measurement: the time to travel m_velocityTravel at the speed over the derivative window. 1 = min, velocityStopWatchMaxValue = max.
+	int distance = position - m_position[oldestIx][key];
+	if (distance < 0)
+		distance = -distance;
+	uint32_t stopwatch = velocityStopWatchMaxValue;
+	m_eventStopwatch = velocityStopWatchMaxValue << velocityStopWatchFracBits;
+	if (distance > 0)
+	{
+		const uint32_t stopwatchTickCycles = Timebase::microsToCycles32(velocityStopWatchTickMicros);
+		uint64_t travelCycles = ((uint64_t)(now - m_scanTime[oldestIx]) * travel) / distance;
+		if (travelCycles < (uint64_t)velocityStopWatchMaxValue * stopwatchTickCycles)
+		{
+			stopwatch = 1 + (uint32_t)((travelCycles + (stopwatchTickCycles / 2)) / stopwatchTickCycles);
+			m_eventStopwatch = (1 << velocityStopWatchFracBits) + (uint32_t)((travelCycles << velocityStopWatchFracBits) / stopwatchTickCycles);
+		}
+		if (stopwatch > velocityStopWatchMaxValue)
+			stopwatch = velocityStopWatchMaxValue;
+		if (m_eventStopwatch > (velocityStopWatchMaxValue << velocityStopWatchFracBits))
+			m_eventStopwatch = velocityStopWatchMaxValue << velocityStopWatchFracBits;
+	}
+	return m_velocityCurve->velocity(stopwatch);
+}
+
+void PurpleReign::AnalogKeybed::scan()
+{
+	uint32_t now = Timebase::now32();
+	m_scanIx = (m_scanIx + 1) & (derivativeSamples - 1);
+	m_scanTime[m_scanIx] = now;
+	int prevIx = (m_scanIx - 1) & (derivativeSamples - 1);
+
+	for (int key = 0; key < m_numKeys; key++)
+	{
+		int position = normalize(key, m_positionFunction(key));
+		m_position[m_scanIx][key] = position;
+		int prevPosition = m_position[prevIx][key];
+
+		if (m_keyState[key] == RELEASED)
+		{
+			if (position >= m_triggerPosition && prevPosition < m_triggerPosition)
+			{
+				uint8_t velocity = crossingVelocity(key, m_triggerPosition, m_velocityTravel, now);
+				m_keyState[key] = PRESSED;
+				m_smoothedPosition[key] = position << aftertouchSmoothingShift;
+				m_noteOnFunction(key, velocity);
+			}
+		}
+		else if (position <= m_releasePosition)
+		{
+			if (m_pressure[key] != 0)
+			{
+				m_pressure[key] = 0;
+				if (m_aftertouchFunction)
+					m_aftertouchFunction(key, 0);
+			}
+			m_releaseVelocity = crossingVelocity(key, m_releasePosition, m_velocityTravel, now);
+			m_keyState[key] = RELEASED;
+			m_noteOffFunction(key);
+		}
+		else if (m_aftertouchFunction)
+		{
+			m_smoothedPosition[key] += position - (m_smoothedPosition[key] >> aftertouchSmoothingShift);
+			int smoothedPosition = m_smoothedPosition[key] >> aftertouchSmoothingShift;
+			int pressure = 0;
+			if (smoothedPosition > m_aftertouchStart)
+				pressure = ((smoothedPosition - m_aftertouchStart) * 127) / (m_aftertouchFull - m_aftertouchStart);
+			if (pressure > 127)
+				pressure = 127;
+			int change = pressure - m_pressure[key];
+			if (change != 0 && (change >= aftertouchHysteresis || change <= -aftertouchHysteresis || pressure == 0 || pressure == 127))
+			{
+				m_pressure[key] = pressure;
+				m_aftertouchFunction(key, pressure);
+			}
+		}
+	}
+}
@@ -0,0 +1,63 @@
+#include <pure_config.h>
+
+using namespace PurpleReign;
+
+// Bitwise CRC-32 (IEEE 802.3, reflected). No table, since it only runs at boot and on save.
+uint32_t PurpleReign::ConfigStore::checksum(const config_t &config)
+{
+	const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&config);
+	uint32_t crc = 0xFFFFFFFF;
+	for (size_t ix = 0; ix < offsetof(config_t, checksum); ix++)
+	{
+		crc ^= bytes[ix];
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+	}
+	return ~crc;
+}
+
+bool PurpleReign::ConfigStore::isValid(const config_t &config)
+{
+	return config.magic == configMagic && config.version == configVersion && config.size == sizeof(config_t) && config.checksum == checksum(config);
+}
+
+bool PurpleReign::ConfigStore::load(config_t &config)
+{
+	const config_t *stored = reinterpret_cast<const config_t *>(address);
+	if (!isValid(*stored))
+		return false;
+	config = *stored;
+	return true;
+}
+
+bool PurpleReign::ConfigStore::save(const config_t &config)
+{
+	static uint32_t pageBuffer[IFLASH1_PAGE_SIZE / 4]; // Whole pages, so the (word addressed) flash latch buffer is always completely written
+
+	config_t copy = config;
+	copy.magic = configMagic;
+	copy.version = configVersion;
+	copy.size = sizeof(config_t);
+	copy.checksum = checksum(copy);
+
+	const uint8_t *source = reinterpret_cast<const uint8_t *>(&copy);
+	for (uint32_t page = 0; page < numPages; page++)
+	{
+		uint32_t offset = page * IFLASH1_PAGE_SIZE;
+		uint32_t length = sizeof(config_t) - offset < IFLASH1_PAGE_SIZE ? sizeof(config_t) - offset : IFLASH1_PAGE_SIZE;
+		memset(pageBuffer, 0xFF, sizeof(pageBuffer));
+		memcpy(pageBuffer, source + offset, length);
+
+		// Fill the latch buffer by writing the page address range (32-bit writes only), then erase and write the page
+		volatile uint32_t *flashPage = reinterpret_cast<volatile uint32_t *>(address + offset);
+		for (uint32_t ix = 0; ix < IFLASH1_PAGE_SIZE / 4; ix++)
+			flashPage[ix] = pageBuffer[ix];
+
+		uint32_t pageNumber = (address + offset - IFLASH1_ADDR) / IFLASH1_PAGE_SIZE; // Page number within bank 1
+		if (efc_perform_command(EFC1, EFC_FCMD_CLB, pageNumber) != 0)			  // Clear the lock bit of the region (a no-op if not locked)
+			return false;
+		if (efc_perform_command(EFC1, EFC_FCMD_EWP, pageNumber) != 0)
+			return false;
+	}
+	return isValid(*reinterpret_cast<const config_t *>(address));
+}
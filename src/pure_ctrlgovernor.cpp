@@ -0,0 +1,207 @@
+#include <pure_ctrlgovernor.h>
+
+using namespace PurpleReign;
+
+PurpleReign::CtrlGovernor::CtrlGovernor()
+{
+	m_queue = nullptr;
+	m_controllerLimit = MidiQueue::queueSize;
+	m_numSlots = 0;
+	m_numPending = 0;
+	m_nextPending = 0;
+	m_defaultRate = 0;
+	m_defaultBurst = 1;
+	initBucket(m_classBucket, 0, 1);
+	resetStats();
+}
+
+void PurpleReign::CtrlGovernor::init(MidiQueue *queue, int noteHeadroom)
+{
+	m_queue = queue;
+	if (noteHeadroom < MidiQueue::noteReserve)
+		noteHeadroom = MidiQueue::noteReserve; // Hold controllers back before the queue would shed them
+	if (noteHeadroom > MidiQueue::queueSize - 1)
+		noteHeadroom = MidiQueue::queueSize - 1;
+	m_controllerLimit = MidiQueue::queueSize - noteHeadroom;
+	m_numSlots = 0;
+	m_numPending = 0;
+	m_nextPending = 0;
+	resetStats();
+}
+
+void PurpleReign::CtrlGovernor::resetStats()
+{
+	m_stats = ctrlGovernorStats_t{0, 0, 0, 0, 0, 0};
+	for (int ix = 0; ix < m_numSlots; ix++)
+		m_slot[ix].throttled = 0;
+}
+
+void PurpleReign::CtrlGovernor::initBucket(bucket_t &bucket, uint32_t rate, uint8_t burst)
+{
+	if (rate != 0 && rate < minRate)
+		rate = minRate;
+	if (burst < 1)
+		burst = 1;
+	if (burst > maxBurst)
+		burst = maxBurst;
+	bucket.cost = rate ? Timebase::microsToCycles32(1000000 / rate) : 0;
+	bucket.capacity = bucket.cost * burst;
+	bucket.credit = bucket.capacity; // Start full
+	bucket.lastRefill = Timebase::now();
+}
+
+inline void PurpleReign::CtrlGovernor::refill(bucket_t &bucket, cycles_t now)
+{
+	cycles_t elapsed = now - bucket.lastRefill;
+	bucket.lastRefill = now;
+	if (elapsed >= bucket.capacity - bucket.credit)
+		bucket.credit = bucket.capacity;
+	else
+		bucket.credit += (uint32_t)elapsed;
+}
+
+void PurpleReign::CtrlGovernor::setClassRate(uint32_t rate, uint8_t burst)
+{
+	initBucket(m_classBucket, rate, burst);
+}
+
+void PurpleReign::CtrlGovernor::setDefaultRate(uint32_t rate, uint8_t burst)
+{
+	m_defaultRate = rate;
+	m_defaultBurst = burst;
+}
+
+bool PurpleReign::CtrlGovernor::setControllerRate(uint8_t type, uint8_t channel, uint8_t index, uint32_t rate, uint8_t burst)
+{
+	slot_t *slot = findSlot(makeKey(type, channel, index), true);
+	if (slot == nullptr)
+		return false;
+	slot->configured = true;
+	initBucket(slot->bucket, rate, burst);
+	return true;
+}
+
+bool PurpleReign::CtrlGovernor::isGoverned(const midiEvent_t &event)
+{
+	return event.type == EVENT_CONTROL_CHANGE || event.type == EVENT_PITCH_BEND || event.type == EVENT_CHANNEL_PRESSURE || event.type == EVENT_POLY_PRESSURE;
+}
+
+PurpleReign::CtrlGovernor::slot_t *PurpleReign::CtrlGovernor::findSlot(uint32_t key, bool allocate)
+{
+	for (int ix = 0; ix < m_numSlots; ix++)
+		if (m_slot[ix].key == key)
+			return &m_slot[ix];
+	if (!allocate)
+		return nullptr;
+
+	slot_t *slot = nullptr;
+	if (m_numSlots < maxControllers)
+		slot = &m_slot[m_numSlots++];
+	else
+	{ // Reuse the slot of an idle controller: nothing held back, and a full bucket (so the controller has not been throttled lately)
+		cycles_t now = Timebase::now();
+		for (int ix = 0; ix < m_numSlots && slot == nullptr; ix++)
+		{
+			slot_t &candidate = m_slot[ix];
+			if (candidate.configured || candidate.pending)
+				continue;
+			refill(candidate.bucket, now);
+			if (candidate.bucket.credit == candidate.bucket.capacity)
+				slot = &candidate;
+		}
+		if (slot == nullptr)
+			return nullptr;
+	}
+	slot->key = key;
+	slot->configured = false;
+	slot->pending = false;
+	slot->throttled = 0;
+	initBucket(slot->bucket, m_defaultRate, m_defaultBurst);
+	return slot;
+}
+
+int PurpleReign::CtrlGovernor::admit(slot_t &slot, cycles_t now)
+{
+	if (m_queue->fill() >= m_controllerLimit) // Of all outputs: a slow sink (e.g. DIN) fills the queue just as much as USB
+		return 2;
+	refill(slot.bucket, now);
+	refill(m_classBucket, now);
+	if (slot.bucket.credit < slot.bucket.cost || m_classBucket.credit < m_classBucket.cost)
+		return 1;
+	slot.bucket.credit -= slot.bucket.cost;
+	m_classBucket.credit -= m_classBucket.cost;
+	return 0;
+}
+
+void PurpleReign::CtrlGovernor::push(const midiEvent_t &event)
+{
+	if (!isGoverned(event))
+	{
+		m_queue->push(event); // Not a controller
+		return;
+	}
+	uint8_t index = (event.type == EVENT_CONTROL_CHANGE || event.type == EVENT_POLY_PRESSURE) ? event.index : 0;
+	slot_t *slot = findSlot(makeKey(event.type, event.channel, index), true);
+	if (slot == nullptr)
+	{
+		m_stats.untracked++;
+		emit(event);
+		return;
+	}
+	if (slot->pending)
+	{ // Keep the order: the newer value waits in place of the older one
+		slot->event = event;
+		m_stats.coalesced++;
+		Metrics::increment(METRIC_CTRL_FILTERED);
+		return;
+	}
+	int result = admit(*slot, Timebase::now());
+	if (result == 0)
+	{
+		m_stats.passed++;
+		emit(event);
+		return;
+	}
+	slot->event = event;
+	slot->pending = true;
+	slot->throttled++;
+	m_numPending++;
+	if (result == 2)
+		m_stats.headroomThrottled++;
+	else
+		m_stats.throttled++;
+}
+
+void PurpleReign::CtrlGovernor::process()
+{
+	if (m_numPending == 0)
+		return;
+	cycles_t now = Timebase::now();
+	int start = m_nextPending; // The scan covers each slot at most once, from here
+	int next = start;
+	for (int count = 0; count < m_numSlots && m_numPending > 0; count++)
+	{
+		int ix = (start + count) % m_numSlots;
+		slot_t &slot = m_slot[ix];
+		if (!slot.pending)
+			continue;
+		int result = admit(slot, now);
+		if (result == 2)
+			break; // No headroom, so none of the others can go either
+		if (result != 0)
+			continue; // This controller is still over its budget (or the class is, then the others fail as well, cheaply)
+		slot.pending = false;
+		m_numPending--;
+		m_stats.released++;
+		slot.event.time = Timebase::now32(); // Stamped when sent, a late value is not a late capture
+		emit(slot.event);
+		next = (ix + 1) % m_numSlots;
+	}
+	m_nextPending = next; // Round-robin: start after the last released slot, so a busy controller can not keep the others waiting
+}
+
+uint32_t PurpleReign::CtrlGovernor::controllerThrottled(uint8_t type, uint8_t channel, uint8_t index)
+{
+	slot_t *slot = findSlot(makeKey(type, channel, index), false);
+	return slot ? slot->throttled : 0;
+}
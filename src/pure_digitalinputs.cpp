@@ -0,0 +1,112 @@
+#include <pure_digitalinputs.h>
+
+using namespace PurpleReign;
+
+DigitalInputs *PurpleReign::DigitalInputs::s_instance = nullptr;
+
+template <int Input>
+void PurpleReign::DigitalInputs::edgeInterrupt()
+{
+	s_instance->edge(Input);
+}
+
+PurpleReign::DigitalInputs::DigitalInputs()
+{
+	m_numInputs = 0;
+	m_program = 0;
+	m_queue = nullptr;
+	m_eventHead = 0;
+	m_eventTail = 0;
+	m_eventsDropped = 0;
+}
+
+bool PurpleReign::DigitalInputs::init(const digitalInput_t *inputs, int numInputs, unsigned long debounceMicros, MidiQueue *queue)
+{
+	static void (*const edgeInterrupts[maxInputs])() = {&edgeInterrupt<0>, &edgeInterrupt<1>, &edgeInterrupt<2>, &edgeInterrupt<3>,
+														 &edgeInterrupt<4>, &edgeInterrupt<5>, &edgeInterrupt<6>, &edgeInterrupt<7>};
+
+	if (numInputs > maxInputs)
+		return false;
+	s_instance = this;
+	m_queue = queue;
+	m_numInputs = numInputs;
+
+	// Debounce filter: Pulses shorter than half a period of the divided slow clock (32768 Hz / (2 * (DIV + 1))) are rejected
+	uint32_t slowClockDivider = ((uint64_t)debounceMicros * 32768) / (2 * 1000000);
+	if (slowClockDivider > 0)
+		slowClockDivider--;
+	if (slowClockDivider > 0x3FFF)
+		slowClockDivider = 0x3FFF;
+
+	for (int input = 0; input < numInputs; input++)
+	{
+		m_input[input] = inputs[input];
+		const PinDescription &pinDescription = g_APinDescription[m_input[input].pin];
+		pinMode(m_input[input].pin, INPUT_PULLUP);
+		pinDescription.pPort->PIO_SCDR = slowClockDivider;
+		pinDescription.pPort->PIO_DIFSR = pinDescription.ulPin; // Debounce filter (instead of glitch filter)...
+		pinDescription.pPort->PIO_IFER = pinDescription.ulPin;	// ... enabled
+		bool level = (pinDescription.pPort->PIO_PDSR & pinDescription.ulPin) != 0;
+		m_active[input] = (level != (m_input[input].activeLow != 0)); // Initial state, not reported
+		attachInterrupt(m_input[input].pin, edgeInterrupts[input], CHANGE);
+	}
+	return true;
+}
+
+// Interrupt context
+void PurpleReign::DigitalInputs::edge(int input)
+{
+	const PinDescription &pinDescription = g_APinDescription[m_input[input].pin];
+	uint8_t head = m_eventHead;
+	if ((uint8_t)(head - m_eventTail) == eventQueueSize)
+	{
+		m_eventsDropped = m_eventsDropped + 1;
+		return;
+	}
+	edgeEvent_t &event = m_event[head & (eventQueueSize - 1)];
+	event.time = Timebase::now32();
+	event.input = input;
+	event.level = (pinDescription.pPort->PIO_PDSR & pinDescription.ulPin) != 0;
+	m_eventHead = head + 1;
+}
+
+void PurpleReign::DigitalInputs::process()
+{
+	while (m_eventTail != m_eventHead)
+	{
+		const edgeEvent_t &event = m_event[m_eventTail & (eventQueueSize - 1)];
+		bool active = (event.level != 0) != (m_input[event.input].activeLow != 0);
+		if (active != (m_active[event.input] != 0))
+		{
+			m_active[event.input] = active;
+			activate(event.input, active, event.time);
+		}
+		m_eventTail = m_eventTail + 1;
+	}
+}
+
+void PurpleReign::DigitalInputs::activate(int input, bool active, uint32_t time)
+{
+	const digitalInput_t &config = m_input[input];
+	switch (config.action)
+	{
+	case INPUT_ACTION_CC:
+		m_queue->push(MidiEvent::controlChange7(config.channel, config.number, active ? 127 : 0, time));
+		return;
+	case INPUT_ACTION_PROGRAM:
+	case INPUT_ACTION_PROGRAM_UP:
+	case INPUT_ACTION_PROGRAM_DOWN:
+		if (!active)
+			return;
+		if (config.action == INPUT_ACTION_PROGRAM)
+			m_program = config.number;
+		else if (config.action == INPUT_ACTION_PROGRAM_UP)
+			m_program = (m_program + 1) & 0x7F;
+		else
+			m_program = (m_program - 1) & 0x7F;
+		m_queue->push(MidiEvent::programChange(config.channel, m_program, time));
+		return;
+	default:
+		return;
+	}
+}
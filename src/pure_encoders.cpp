@@ -0,0 +1,109 @@
+#include <pure_encoders.h>
+
+using namespace PurpleReign;
+
+PurpleReign::Encoders::Encoders()
+{
+	m_numEncoders = 0;
+	m_absoluteFunction = nullptr;
+	m_relativeFunction = nullptr;
+}
+
+void PurpleReign::Encoders::initQdec(int qdec, unsigned long filterMaxCycles)
+{
+	if (qdec == 0)
+	{
+		pmc_enable_periph_clk(ID_TC0);
+		PIO_Configure(PIOB, PIO_PERIPH_B, PIO_PB25B_TIOA0 | PIO_PB27B_TIOB0, PIO_PULLUP); // PHA = TIOA0 (pin 2), PHB = TIOB0 (pin 13)
+	}
+	else
+	{
+		pmc_enable_periph_clk(ID_TC6);
+		PIO_Configure(PIOC, PIO_PERIPH_B, PIO_PC25B_TIOA6 | PIO_PC26B_TIOB6, PIO_PULLUP); // PHA = TIOA6 (pin 5), PHB = TIOB6 (pin 4)
+	}
+	if (filterMaxCycles > 63)
+		filterMaxCycles = 63;
+
+	Tc *tc = qdecTc(qdec);
+	tc->TC_CHANNEL[0].TC_CMR = TC_CMR_TCCLKS_XC0 | TC_CMR_ETRGEDG_RISING | TC_CMR_ABETRG; // Count the decoder output (XC0), in capture mode
+	tc->TC_BMR = TC_BMR_QDEN | TC_BMR_POSEN | TC_BMR_EDGPHA | TC_BMR_MAXFILT(filterMaxCycles); // Position measurement, counting the edges of both phases
+	tc->TC_CHANNEL[0].TC_CCR = TC_CCR_CLKEN | TC_CCR_SWTRG;
+}
+
+bool PurpleReign::Encoders::init(const encoder_t *encoders, int numEncoders, unsigned long filterMaxCycles)
+{
+	if (numEncoders > maxEncoders)
+		return false;
+	for (int encoder = 0; encoder < numEncoders; encoder++)
+		for (int other = 0; other < encoder; other++)
+			if (encoders[encoder].qdec == encoders[other].qdec)
+				return false;
+
+	m_numEncoders = numEncoders;
+	for (int encoder = 0; encoder < numEncoders; encoder++)
+	{
+		m_encoder[encoder] = encoders[encoder];
+		if (m_encoder[encoder].countsPerStep == 0)
+			m_encoder[encoder].countsPerStep = 1;
+		initQdec(m_encoder[encoder].qdec, filterMaxCycles);
+		m_lastCount[encoder] = qdecTc(m_encoder[encoder].qdec)->TC_CHANNEL[0].TC_CV;
+		m_residual[encoder] = 0;
+		m_value[encoder] = 0;
+	}
+	return true;
+}
+
+void PurpleReign::Encoders::setAbsoluteFunction(void (*function)(uint8_t ccNum, uint16_t ctrlVal, uint8_t channel))
+{
+	m_absoluteFunction = function;
+}
+
+void PurpleReign::Encoders::setRelativeFunction(void (*function)(uint8_t ccNum, int delta, uint8_t channel))
+{
+	m_relativeFunction = function;
+}
+
+void PurpleReign::Encoders::setValue(int encoder, uint16_t ctrlVal)
+{
+	if (encoder < m_numEncoders)
+		m_value[encoder] = ctrlVal & 0x3FFF;
+}
+
+void PurpleReign::Encoders::poll()
+{
+	for (int encoder = 0; encoder < m_numEncoders; encoder++)
+	{
+		const encoder_t &config = m_encoder[encoder];
+		uint32_t count = qdecTc(config.qdec)->TC_CHANNEL[0].TC_CV;
+		if (count == m_lastCount[encoder])
+			continue; // Not moved, the common case
+		int32_t counts = (int32_t)(count - m_lastCount[encoder]) + m_residual[encoder]; // Unsigned subtraction, so wrapping of the counter is harmless
+		m_lastCount[encoder] = count;
+		int32_t steps = counts / config.countsPerStep;
+		m_residual[encoder] = counts - steps * config.countsPerStep;
+		if (steps == 0)
+			continue;
+
+		int32_t absSteps = steps < 0 ? -steps : steps;
+		int32_t acceleration = 1 + (absSteps - 1) / accelerationSteps;
+		if (acceleration > maxAcceleration)
+			acceleration = maxAcceleration;
+		steps *= acceleration;
+
+		if (config.mode == ENCODER_ABSOLUTE)
+		{
+			int32_t value = m_value[encoder] + steps * absoluteStep;
+			if (value < 0)
+				value = 0;
+			if (value > 0x3FFF)
+				value = 0x3FFF;
+			if (value == m_value[encoder])
+				continue; // At the end of the range
+			m_value[encoder] = value;
+			if (m_absoluteFunction)
+				m_absoluteFunction(config.ccNum, value, config.channel);
+		}
+		else if (m_relativeFunction)
+			m_relativeFunction(config.ccNum, steps, config.channel);
+	}
+}
@@ -0,0 +1,61 @@
+#include <pure_analogkeybed.h>
+#include <pure_keymotionmodel.h>
+
+using namespace PurpleReign;
+
+PurpleReign::KeyMotionModel::KeyMotionModel(uint16_t restRaw, uint16_t bottomRaw)
+{
+	m_restRaw = restRaw;
+	m_bottomRaw = bottomRaw;
+	m_noise = 0;
+	m_seed = 1;
+	for (int key = 0; key < maxKeys; key++)
+		m_stroke[key].active = 0;
+}
+
+void PurpleReign::KeyMotionModel::press(int key, uint32_t pressMicros, uint32_t holdMicros, uint32_t releaseMicros, int overtravel)
+{
+	stroke_t &stroke = m_stroke[key];
+	stroke.start = Timebase::now32();
+	stroke.pressCycles = Timebase::microsToCycles32(pressMicros > 0 ? pressMicros : 1);
+	stroke.holdCycles = Timebase::microsToCycles32(holdMicros);
+	stroke.releaseCycles = Timebase::microsToCycles32(releaseMicros > 0 ? releaseMicros : 1);
+	stroke.overtravel = overtravel;
+	stroke.active = 1;
+}
+
+int PurpleReign::KeyMotionModel::position(int key) const
+{
+	const stroke_t &stroke = m_stroke[key];
+	if (!stroke.active)
+		return 0;
+	uint32_t t = Timebase::now32() - stroke.start;
+	if (t < stroke.pressCycles)
+		return (int)(((uint64_t)t * analogKeyPositionMax) / stroke.pressCycles);
+	t -= stroke.pressCycles;
+	if (t < stroke.holdCycles)
+	{ // Into the felt and back: a triangle over the hold time
+		uint32_t half = stroke.holdCycles / 2;
+		uint32_t fromEdge = t < half ? t : stroke.holdCycles - t;
+		return analogKeyPositionMax + (half > 0 ? (int)(((uint64_t)fromEdge * stroke.overtravel) / half) : 0);
+	}
+	t -= stroke.holdCycles;
+	if (t < stroke.releaseCycles)
+		return analogKeyPositionMax - (int)(((uint64_t)t * analogKeyPositionMax) / stroke.releaseCycles);
+	return 0;
+}
+
+uint16_t PurpleReign::KeyMotionModel::raw(int key) const
+{
+	int value = m_restRaw + (position(key) * ((int)m_bottomRaw - (int)m_restRaw)) / analogKeyPositionMax;
+	if (m_noise > 0)
+	{
+		m_seed = m_seed * 1664525 + 1013904223; // Numerical Recipes LCG
+		value += (int)((m_seed >> 16) % (2 * m_noise + 1)) - m_noise;
+	}
+	if (value < 0)
+		value = 0;
+	if (value > 0xFFFF)
+		value = 0xFFFF;
+	return value;
+}
@@ -0,0 +1,76 @@
+#include <pure_log.h>
+
+using namespace PurpleReign;
+
+PurpleReign::Log::record_t PurpleReign::Log::s_ring[ringSize];
+volatile uint8_t PurpleReign::Log::s_head = 0;
+volatile uint8_t PurpleReign::Log::s_tail = 0;
+volatile uint32_t PurpleReign::Log::s_dropped = 0;
+
+void PurpleReign::Log::writeRecord(uint8_t level, uint8_t subsystem, uint16_t formatId, const uint32_t *args, int numArgs)
+{
+	uint32_t time = Timebase::now32();
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	uint8_t head = s_head;
+	if ((uint8_t)(head - s_tail) < ringSize)
+	{
+		record_t &record = s_ring[head & (ringSize - 1)];
+		record.time = time;
+		record.formatId = formatId;
+		record.level = level;
+		record.subsystem = subsystem;
+		record.numArgs = numArgs;
+		for (int ix = 0; ix < numArgs; ix++)
+			record.arg[ix] = args[ix];
+		s_head = head + 1;
+	}
+	else
+		s_dropped = s_dropped + 1;
+	__set_PRIMASK(primask);
+}
+
+static inline int appendWord(uint8_t *frame, int length, uint32_t word)
+{
+	for (int shift = 0; shift < 32; shift += 8)
+		frame[length++] = word >> shift;
+	return length;
+}
+
+void PurpleReign::Log::sendRecord(Print *out, const record_t &record)
+{
+	uint8_t frame[2 + 8 + 4 * maxArgs + 1];
+	int length = 0;
+	frame[length++] = frameStart;
+	frame[length++] = 8 + 4 * record.numArgs;
+	length = appendWord(frame, length, record.time);
+	frame[length++] = record.formatId & 0xFF;
+	frame[length++] = record.formatId >> 8;
+	frame[length++] = record.level;
+	frame[length++] = record.subsystem;
+	for (int ix = 0; ix < record.numArgs; ix++)
+		length = appendWord(frame, length, record.arg[ix]);
+	uint8_t checksum = 0;
+	for (int ix = 2; ix < length; ix++)
+		checksum += frame[ix];
+	frame[length++] = checksum;
+	out->write(frame, length);
+}
+
+void PurpleReign::Log::flush(Print *out, int maxRecords)
+{
+	for (; maxRecords > 0 && s_tail != s_head; maxRecords--)
+	{
+		sendRecord(out, s_ring[s_tail & (ringSize - 1)]);
+		s_tail = s_tail + 1;
+	}
+	uint32_t dropped = s_dropped;
+	if (dropped != 0 && s_tail == s_head)
+	{ // Report the loss once the ring has been drained
+		uint32_t primask = __get_PRIMASK();
+		__disable_irq();
+		s_dropped = s_dropped - dropped;
+		__set_PRIMASK(primask);
+		PURE_LOG_WARN(PURE_LOG_CORE, LOG_OVERFLOW, dropped);
+	}
+}
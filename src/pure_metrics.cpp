@@ -0,0 +1,67 @@
+#include <pure_metrics.h>
+#include <pure_midictrl.h>
+#include <pure_timebase.h>
+
+using namespace PurpleReign;
+
+uint32_t PurpleReign::Metrics::s_value[numMetrics];
+
+enum metricKind_t
+{
+	METRIC_KIND_COUNTER,
+	METRIC_KIND_GAUGE,
+	METRIC_KIND_PEAK
+};
+
+static const uint8_t metricKind[numMetrics] = {
+#define PURE_METRIC_KIND(id, kind, name) METRIC_KIND_##kind,
+	PURE_METRIC_NAMES(PURE_METRIC_KIND)
+#undef PURE_METRIC_KIND
+};
+
+void PurpleReign::Metrics::resetPeaks()
+{
+	for (int ix = 0; ix < numMetrics; ix++)
+		if (metricKind[ix] == METRIC_KIND_PEAK)
+			set((metricId_t)ix, 0);
+}
+
+static inline int appendWord(uint8_t *frame, int length, uint32_t word)
+{
+	for (int shift = 0; shift < 32; shift += 8)
+		frame[length++] = word >> shift;
+	return length;
+}
+
+void PurpleReign::Metrics::sendFrame(Print *out)
+{
+	uint8_t frame[2 + framePayloadLength + 1];
+	int length = 0;
+	frame[length++] = frameStart;
+	frame[length++] = framePayloadLength;
+	length = appendWord(frame, length, Timebase::now32());
+	frame[length++] = numMetrics;
+	for (int ix = 0; ix < numMetrics; ix++)
+		length = appendWord(frame, length, value((metricId_t)ix));
+	uint8_t checksum = 0;
+	for (int ix = 2; ix < length; ix++)
+		checksum += frame[ix];
+	frame[length++] = checksum;
+	out->write(frame, length);
+}
+
+int PurpleReign::Metrics::sysexSnapshot(uint8_t *data, int size)
+{
+	if (size < sysexSnapshotLength)
+		return 0;
+	int length = 0;
+	MidiCtrl::pack32(Timebase::now32(), &data[length]);
+	length += 5;
+	data[length++] = numMetrics;
+	for (int ix = 0; ix < numMetrics; ix++)
+	{
+		MidiCtrl::pack32(value((metricId_t)ix), &data[length]);
+		length += 5;
+	}
+	return length;
+}
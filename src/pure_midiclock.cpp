@@ -0,0 +1,131 @@
+#include <pure_midiclock.h>
+
+using namespace PurpleReign;
+
+static const uint8_t midiTimingClock = 0xF8;
+static const uint8_t midiStart = 0xFA;
+static const uint8_t midiContinue = 0xFB;
+static const uint8_t midiStop = 0xFC;
+
+PurpleReign::MidiClock::MidiClock()
+{
+	m_queue = nullptr;
+	m_tempo = 12000;
+	m_timerPeriod = tempoToTimerPeriod(m_tempo);
+	m_timerPeriodChanged = false;
+	m_lastTickTime = 0;
+	m_jitterValid = false;
+	m_running = false;
+	m_numTaps = 0;
+	resetStats();
+}
+
+// Timer counts per tick = timerClockHz * 60 s / (BPM * 24), with the tempo in 1/100 BPM
+uint32_t PurpleReign::MidiClock::tempoToTimerPeriod(uint32_t tempo)
+{
+	return (uint32_t)(((uint64_t)timerClockHz * 60 * 100) / ((uint64_t)tempo * ppqn));
+}
+
+void PurpleReign::MidiClock::init(MidiQueue *queue, uint32_t tempo)
+{
+	m_queue = queue;
+	setTempo(tempo);
+	m_timerPeriodChanged = false;
+
+	pmc_set_writeprotect(false);
+	pmc_enable_periph_clk(ID_TC3); // TC1 channel 0
+	TC_Configure(TC1, 0, TC_CMR_WAVE | TC_CMR_WAVSEL_UP_RC | TC_CMR_TCCLKS_TIMER_CLOCK1);
+	TC_SetRC(TC1, 0, m_timerPeriod);
+	TC1->TC_CHANNEL[0].TC_IER = TC_IER_CPCS; // Interrupt on RC compare
+	TC1->TC_CHANNEL[0].TC_IDR = ~TC_IER_CPCS;
+	NVIC_ClearPendingIRQ(TC3_IRQn);
+	NVIC_SetPriority(TC3_IRQn, 0); // Highest priority, above USB
+	NVIC_EnableIRQ(TC3_IRQn);
+	TC_Start(TC1, 0);
+}
+
+void PurpleReign::MidiClock::setTempo(uint32_t tempo)
+{
+	if (tempo < minTempo)
+		tempo = minTempo;
+	if (tempo > maxTempo)
+		tempo = maxTempo;
+	m_tempo = tempo;
+	m_timerPeriod = tempoToTimerPeriod(tempo);
+	m_timerPeriodChanged = true; // RC is changed by the interrupt, right after a compare match. Changing it here could set it below the counter value, and the counter would then run a full 32-bit lap.
+}
+
+void PurpleReign::MidiClock::tap()
+{
+	uint32_t now = Timebase::now32();
+	if (m_numTaps > 0 && now - m_tapTime[m_numTaps - 1] > Timebase::microsToCycles32(maxTapIntervalMicros))
+		m_numTaps = 0; // Too long since the previous tap, start over
+	if (m_numTaps == numTapIntervals + 1)
+	{ // Drop the oldest tap
+		for (int ix = 0; ix < numTapIntervals; ix++)
+			m_tapTime[ix] = m_tapTime[ix + 1];
+		m_numTaps--;
+	}
+	m_tapTime[m_numTaps++] = now;
+	if (m_numTaps < 2)
+		return;
+
+	uint32_t averageMicros = Timebase::cyclesToMicros32(m_tapTime[m_numTaps - 1] - m_tapTime[0]) / (m_numTaps - 1);
+	if (averageMicros > 0)
+		setTempo((uint32_t)((60ULL * 1000000 * 100) / averageMicros));
+}
+
+void PurpleReign::MidiClock::start()
+{
+	// Restart the timer, so the first clock after the start message comes exactly one period later
+	TC_Stop(TC1, 0);
+	m_running = true;
+	m_jitterValid = false;
+	m_queue->pushRealtime(midiStart, Timebase::now32());
+	TC_Start(TC1, 0);
+}
+
+void PurpleReign::MidiClock::stop()
+{
+	m_running = false;
+	m_queue->pushRealtime(midiStop, Timebase::now32());
+}
+
+void PurpleReign::MidiClock::resume()
+{
+	m_running = true;
+	m_queue->pushRealtime(midiContinue, Timebase::now32());
+}
+
+void PurpleReign::MidiClock::resetStats()
+{
+	m_stats.ticks = 0;
+	m_stats.maxTimerJitterCycles = 0;
+}
+
+void PurpleReign::MidiClock::timerInterrupt()
+{
+	uint32_t now = Timebase::now32();
+	TC_GetStatus(TC1, 0); // Acknowledge the interrupt
+
+	if (m_timerPeriodChanged)
+	{
+		TC_SetRC(TC1, 0, m_timerPeriod);
+		m_timerPeriodChanged = false;
+		m_jitterValid = false; // The next interval is the first one at the new period
+	}
+	else if (m_jitterValid)
+	{
+		uint32_t periodCycles = TC1->TC_CHANNEL[0].TC_RC * (VARIANT_MCK / timerClockHz);
+		int32_t deviation = (int32_t)((now - m_lastTickTime) - periodCycles);
+		uint32_t jitter = deviation < 0 ? -deviation : deviation;
+		if (jitter > m_stats.maxTimerJitterCycles)
+			m_stats.maxTimerJitterCycles = jitter;
+	}
+	else
+		m_jitterValid = true; // First tick (after a start or a tempo change), the next interval can be measured
+	m_lastTickTime = now;
+
+	m_stats.ticks++;
+	m_queue->pushRealtime(midiTimingClock, now);
+}
@@ -1,8 +1,140 @@
+#include <MIDIUSB.h>
+
 #include <pure_midictrl.h>
 
 using namespace PurpleReign;
 
+PurpleReign::MidiCtrl::MidiCtrl()
+{
+	m_configFunction = nullptr;
+	m_thruFunction = nullptr;
+	init();
+}
+
 int PurpleReign::MidiCtrl::init()
 {
+	m_state = IDLE;
+	m_command = 0;
+	m_dataLength = 0;
+	m_packetLength = 0;
+	m_packetIx = 0;
+	m_numApplied = 0;
+	m_numRejected = 0;
 	return 0;
-}
\ No newline at end of file
+}
+
+void PurpleReign::MidiCtrl::setConfigFunction(bool (*function)(uint8_t command, const uint8_t *data, int length))
+{
+	m_configFunction = function;
+}
+
+void PurpleReign::MidiCtrl::setThruFunction(void (*function)(uint32_t packet))
+{
+	m_thruFunction = function;
+}
+
+// Reads the next USB-MIDI packet. A packet carrying SysEx bytes is stored in m_packet, to be parsed. Other packets (channel voice, system common and
+// realtime messages) are handed to the thru function, if any, or discarded.
+// Returns the number of MIDI bytes handed on or discarded (they count against the byte budget of poll() as well), or -1 if there are no more packets.
+int PurpleReign::MidiCtrl::fetchPacket()
+{
+	midiEventPacket_t packet = MidiUSB.read();
+	if (packet.header == 0)
+		return -1; // Nothing received
+
+	m_packet[0] = packet.byte1;
+	m_packet[1] = packet.byte2;
+	m_packet[2] = packet.byte3;
+	m_packetIx = 0;
+	switch (packet.header & 0x0F) // Code Index Number
+	{
+	case 0x4: // SysEx starts or continues
+	case 0x7: // SysEx ends with the following three bytes
+		m_packetLength = 3;
+		return 0;
+	case 0x5: // Single byte System Common message or SysEx ends with the following single byte
+		if (packet.byte1 != 0xF7 && m_thruFunction)
+			m_thruFunction(0x05 | ((uint32_t)packet.byte1 << 8));
+		m_packetLength = 1; // Parsed as well, a status byte terminates SysEx
+		return 0;
+	case 0x6: // SysEx ends with the following two bytes
+		m_packetLength = 2;
+		return 0;
+	default: // Not SysEx
+		if (m_thruFunction)
+			m_thruFunction((packet.header & 0x0F) | ((uint32_t)packet.byte1 << 8) | ((uint32_t)packet.byte2 << 16) | ((uint32_t)packet.byte3 << 24));
+		m_packetLength = 0;
+		return 3;
+	}
+}
+
+void PurpleReign::MidiCtrl::parseByte(uint8_t midiByte)
+{
+	if (midiByte == 0xF0)
+	{ // SysEx start, (also) aborts any unterminated message
+		m_state = MANUFACTURER;
+		m_dataLength = 0;
+		return;
+	}
+	if (midiByte == 0xF7)
+	{ // SysEx end
+		if (m_state == DATA)
+		{
+			if (m_configFunction && m_configFunction(m_command, m_data, m_dataLength))
+				m_numApplied++;
+			else
+				m_numRejected++;
+		}
+		m_state = IDLE;
+		return;
+	}
+	if (midiByte & 0x80)
+	{ // Any other status byte terminates SysEx (realtime bytes never get here, they are sent in packets of their own)
+		m_state = IDLE;
+		return;
+	}
+
+	switch (m_state)
+	{
+	case MANUFACTURER:
+		m_state = (midiByte == sysexManufacturerId) ? PRODUCT : IDLE;
+		break;
+	case PRODUCT:
+		m_state = (midiByte == sysexProductId) ? COMMAND : IDLE;
+		break;
+	case COMMAND:
+		m_command = midiByte;
+		m_state = DATA;
+		break;
+	case DATA:
+		if (m_dataLength < maxSysexDataLength)
+			m_data[m_dataLength++] = midiByte;
+		else
+		{ // Too long, skip the rest of the message
+			m_numRejected++;
+			m_state = IDLE;
+		}
+		break;
+	default:
+		break; // IDLE: Not in a message of ours
+	}
+}
+
+int PurpleReign::MidiCtrl::poll(int byteBudget)
+{
+	int numParsed = 0;
+	while (numParsed < byteBudget)
+	{
+		if (m_packetIx == m_packetLength)
+		{ // Current packet done
+			int numPassed = fetchPacket();
+			if (numPassed < 0)
+				break; // Nothing more received
+			numParsed += numPassed;
+			continue;
+		}
+		parseByte(m_packet[m_packetIx++]);
+		numParsed++;
+	}
+	return numParsed;
+}
@@ -0,0 +1,134 @@
+#include <pure_midievent.h>
+#include <pure_ump.h>
+
+using namespace PurpleReign;
+
+static inline uint32_t usbMidiPacket(uint8_t cin, uint8_t byte1, uint8_t byte2, uint8_t byte3)
+{
+	return cin | ((uint32_t)byte1 << 8) | ((uint32_t)byte2 << 16) | ((uint32_t)byte3 << 24);
+}
+
+bool PurpleReign::MidiEvent::fromUsbMidi(uint32_t packet, uint32_t time, midiEvent_t &event)
+{
+	uint8_t cin = packet & 0x0F; // Code Index Number
+	uint8_t status = (packet >> 8) & 0xFF;
+	uint8_t data1 = (packet >> 16) & 0x7F;
+	uint8_t data2 = (packet >> 24) & 0x7F;
+	uint8_t channel = status & 0x0F;
+	switch (cin)
+	{
+	case 0x8:
+		event = noteOff(channel, data1, data2, Ump::scaleUp(data2, 7, 16), time);
+		return true;
+	case 0x9:
+		if (data2 == 0)
+			event = noteOff(channel, data1, 0, 0, time); // Note on with velocity 0 is a note off in MIDI 1.0 (but not in MIDI 2.0)
+		else
+			event = noteOn(channel, data1, data2, Ump::scaleUp(data2, 7, 16), time);
+		return true;
+	case 0xA:
+		event = polyPressure(channel, data1, data2, time);
+		return true;
+	case 0xB:
+		event = controlChange7(channel, data1, data2, time); // Sent as received, without the MSB/LSB protocol of local controllers
+		return true;
+	case 0xC:
+		event = programChange(channel, data1, time);
+		return true;
+	case 0xD:
+		event = make(EVENT_CHANNEL_PRESSURE, channel, 0, data1, 0, 0, time);
+		return true;
+	case 0xE:
+		event = pitchBend(channel, data1 | (data2 << 7), time);
+		return true;
+	case 0x2: // Two byte system common
+	case 0x3: // Three byte system common
+		event = make(EVENT_SYSTEM_COMMON, status, data1, cin == 0x3 ? data2 : 0, 0, 0, time);
+		return true;
+	case 0x5: // Single byte system common, or SysEx end with a single byte
+		if (status == 0xF7)
+			event = make(EVENT_SYSEX, 1, status, 0, 0, 0, time);
+		else
+			event = make(EVENT_SYSTEM_COMMON, status, 0, 0, 0, 0, time);
+		return true;
+	case 0x4: // SysEx start or continue
+	case 0x6: // SysEx end with two bytes
+	case 0x7: // SysEx end with three bytes
+		event = make(EVENT_SYSEX, cin == 0x6 ? 2 : 3, status, (packet >> 16) & 0xFF, (packet >> 24) & 0xFF, 0, time);
+		return true;
+	case 0xF: // Single byte
+		event = make(status >= 0xF8 ? EVENT_REALTIME : EVENT_SYSTEM_COMMON, status, 0, 0, 0, 0, time);
+		return true;
+	default:
+		return false; // Reserved (miscellaneous function codes and cable events)
+	}
+}
+
+PurpleReign::Midi1Encoder::Midi1Encoder()
+{
+	for (int ccNum = 0; ccNum < 32; ccNum++)
+	{
+		m_prevCcMsb[ccNum] = 0;
+		m_prevCcChannel[ccNum] = 0xFF;
+	}
+}
+
+int PurpleReign::Midi1Encoder::encode(const midiEvent_t &event, uint32_t *packets)
+{
+	uint8_t channel = event.channel & 0x0F;
+	switch (event.type)
+	{
+	case EVENT_NOTE_OFF:
+		packets[0] = usbMidiPacket(0x08, 0x80 | channel, event.index, event.data);
+		return 1;
+	case EVENT_NOTE_ON:
+		packets[0] = usbMidiPacket(0x09, 0x90 | channel, event.index, event.data);
+		return 1;
+	case EVENT_POLY_PRESSURE:
+		packets[0] = usbMidiPacket(0x0A, 0xA0 | channel, event.index, event.data);
+		return 1;
+	case EVENT_CONTROL_CHANGE:
+	{
+		if ((event.flags & EVENT_FLAG_7BIT) || event.index >= 32)
+		{ // No LSB controller
+			packets[0] = usbMidiPacket(0x0B, 0xB0 | channel, event.index, event.data);
+			return 1;
+		}
+		int numPackets = 0;
+		if (event.data != m_prevCcMsb[event.index] || channel != m_prevCcChannel[event.index]) // Only if the MSB has changed, on this channel
+		{
+			m_prevCcMsb[event.index] = event.data;
+			m_prevCcChannel[event.index] = channel;
+			packets[numPackets++] = usbMidiPacket(0x0B, 0xB0 | channel, event.index, event.data);
+		}
+		// In 14-bit mode the LSB (almost) always needs to be resent: if the MSB changed, the receiver has reset the LSB to 0, and if it did not, the LSB must be what changed.
+		if (event.flags & EVENT_FLAG_LSB)
+			packets[numPackets++] = usbMidiPacket(0x0B, 0xB0 | channel, event.index + 32, event.value & 0x7F);
+		return numPackets;
+	}
+	case EVENT_PROGRAM_CHANGE:
+		packets[0] = usbMidiPacket(0x0C, 0xC0 | channel, event.index, 0);
+		return 1;
+	case EVENT_CHANNEL_PRESSURE:
+		packets[0] = usbMidiPacket(0x0D, 0xD0 | channel, event.data, 0);
+		return 1;
+	case EVENT_PITCH_BEND:
+		packets[0] = usbMidiPacket(0x0E, 0xE0 | channel, event.value & 0x7F, (event.value >> 7) & 0x7F);
+		return 1;
+	case EVENT_SYSTEM_COMMON:
+	{
+		uint8_t cin = (event.channel == 0xF2) ? 0x3 : (event.channel == 0xF1 || event.channel == 0xF3) ? 0x2 : 0x5;
+		packets[0] = usbMidiPacket(cin, event.channel, event.index, event.data);
+		return 1;
+	}
+	case EVENT_SYSEX:
+	{
+		uint8_t cin = MidiEvent::isSysexEnd(event) ? 0x4 + event.channel : 0x4; // SysEx end with 1..3 bytes, or start/continue
+		packets[0] = usbMidiPacket(cin, event.index, event.channel >= 2 ? event.data : 0, event.channel >= 3 ? (uint8_t)event.value : 0);
+		return 1;
+	}
+	default: // EVENT_REALTIME
+		packets[0] = usbMidiPacket(0x0F, event.channel, 0, 0);
+		return 1;
+	}
+}
@@ -0,0 +1,317 @@
+#include <pure_midimerge.h>
+
+using namespace PurpleReign;
+
+PurpleReign::MidiMerge::MidiMerge()
+{
+	m_queue = nullptr;
+	m_numSources = 0;
+	m_nextSource = 0;
+	m_mergeLimit = maxMessagePackets;
+	m_clockFilter = false;
+}
+
+void PurpleReign::MidiMerge::init(MidiQueue *queue, int mergeLimit)
+{
+	m_queue = queue;
+	m_numSources = 0;
+	m_nextSource = 0;
+	setMergeLimit(mergeLimit);
+}
+
+void PurpleReign::MidiMerge::initSource(source_t &source, Stream *serial, int quota)
+{
+	source.serial = serial;
+	source.quota = quota > 0 ? quota : 1;
+	source.packet.clear();
+	source.arrivalTime.clear();
+	source.numCompletePackets = 0;
+	source.numSysexPackets = 0;
+	source.skipSysex = false;
+	source.eventFlags = 0;
+	source.runningStatus = 0;
+	source.messageLength = 0;
+	source.expectedLength = 0;
+	source.inSysex = false;
+	source.stats = midiMergeStats_t{0, 0, 0, 0, 0, 0, 0};
+}
+
+int PurpleReign::MidiMerge::addSerialSource(Stream *serial, int quota)
+{
+	if (m_numSources == maxSources)
+		return -1;
+	initSource(m_source[m_numSources], serial, quota);
+	return m_numSources++;
+}
+
+int PurpleReign::MidiMerge::addPacketSource(int quota)
+{
+	return addSerialSource(nullptr, quota);
+}
+
+void PurpleReign::MidiMerge::setMergeLimit(int mergeLimit)
+{
+	if (mergeLimit < maxMessagePackets)
+		mergeLimit = maxMessagePackets;
+	if (mergeLimit > MidiQueue::queueSize)
+		mergeLimit = MidiQueue::queueSize;
+	m_mergeLimit = mergeLimit;
+}
+
+void PurpleReign::MidiMerge::resetStats()
+{
+	for (int ix = 0; ix < m_numSources; ix++)
+		m_source[ix].stats = midiMergeStats_t{0, 0, 0, 0, 0, 0, 0};
+}
+
+// Drops the packets of the SysEx being received from the tail of the buffer
+void PurpleReign::MidiMerge::abortSysex(source_t &source)
+{
+	for (; source.numSysexPackets > 0; source.numSysexPackets--)
+	{
+		source.packet.pop();
+		source.arrivalTime.pop();
+	}
+	source.stats.sysexDropped++;
+}
+
+void PurpleReign::MidiMerge::appendPacket(source_t &source, uint32_t packet, uint32_t now)
+{
+	uint8_t cin = packet & 0x0F; // Code Index Number
+	uint8_t status = (packet >> 8) & 0xFF;
+	if (cin < 0x2)
+		return; // Reserved (miscellaneous function codes and cable events)
+	if (cin == 0xF && status >= 0xF8)
+	{ // Realtime, may appear anywhere (also within SysEx)
+		if (m_clockFilter && (status == 0xF8 || (status >= 0xFA && status <= 0xFC)))
+		{
+			source.stats.clockDropped++;
+			return;
+		}
+		if (m_queue->pushRealtime(status, now, source.eventFlags))
+			source.stats.realtime++;
+		return;
+	}
+
+	bool isSysexEnd = cin == 0x6 || cin == 0x7 || (cin == 0x5 && status == 0xF7);
+	if (cin == 0x4 || isSysexEnd)
+	{
+		if (cin == 0x4 && status == 0xF0)
+		{ // SysEx start, (also) aborts any unterminated SysEx
+			if (source.numSysexPackets > 0)
+				abortSysex(source);
+			source.skipSysex = false;
+		}
+		if (source.skipSysex)
+		{
+			source.skipSysex = !isSysexEnd;
+			return;
+		}
+		if (source.numSysexPackets == maxMessagePackets || source.packet.isFull())
+		{ // Too long to be forwarded in one go, or no room: drop the whole message
+			abortSysex(source);
+			source.skipSysex = !isSysexEnd;
+			return;
+		}
+		source.packet.push(packet);
+		source.arrivalTime.push(now);
+		source.numSysexPackets++;
+		if (isSysexEnd)
+		{
+			source.numCompletePackets += source.numSysexPackets;
+			source.numSysexPackets = 0;
+			source.stats.received++;
+		}
+		return;
+	}
+
+	// Channel voice or system common: a status byte also terminates an unfinished SysEx
+	if (source.numSysexPackets > 0)
+		abortSysex(source);
+	source.skipSysex = false;
+	if (source.packet.isFull())
+	{
+		source.stats.dropped++;
+		return;
+	}
+	source.packet.push(packet);
+	source.arrivalTime.push(now);
+	source.numCompletePackets++;
+	source.stats.received++;
+}
+
+void PurpleReign::MidiMerge::parseSerialByte(source_t &source, uint8_t midiByte, uint32_t now)
+{
+	if (midiByte >= 0xF8)
+	{ // Realtime, may appear anywhere. 0xF9 and 0xFD are undefined.
+		if (midiByte != 0xF9 && midiByte != 0xFD)
+			appendPacket(source, 0x0F | (midiByte << 8), now);
+		return;
+	}
+	if (midiByte == 0xF7)
+	{ // SysEx end: pack the remaining bytes (1..3, including F7) in an end packet (CIN 0x5..0x7)
+		if (!source.inSysex)
+			return;
+		source.message[source.messageLength++] = 0xF7;
+		uint32_t packet = 0x4 + source.messageLength;
+		for (int ix = 0; ix < source.messageLength; ix++)
+			packet |= (uint32_t)source.message[ix] << (8 * (ix + 1));
+		appendPacket(source, packet, now);
+		source.inSysex = false;
+		source.messageLength = 0;
+		return;
+	}
+	if (midiByte & 0x80)
+	{ // Any other status byte
+		if (source.inSysex)
+		{ // Unterminated SysEx
+			source.inSysex = false;
+			abortSysex(source);
+		}
+		source.message[0] = midiByte;
+		source.messageLength = 1;
+		if (midiByte == 0xF0)
+		{
+			source.inSysex = true;
+			source.runningStatus = 0;
+			return;
+		}
+		if (midiByte < 0xF0)
+		{ // Channel voice. Program change and channel pressure have one data byte.
+			source.runningStatus = midiByte;
+			source.expectedLength = ((midiByte & 0xE0) == 0xC0) ? 2 : 3;
+			return;
+		}
+		source.runningStatus = 0; // System common messages cancel running status
+		switch (midiByte)
+		{
+		case 0xF1: // MTC quarter frame
+		case 0xF3: // Song select
+			source.expectedLength = 2;
+			return;
+		case 0xF2: // Song position pointer
+			source.expectedLength = 3;
+			return;
+		case 0xF6: // Tune request
+			appendPacket(source, 0x05 | (midiByte << 8), now);
+			source.messageLength = 0;
+			return;
+		default: // Undefined (0xF4, 0xF5): ignore the message and its data bytes
+			source.expectedLength = 0;
+			source.messageLength = 0;
+			return;
+		}
+	}
+
+	// Data byte
+	if (source.inSysex)
+	{
+		source.message[source.messageLength++] = midiByte;
+		if (source.messageLength == 3)
+		{ // SysEx start or continue packet (CIN 0x4)
+			appendPacket(source, 0x04 | ((uint32_t)source.message[0] << 8) | ((uint32_t)source.message[1] << 16) | ((uint32_t)source.message[2] << 24), now);
+			source.messageLength = 0;
+		}
+		return;
+	}
+	if (source.messageLength == 0)
+	{
+		if (source.runningStatus == 0)
+			return; // No status to apply the byte to
+		source.message[0] = source.runningStatus;
+		source.messageLength = 1;
+	}
+	if (source.expectedLength == 0)
+		return;
+	source.message[source.messageLength++] = midiByte;
+	if (source.messageLength == source.expectedLength)
+	{
+		uint8_t cin = source.message[0] < 0xF0 ? (source.message[0] >> 4) : source.expectedLength; // System common: CIN 0x2 (two bytes) or 0x3 (three bytes)
+		uint32_t packet = cin;
+		for (int ix = 0; ix < source.messageLength; ix++)
+			packet |= (uint32_t)source.message[ix] << (8 * (ix + 1));
+		appendPacket(source, packet, now);
+		source.messageLength = 0;
+	}
+}
+
+void PurpleReign::MidiMerge::receivePacket(int source, uint32_t packet)
+{
+	if (source < 0 || source >= m_numSources)
+		return;
+	appendPacket(m_source[source], packet & 0xFFFFFF0F, Timebase::now32()); // Cable 0
+}
+
+void PurpleReign::MidiMerge::setSourceFlags(int source, uint8_t flags)
+{
+	if (source < 0 || source >= m_numSources)
+		return;
+	m_source[source].eventFlags = flags;
+}
+
+// Number of packets of the oldest whole message in the buffer, 0 if there is none
+int PurpleReign::MidiMerge::headMessagePackets(source_t &source)
+{
+	if (source.numCompletePackets == 0)
+		return 0;
+	if ((source.packet.first() & 0x0F) != 0x4)
+		return 1;
+	for (int ix = 1; ix < source.numCompletePackets; ix++)
+	{
+		uint8_t cin = source.packet[ix] & 0x0F;
+		if (cin >= 0x5 && cin <= 0x7)
+			return ix + 1;
+	}
+	return source.numCompletePackets; // Not reached, complete SysEx messages end with an end packet
+}
+
+// Forwards whole messages while the quota lasts (the last message may overdraw it) and the MidiQueue is below the merge limit. Returns the number of packets forwarded.
+int PurpleReign::MidiMerge::forward(source_t &source, int quota)
+{
+	int numForwarded = 0;
+	while (numForwarded < quota)
+	{
+		int numPackets = headMessagePackets(source);
+		if (numPackets == 0 || m_queue->fill() + numPackets > m_mergeLimit)
+			break;
+		uint32_t wait = Timebase::now32() - source.arrivalTime.first();
+		if (wait > source.stats.maxWaitCycles)
+			source.stats.maxWaitCycles = wait;
+		for (int ix = 0; ix < numPackets; ix++)
+		{
+			midiEvent_t event;
+			uint32_t arrivalTime = source.arrivalTime.shift();
+			if (MidiEvent::fromUsbMidi(source.packet.shift(), arrivalTime, event)) // Stamped with the arrival time, for the constant latency mode
+			{
+				event.flags |= source.eventFlags;
+				m_queue->push(event);
+			}
+		}
+		source.numCompletePackets -= numPackets;
+		source.stats.forwarded++;
+		numForwarded += numPackets;
+	}
+	return numForwarded;
+}
+
+void PurpleReign::MidiMerge::process()
+{
+	if (m_numSources == 0)
+		return;
+	uint32_t now = Timebase::now32();
+	for (int ix = 0; ix < m_numSources; ix++)
+	{
+		source_t &source = m_source[ix];
+		if (source.serial == nullptr)
+			continue;
+		for (int budget = serialByteBudget; budget > 0 && source.serial->available() > 0; budget--)
+			parseSerialByte(source, source.serial->read(), now);
+	}
+
+	for (int ix = 0; ix < m_numSources; ix++)
+	{
+		int sourceIx = (m_nextSource + ix) % m_numSources;
+		forward(m_source[sourceIx], m_source[sourceIx].quota);
+	}
+	m_nextSource = (m_nextSource + 1) % m_numSources;
+}
@@ -1,8 +1,516 @@
+#include <MIDIUSB.h>
+
+#include <pure_log.h>
 #include <pure_midiqueue.h>
 
 using namespace PurpleReign;
 
+PurpleReign::MidiQueue::MidiQueue()
+{
+	m_head = 0;
+	m_usbCursor = 0;
+	m_usbDropped = 0;
+	m_numSinks = 0;
+	m_latencyCycles = 0;
+	m_realtimeHead = 0;
+	m_realtimeTail = 0;
+	m_usbResync = false;
+	m_usbResyncChannel = 0;
+	m_usbStalled = false;
+	m_usbProgressTime = 0;
+	clearSounding(m_usbSounding);
+	clearSounding(m_sounding);
+	resetStats();
+}
+
 int PurpleReign::MidiQueue::init()
 {
+	m_usbCursor = m_head;
+	m_usbEncoder = Midi1Encoder();
+	m_usbResync = false;
+	m_usbStalled = false;
+	m_usbProgressTime = Timebase::now32();
+	clearSounding(m_usbSounding);
+	clearSounding(m_sounding);
+	m_realtimeTail = m_realtimeHead;
+	for (int ix = 0; ix < m_numSinks; ix++)
+	{
+		m_sink[ix].cursor = m_head;
+		m_sink[ix].realtimeCursor = m_realtimeHead;
+		m_sink[ix].resync = false;
+		m_sink[ix].progressTime = m_usbProgressTime;
+		clearSounding(m_sink[ix].sounding);
+	}
+	resetStats();
 	return 0;
-}
\ No newline at end of file
+}
+
+int PurpleReign::MidiQueue::addSink(bool (*function)(const midiEvent_t &event))
+{
+	if (m_numSinks == maxSinks)
+		return -1;
+	sink_t &sink = m_sink[m_numSinks];
+	sink.function = function;
+	sink.cursor = m_head;
+	sink.realtimeCursor = m_realtimeHead;
+	sink.dropped = 0;
+	sink.resync = false;
+	sink.resyncChannel = 0;
+	sink.progressTime = Timebase::now32();
+	clearSounding(sink.sounding);
+	return m_numSinks++;
+}
+
+void PurpleReign::MidiQueue::clearSounding(soundingMap_t &map)
+{
+	for (int channel = 0; channel < 16; channel++)
+		for (int word = 0; word < 4; word++)
+			map.bits[channel][word] = 0;
+}
+
+void PurpleReign::MidiQueue::trackNotes(soundingMap_t &map, const midiEvent_t &event)
+{
+	uint32_t &word = map.bits[event.channel & 0x0F][(event.index >> 5) & 0x03];
+	uint32_t bit = 1ul << (event.index & 0x1F);
+	if (event.type == EVENT_NOTE_ON)
+		word |= bit;
+	else if (event.type == EVENT_NOTE_OFF)
+		word &= ~bit;
+}
+
+static inline int countBits(uint32_t word)
+{
+	return __builtin_popcount(word);
+}
+
+int PurpleReign::MidiQueue::resyncEvents(const soundingMap_t &map, uint8_t channel, midiEvent_t *events, uint32_t now)
+{
+	int numHanging = 0;
+	for (int word = 0; word < 4; word++)
+		numHanging += countBits(map.bits[channel][word] & ~m_sounding.bits[channel][word]);
+	if (numHanging == 0)
+		return 0;
+	if (numHanging > allNotesOffThreshold)
+	{
+		events[0] = MidiEvent::controlChange7(channel, 123, 0, now); // All Notes Off
+		return 1;
+	}
+	int numEvents = 0;
+	for (int word = 0; word < 4; word++)
+	{
+		uint32_t hanging = map.bits[channel][word] & ~m_sounding.bits[channel][word];
+		for (int bit = 0; hanging != 0; bit++, hanging >>= 1)
+			if (hanging & 1)
+				events[numEvents++] = MidiEvent::noteOff(channel, word * 32 + bit, 0, 0, now);
+	}
+	return numEvents;
+}
+
+// Applies the resync of a channel to the map of an output, once its events have been sent
+void PurpleReign::MidiQueue::commitResync(soundingMap_t &map, uint8_t channel)
+{
+	int numHanging = 0;
+	for (int word = 0; word < 4; word++)
+		numHanging += countBits(map.bits[channel][word] & ~m_sounding.bits[channel][word]);
+	if (numHanging > allNotesOffThreshold)
+		Metrics::increment(METRIC_MIDI_ALL_NOTES_OFFS);
+	else
+		Metrics::add(METRIC_MIDI_RESYNC_NOTE_OFFS, numHanging);
+	for (int word = 0; word < 4; word++)
+		map.bits[channel][word] = (numHanging > allNotesOffThreshold) ? 0 : (map.bits[channel][word] & m_sounding.bits[channel][word]);
+}
+
+// Moves a read position past the event at it. A SysEx message is skipped as a whole, so no sink ever gets a part of one.
+inline void PurpleReign::MidiQueue::skipEvent(uint32_t &cursor)
+{
+	const midiEvent_t &event = m_event[cursor++ & (queueSize - 1)];
+	bool inSysex = event.type == EVENT_SYSEX && !MidiEvent::isSysexEnd(event);
+	while (inSysex && cursor != m_head)
+	{
+		const midiEvent_t &next = m_event[cursor & (queueSize - 1)];
+		if (next.type != EVENT_SYSEX || next.index == 0xF0)
+			break; // Not part of the message (it was cut short)
+		cursor++;
+		inSysex = !MidiEvent::isSysexEnd(next);
+	}
+}
+
+// Read position of the output that is furthest behind
+uint32_t PurpleReign::MidiQueue::oldestCursor()
+{
+	uint32_t oldest = m_usbCursor;
+	for (int ix = 0; ix < m_numSinks; ix++)
+		if ((int32_t)(m_sink[ix].cursor - oldest) < 0)
+			oldest = m_sink[ix].cursor;
+	return oldest;
+}
+
+// Read position of the output that is furthest ahead. The events from here on have not been taken by any output yet, so they can still be reordered.
+uint32_t PurpleReign::MidiQueue::newestCursor()
+{
+	uint32_t newest = m_usbCursor;
+	for (int ix = 0; ix < m_numSinks; ix++)
+		if ((int32_t)(m_sink[ix].cursor - newest) > 0)
+			newest = m_sink[ix].cursor;
+	return newest;
+}
+
+// True if two events address the same thing (the same key, controller, ...) on the same channel, so their order must be kept
+static inline bool isSameTarget(const midiEvent_t &a, const midiEvent_t &b)
+{
+	if (a.channel != b.channel)
+		return false;
+	bool aIsNote = a.type == EVENT_NOTE_ON || a.type == EVENT_NOTE_OFF || a.type == EVENT_POLY_PRESSURE;
+	bool bIsNote = b.type == EVENT_NOTE_ON || b.type == EVENT_NOTE_OFF || b.type == EVENT_POLY_PRESSURE;
+	if (aIsNote || bIsNote)
+		return aIsNote && bIsNote && a.index == b.index;
+	return a.type == b.type && a.index == b.index;
+}
+
+// Makes room for one event, for the outputs the queue is full for. They are resynced before they take the next event.
+void PurpleReign::MidiQueue::discardOldest()
+{
+	uint32_t oldest = m_head - queueSize;
+	if (m_usbCursor == oldest)
+	{
+		skipEvent(m_usbCursor);
+		m_usbDropped++;
+		m_usbResync = true;
+		m_usbResyncChannel = 0;
+	}
+	for (int ix = 0; ix < m_numSinks; ix++)
+	{
+		if (m_sink[ix].cursor == oldest)
+		{
+			skipEvent(m_sink[ix].cursor);
+			m_sink[ix].dropped++;
+			m_sink[ix].resync = true;
+			m_sink[ix].resyncChannel = 0;
+		}
+	}
+	Metrics::increment(METRIC_MIDI_OVERFLOWS);
+}
+
+void PurpleReign::MidiQueue::push(const midiEvent_t &event)
+{
+	if (event.type == EVENT_REALTIME)
+	{
+		pushRealtime(event.channel, event.time, event.flags);
+		return;
+	}
+	uint32_t fill = m_head - oldestCursor();
+	if (fill >= queueSize - noteReserve && (event.type == EVENT_CONTROL_CHANGE || event.type == EVENT_PITCH_BEND || event.type == EVENT_CHANNEL_PRESSURE || event.type == EVENT_POLY_PRESSURE))
+	{
+		Metrics::increment(METRIC_MIDI_CONTROLLERS_SHED);
+		return;
+	}
+	if (fill >= queueSize)
+	{
+		if (event.type == EVENT_NOTE_ON)
+		{
+			Metrics::increment(METRIC_MIDI_NOTE_ONS_SHED);
+			return;
+		}
+		if (event.type == EVENT_NOTE_OFF && !isSounding(m_sounding, event.channel, event.index))
+		{
+			Metrics::increment(METRIC_MIDI_NOTE_OFFS_SHED);
+			return;
+		}
+		discardOldest();
+	}
+	trackNotes(m_sounding, event);
+	uint32_t ix = m_head;
+	if (m_latencyCycles != 0 && event.type != EVENT_SYSEX)
+	{ // Insert by capture time, so the release gate can stop at the first unreleased event: keybed events are backdated (to the switch transition or position
+	  // crossing), while e.g. controller and merged events are stamped when pushed. An event is not moved before one that any output has taken already,
+	  // before a SysEx piece, nor before an event for the same key or controller on its channel.
+		uint32_t newest = newestCursor();
+		while (ix != newest)
+		{
+			const midiEvent_t &prev = m_event[(ix - 1) & (queueSize - 1)];
+			if ((int32_t)(prev.time - event.time) <= 0 || prev.type == EVENT_SYSEX || isSameTarget(prev, event))
+				break;
+			m_event[ix & (queueSize - 1)] = prev;
+			ix--;
+		}
+	}
+	m_event[ix & (queueSize - 1)] = event;
+	m_head++;
+	Metrics::increment(METRIC_MIDI_EVENTS_ENQUEUED);
+	Metrics::peak(METRIC_MIDI_QUEUE_PEAK, fill < queueSize ? fill + 1 : queueSize);
+}
+
+bool PurpleReign::MidiQueue::pushSysex(const uint8_t *message, int length, uint8_t flags, uint32_t captureTime)
+{
+	int numEvents = (length + 2) / 3;
+	if ((int)(m_head - oldestCursor()) + numEvents > queueSize - noteReserve)
+		return false;
+	for (int ix = 0; ix < length; ix += 3)
+	{ // Three bytes per event, the last one (with F7) has 1..3
+		int numBytes = length - ix < 3 ? length - ix : 3;
+		push(MidiEvent::make(EVENT_SYSEX, numBytes, message[ix], numBytes >= 2 ? message[ix + 1] : 0, numBytes >= 3 ? message[ix + 2] : 0, flags, captureTime));
+	}
+	return true;
+}
+
+bool PurpleReign::MidiQueue::pushRealtime(uint8_t status, uint32_t captureTime, uint8_t flags)
+{
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	bool pushed = false;
+	uint8_t head = m_realtimeHead;
+	uint8_t used = head - m_realtimeTail; // The lane is full when it is full for any sink
+	for (int ix = 0; ix < m_numSinks; ix++)
+	{
+		uint8_t sinkUsed = head - m_sink[ix].realtimeCursor;
+		if (sinkUsed > used)
+			used = sinkUsed;
+	}
+	if (used < realtimeQueueSize)
+	{
+		m_realtimeStatus[head & (realtimeQueueSize - 1)] = status;
+		m_realtimeCaptureTime[head & (realtimeQueueSize - 1)] = captureTime;
+		m_realtimeFlags[head & (realtimeQueueSize - 1)] = flags;
+		m_realtimeHead = head + 1;
+		pushed = true;
+	}
+	else
+		m_stats.realtimeDropped++;
+	__set_PRIMASK(primask);
+	return pushed;
+}
+
+bool PurpleReign::MidiQueue::isEmpty()
+{
+	uint8_t realtimeHead = m_realtimeHead;
+	if (m_usbCursor != m_head || m_realtimeTail != realtimeHead || m_usbResync)
+		return false;
+	for (int ix = 0; ix < m_numSinks; ix++)
+		if (m_sink[ix].cursor != m_head || m_sink[ix].realtimeCursor != realtimeHead || m_sink[ix].resync)
+			return false;
+	return true;
+}
+
+void PurpleReign::MidiQueue::setConstantLatency(uint32_t latencyMicros)
+{
+	m_latencyCycles = Timebase::microsToCycles32(latencyMicros);
+}
+
+void PurpleReign::MidiQueue::resetStats()
+{
+	m_stats.released = 0;
+	m_stats.missedDeadlines = 0;
+	m_stats.maxLatenessCycles = 0;
+	m_stats.realtimeReleased = 0;
+	m_stats.realtimeDropped = 0;
+	m_stats.realtimeMinDelayCycles = UINT32_MAX;
+	m_stats.realtimeMaxDelayCycles = 0;
+}
+
+// TXINI is set by the USB controller when the current endpoint bank is free and can be filled (it is also cleared while the device is not configured)
+inline bool PurpleReign::MidiQueue::isUsbTxReady()
+{
+	return (UOTGHS->UOTGHS_DEVEPTISR[PURE_USB_MIDI_TX_ENDPOINT] & UOTGHS_DEVEPTISR_TXINI) != 0;
+}
+
+// Drops the USB backlog, so a host that stopped polling the endpoint does not hold the queue (and the realtime lane) full. Resyncs once USB moves again.
+void PurpleReign::MidiQueue::stallUsb()
+{
+	m_usbDropped += m_head - m_usbCursor;
+	m_usbCursor = m_head;
+	m_realtimeTail = m_realtimeHead;
+	m_usbResync = true;
+	m_usbResyncChannel = 0;
+	if (!m_usbStalled)
+	{
+		m_usbStalled = true;
+		Metrics::increment(METRIC_MIDI_OUTPUT_STALLS);
+		PURE_LOG_WARN(PURE_LOG_MIDI, MIDI_OUTPUT_STALL, 0);
+	}
+}
+
+void PurpleReign::MidiQueue::pumpUsb(uint32_t now)
+{
+	uint8_t realtimeHead = m_realtimeHead;
+	bool realtimePending = (realtimeHead != m_realtimeTail);
+	if (!realtimePending && !m_usbResync && (m_usbCursor == m_head || !isReleased(m_event[m_usbCursor & (queueSize - 1)], now)))
+	{ // Nothing to send (or the oldest event is not released yet, and events are queued in capture order, see push())
+		m_usbProgressTime = now;
+		return;
+	}
+	if (!isUsbTxReady())
+	{ // Endpoint bank still busy, have a new go next invocation (MidiUSB.write() would otherwise busy-wait for it)
+		if (m_usbStalled || now - m_usbProgressTime > Timebase::microsToCycles32(outputStallMicros))
+			stallUsb();
+		return;
+	}
+	m_usbStalled = false;
+
+	uint32_t packets[packetsPerBank];
+	int numPackets = 0;
+
+	// Realtime packets first
+	for (uint8_t tail = m_realtimeTail; tail != realtimeHead && numPackets < packetsPerBank; tail++)
+	{
+		uint8_t status = m_realtimeStatus[tail & (realtimeQueueSize - 1)];
+		packets[numPackets++] = 0x0F | (status << 8); // USB-MIDI CIN 0xF: single byte
+	}
+	int numRealtime = numPackets;
+
+	// Events are encoded with a copy of the encoder state, which is only kept once the bank has been written
+	Midi1Encoder encoder = m_usbEncoder;
+
+	// Then the resync after a loss, whole channels at a time, before any queued event
+	uint8_t resyncChannel = m_usbResyncChannel;
+	for (; m_usbResync && resyncChannel < 16; resyncChannel++)
+	{
+		midiEvent_t events[allNotesOffThreshold];
+		uint32_t channelPackets[allNotesOffThreshold * 2];
+		int numChannelPackets = 0;
+		int numEvents = resyncEvents(m_usbSounding, resyncChannel, events, now);
+		for (int ix = 0; ix < numEvents; ix++)
+			numChannelPackets += encoder.encode(events[ix], &channelPackets[numChannelPackets]);
+		if (numPackets + numChannelPackets > packetsPerBank)
+			break; // Next bank
+		for (int ix = 0; ix < numChannelPackets; ix++)
+			packets[numPackets++] = channelPackets[ix];
+	}
+
+	uint32_t cursor = m_usbCursor;
+	while ((!m_usbResync || resyncChannel == 16) && cursor != m_head && numPackets + Midi1Encoder::maxPackets <= packetsPerBank) // An event takes up to 2 packets (controller MSB + LSB), which are never split between banks
+	{
+		const midiEvent_t &event = m_event[cursor & (queueSize - 1)];
+		if (!isReleased(event, now))
+			break;
+		numPackets += encoder.encode(event, &packets[numPackets]);
+		cursor++;
+	}
+
+	if (numPackets > 0 && MidiUSB.write(reinterpret_cast<uint8_t *>(packets), numPackets * 4) != static_cast<size_t>(numPackets * 4))
+	{
+		Metrics::increment(METRIC_MIDI_USB_WRITE_FAILURES);
+		return; // Not written, the same events are encoded again next invocation (and the output stalls if this goes on)
+	}
+	m_usbProgressTime = now;
+
+	for (int ix = 0; ix < numRealtime; ix++)
+	{
+		uint32_t delay = now - m_realtimeCaptureTime[m_realtimeTail & (realtimeQueueSize - 1)];
+		if (delay < m_stats.realtimeMinDelayCycles)
+			m_stats.realtimeMinDelayCycles = delay;
+		if (delay > m_stats.realtimeMaxDelayCycles)
+			m_stats.realtimeMaxDelayCycles = delay;
+		m_stats.realtimeReleased++;
+		m_realtimeTail = m_realtimeTail + 1; // Only remove packets from the lane once they have been written
+	}
+	if (m_usbResync)
+	{
+		for (; m_usbResyncChannel != resyncChannel; m_usbResyncChannel++)
+			commitResync(m_usbSounding, m_usbResyncChannel);
+		if (resyncChannel == 16)
+		{
+			m_usbResync = false;
+			m_usbResyncChannel = 0;
+			Metrics::increment(METRIC_MIDI_OUTPUT_RESYNCS);
+			PURE_LOG_INFO(PURE_LOG_MIDI, MIDI_OUTPUT_RESYNC, 0);
+		}
+	}
+	for (; m_usbCursor != cursor; m_usbCursor++) // Only move on once the events have been written (or encoded to nothing)
+	{
+		const midiEvent_t &event = m_event[m_usbCursor & (queueSize - 1)];
+		trackNotes(m_usbSounding, event);
+		if (m_latencyCycles)
+		{
+			int32_t lateness = (int32_t)(now - (event.time + m_latencyCycles));
+			if ((uint32_t)lateness > m_stats.maxLatenessCycles)
+				m_stats.maxLatenessCycles = lateness;
+			if ((uint32_t)lateness > Timebase::microsToCycles32(deadlineToleranceMicros))
+				m_stats.missedDeadlines++;
+		}
+		m_stats.released++;
+	}
+	m_usbEncoder = encoder;
+	if (numPackets > 0)
+		MidiUSB.flush(); // Release the bank to the USB controller
+}
+
+void PurpleReign::MidiQueue::pumpSink(sink_t &sink, uint32_t now)
+{
+	int budget = sinkEventsPerPump;
+	uint8_t realtimeHead = m_realtimeHead;
+	if (sink.realtimeCursor == realtimeHead && !sink.resync && (sink.cursor == m_head || !isReleased(m_event[sink.cursor & (queueSize - 1)], now)))
+	{ // Nothing to take
+		sink.progressTime = now;
+		return;
+	}
+
+	bool blocked = false;
+	int taken = 0;
+	while (sink.realtimeCursor != realtimeHead && taken < budget && !blocked)
+	{
+		uint8_t ix = sink.realtimeCursor & (realtimeQueueSize - 1);
+		if (!(m_realtimeFlags[ix] & EVENT_FLAG_USB_ONLY))
+			blocked = !sink.function(MidiEvent::make(EVENT_REALTIME, m_realtimeStatus[ix], 0, 0, 0, m_realtimeFlags[ix], m_realtimeCaptureTime[ix]));
+		if (!blocked)
+		{
+			sink.realtimeCursor = sink.realtimeCursor + 1;
+			taken++;
+		}
+	}
+	while (sink.resync && taken < budget && !blocked)
+	{
+		if (sink.resyncChannel == 16)
+		{
+			sink.resync = false;
+			Metrics::increment(METRIC_MIDI_OUTPUT_RESYNCS);
+			PURE_LOG_INFO(PURE_LOG_MIDI, MIDI_OUTPUT_RESYNC, (int)(&sink - m_sink) + 1);
+			break;
+		}
+		midiEvent_t events[allNotesOffThreshold];
+		int numEvents = resyncEvents(sink.sounding, sink.resyncChannel, events, now);
+		for (int ix = 0; ix < numEvents && !blocked; ix++)
+			blocked = !sink.function(events[ix]); // A channel cut short is sent again from the start, repeated note offs are harmless
+		if (!blocked)
+		{
+			commitResync(sink.sounding, sink.resyncChannel);
+			sink.resyncChannel++;
+			taken += numEvents;
+		}
+	}
+	while (!sink.resync && sink.cursor != m_head && taken < budget && !blocked)
+	{
+		const midiEvent_t &event = m_event[sink.cursor & (queueSize - 1)];
+		if (!isReleased(event, now))
+			break;
+		if (!(event.flags & EVENT_FLAG_USB_ONLY))
+			blocked = !sink.function(event);
+		if (!blocked)
+		{
+			trackNotes(sink.sounding, event);
+			sink.cursor++;
+			taken++;
+		}
+	}
+
+	if (taken > 0 || !blocked)
+		sink.progressTime = now;
+	else if (now - sink.progressTime > Timebase::microsToCycles32(outputStallMicros))
+	{ // Stalled: drop the backlog, so the sink does not hold the queue full, and resync once it takes events again
+		sink.dropped += m_head - sink.cursor;
+		sink.cursor = m_head;
+		sink.realtimeCursor = realtimeHead;
+		sink.resync = true;
+		sink.resyncChannel = 0;
+		sink.progressTime = now;
+		Metrics::increment(METRIC_MIDI_OUTPUT_STALLS);
+		PURE_LOG_WARN(PURE_LOG_MIDI, MIDI_OUTPUT_STALL, (int)(&sink - m_sink) + 1);
+	}
+}
+
+void PurpleReign::MidiQueue::pump()
+{
+	uint32_t now = Timebase::now32();
+	pumpUsb(now);
+	for (int ix = 0; ix < m_numSinks; ix++)
+		pumpSink(m_sink[ix], now);
+}
@@ -0,0 +1,57 @@
+#include <pure_midiserialout.h>
+
+using namespace PurpleReign;
+
+// Number of MIDI bytes per USB-MIDI Code Index Number
+static const uint8_t cinLength[16] = {0, 0, 2, 3, 3, 1, 2, 3, 3, 3, 3, 3, 2, 2, 3, 1};
+
+PurpleReign::MidiSerialOut::MidiSerialOut()
+{
+	m_serial = nullptr;
+	m_runningStatus = 0;
+	m_bytesSent = 0;
+	m_bytesSaved = 0;
+}
+
+void PurpleReign::MidiSerialOut::init(HardwareSerial *serial)
+{
+	m_serial = serial;
+	m_encoder = Midi1Encoder();
+	m_runningStatus = 0;
+	m_bytesSent = 0;
+	m_bytesSaved = 0;
+}
+
+void PurpleReign::MidiSerialOut::writePacket(uint32_t packet)
+{
+	uint8_t cin = packet & 0x0F;
+	uint8_t bytes[3] = {(uint8_t)(packet >> 8), (uint8_t)(packet >> 16), (uint8_t)(packet >> 24)};
+	int length = cinLength[cin];
+	int first = 0;
+	if (cin >= 0x8 && cin <= 0xE)
+	{ // Channel voice
+		if (bytes[0] == m_runningStatus)
+		{
+			first = 1;
+			m_bytesSaved++;
+		}
+		m_runningStatus = bytes[0];
+	}
+	else if (cin != 0xF || bytes[0] < 0xF8)
+		m_runningStatus = 0; // System common and SysEx (also SysEx continue packets, which carry no status byte) cancel running status
+	m_serial->write(&bytes[first], length - first);
+	m_bytesSent += length - first;
+}
+
+bool PurpleReign::MidiSerialOut::send(const midiEvent_t &event)
+{
+	if (m_serial == nullptr)
+		return true; // Not initialized: discard
+	if (m_serial->availableForWrite() < maxEventBytes)
+		return false;
+	uint32_t packets[Midi1Encoder::maxPackets];
+	int numPackets = m_encoder.encode(event, packets);
+	for (int ix = 0; ix < numPackets; ix++)
+		writePacket(packets[ix]);
+	return true;
+}
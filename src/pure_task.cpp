@@ -2,21 +2,26 @@
 
 // #define LOG_MISSED_TICKS
 
+#ifdef LOG_MISSED_TICKS
+void logMissedTicks(int timeStamp, int ticks); // See main.cpp
+#endif
+
 using namespace PurpleReign;
 
 PurpleReign::Task::Task()
 {
 	m_function = nullptr;
-	m_periodInMicros = 0;
-	m_nextTickInMicros = 0;
-
+	m_periodInCycles = 0;
+	m_nextTickInCycles = 0;
+	m_overrunMetric = -1;
 }
 
 PurpleReign::Task::Task(void (*function)(), unsigned long periodInMicros)
 {
 	m_function = function;
-	m_periodInMicros = periodInMicros;
-	m_nextTickInMicros = 0;
+	m_periodInCycles = Timebase::microsToCycles32(periodInMicros);
+	m_nextTickInCycles = 0;
+	m_overrunMetric = -1;
 }
 
 void PurpleReign::Task::init()
@@ -31,22 +36,31 @@ void PurpleReign::Task::setFunction(void (*function)())
 
 void PurpleReign::Task::setPeriod(unsigned long periodInMicros)
 {
-	m_periodInMicros = periodInMicros;
+	m_periodInCycles = Timebase::microsToCycles32(periodInMicros);
 }
 
 void PurpleReign::Task::schedule()
 {
-	unsigned long timeNowInMicros = micros();
+	schedule(Timebase::now());
+}
+
+void PurpleReign::Task::schedule(cycles_t timeNowInCycles)
+{
 	// Only do stuff if tick timer is due
-	if (timeNowInMicros > m_nextTickInMicros)
+	if (timeNowInCycles > m_nextTickInCycles)
 	{
 		// Handle missed/not_missed ticks
-		if (timeNowInMicros > m_nextTickInMicros + m_periodInMicros)
+		if (timeNowInCycles > m_nextTickInCycles + m_periodInCycles)
 		{ //missed one or more ticks!
+			if (m_nextTickInCycles != 0) // Not the first call: that one only aligns the ticks to the period, no tick was missed (or the boot time would count as overruns)
+			{
 #ifdef LOG_MISSED_TICKS
-			logMissedTicks(timeNowInMicros, (timeNowInMicros - nextTickInMicros) / periodInMicros);
+				logMissedTicks(Timebase::cyclesToMicros(timeNowInCycles), (timeNowInCycles - m_nextTickInCycles) / m_periodInCycles);
 #endif
-			m_nextTickInMicros = timeNowInMicros - (timeNowInMicros % m_periodInMicros) + m_periodInMicros; // FF to closest future next tick (= smallest future integer multiple of a period)
+				if (m_overrunMetric >= 0)
+					Metrics::add((metricId_t)m_overrunMetric, (timeNowInCycles - m_nextTickInCycles) / m_periodInCycles);
+			}
+			m_nextTickInCycles = timeNowInCycles - (timeNowInCycles % m_periodInCycles) + m_periodInCycles; // FF to closest future next tick (= smallest future integer multiple of a period)
 																											// TODO (OPTIMIZE): This code should probably not happen often, if at all. Still... Use tick intervals with size 2^n.
 																											// This means "Fast Forward" can be done easier, e.g. by setting the current time "tick fraction" bits to zero and do +1 on "tick integer" .
 																											// E.g.;
@@ -58,7 +72,7 @@ void PurpleReign::Task::schedule()
 		}
 		else
 		{ // Didn't miss any tick(s), just advance to next tick
-			m_nextTickInMicros += m_periodInMicros;
+			m_nextTickInCycles += m_periodInCycles;
 		}
 		m_function(); // call the member function (implicitly dereferencing the member function pointer)
 	}
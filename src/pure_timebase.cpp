@@ -0,0 +1,40 @@
+#include <pure_timebase.h>
+
+using namespace PurpleReign;
+
+uint32_t PurpleReign::Timebase::s_lastCycles32 = 0;
+uint32_t PurpleReign::Timebase::s_wraps = 0;
+
+#ifdef PURE_VIRTUAL_CLOCK
+
+cycles_t PurpleReign::Timebase::s_virtualNow = 0;
+
+void PurpleReign::Timebase::init()
+{
+	s_virtualNow = 0;
+	s_lastCycles32 = 0;
+	s_wraps = 0;
+}
+
+void PurpleReign::Timebase::setVirtualNow(cycles_t now)
+{
+	s_virtualNow = now;
+}
+
+void PurpleReign::Timebase::advanceVirtualNow(cycles_t cycles)
+{
+	s_virtualNow += cycles;
+}
+
+#else
+
+void PurpleReign::Timebase::init()
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk; // Enable the DWT (and ITM) blocks
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; // Start the cycle counter
+	s_lastCycles32 = 0;
+	s_wraps = 0;
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef PURE_VIRTUAL_CLOCK
+#include <Arduino.h>
+#endif
+
+#include <pure_velocitycurve.h>
+
+using namespace PurpleReign;
+
+PurpleReign::VelocityCurve::VelocityCurve()
+{
+	m_curveType = LIN_STD;
+	select(LIN_STD);
+}
+
+PurpleReign::VelocityCurve::VelocityCurve(int curveType)
+{
+	m_curveType = LIN_STD;
+	select(LIN_STD);
+	select(curveType);
+}
+
+void PurpleReign::VelocityCurve::select(int curveType)
+{
+	if (curveType < 0 || curveType >= NUM_VELOCITY_CURVES)
+		return;
+#ifdef VELOCITY_CURVE_INTERPOLATE
+	m_map = velocityCurveBankCoarse[curveType];
+#else
+	m_map = velocityCurveBank[curveType];
+#endif
+	m_map16 = velocityCurveBank16[curveType];
+	m_curveType = curveType;
+}
+
+int PurpleReign::VelocityCurve::curveType()
+{
+	return m_curveType;
+}
+
+#ifndef PURE_VIRTUAL_CLOCK
+
+void PurpleReign::VelocityCurve::dump()
+{
+	for (int stopwatch = 0; stopwatch <= velocityStopWatchMaxValue; stopwatch++)
+	{
+		SerialUSB.print(velocity(stopwatch));
+		SerialUSB.print(" ");
+	}
+	SerialUSB.println("");
+}
+
+#endif
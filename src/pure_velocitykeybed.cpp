@@ -1,8 +0,0 @@
-#include <pure_velocitykeybed.h>
-
-using namespace PurpleReign;
-
-int PurpleReign::VelocityKeybed::init()
-{
-	return 0;
-}
\ No newline at end of file
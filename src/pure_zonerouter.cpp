@@ -0,0 +1,43 @@
+#include <pure_zonerouter.h>
+
+using namespace PurpleReign;
+
+PurpleReign::ZoneRouter::ZoneRouter()
+{
+	for (int key = 0; key < maxKeys; key++)
+		m_noteOnRoute[key].numOutputs = 0;
+	setZones(nullptr, 0); // No zones, no outputs
+}
+
+bool PurpleReign::ZoneRouter::setZones(const zone_t *zones, int numZones)
+{
+	if (numZones < 0 || numZones > maxZones)
+		return false;
+	for (int zone = 0; zone < numZones; zone++)
+	{
+		if (zones[zone].lowKey > zones[zone].highKey || zones[zone].highKey >= maxKeys || zones[zone].channel > 15)
+			return false;
+	}
+
+	routeTable_t &table = m_table.edit();
+	for (int key = 0; key < maxKeys; key++)
+	{
+		route_t &route = table.route[key];
+		route.numOutputs = 0;
+		for (int zone = 0; zone < numZones; zone++)
+		{
+			if (key < zones[zone].lowKey || key > zones[zone].highKey)
+				continue;
+			int note = key + zones[zone].noteOffset;
+			if (note < 0 || note > 127)
+				continue; // Transposed out of the MIDI note range
+			if (route.numOutputs == maxLayers)
+				return false; // The shadow copy is left half compiled, but it is not published
+			route.output[route.numOutputs].note = note;
+			route.output[route.numOutputs].channel = zones[zone].channel;
+			route.numOutputs++;
+		}
+	}
+	m_table.publish();
+	return true;
+}
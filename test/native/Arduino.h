@@ -0,0 +1,45 @@
+#ifndef PURE_NATIVE_ARDUINO_H
+#define PURE_NATIVE_ARDUINO_H
+
+// Host stand-in for the few Arduino (SAM3X) definitions that the hardware independent modules use, for the unit tests (env:native).
+// Not an emulation of the board: interrupt masking does nothing, and the USB IN endpoint is ready whenever a test says so (see MIDIUSB.h).
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+class Print
+{
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t byte) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size)
+	{
+		size_t written = 0;
+		while (size-- > 0)
+			written += write(*buffer++);
+		return written;
+	}
+};
+
+inline uint32_t __get_PRIMASK() { return 0; }
+inline void __set_PRIMASK(uint32_t) {}
+inline void __disable_irq() {}
+inline void __enable_irq() {}
+
+// USB device endpoint interrupt status registers, only TXINI (IN bank free) is used
+struct hostUotghs_t
+{
+	uint32_t UOTGHS_DEVEPTISR[10];
+};
+
+inline hostUotghs_t *hostUotghs()
+{
+	static hostUotghs_t uotghs;
+	return &uotghs;
+}
+
+#define UOTGHS (hostUotghs())
+#define UOTGHS_DEVEPTISR_TXINI (0x1u << 0)
+
+#endif /* PURE_NATIVE_ARDUINO_H */
@@ -0,0 +1,36 @@
+#ifndef PURE_NATIVE_MIDIUSB_H
+#define PURE_NATIVE_MIDIUSB_H
+
+// Host stand-in for the MIDIUSB library, for the unit tests (env:native). Keeps the written USB-MIDI event packets for the test to check.
+
+#include <Arduino.h>
+
+#include <vector>
+
+class MIDI_
+{
+public:
+	std::vector<uint32_t> written;
+
+	size_t write(const uint8_t *buffer, size_t size)
+	{
+		for (size_t ix = 0; ix + 4 <= size; ix += 4)
+		{
+			uint32_t packet;
+			memcpy(&packet, &buffer[ix], 4);
+			written.push_back(packet);
+		}
+		return size;
+	}
+	void flush() {}
+};
+
+inline MIDI_ &hostMidiUsb()
+{
+	static MIDI_ midiUsb;
+	return midiUsb;
+}
+
+#define MidiUSB (hostMidiUsb())
+
+#endif /* PURE_NATIVE_MIDIUSB_H */
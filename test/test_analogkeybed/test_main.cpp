@@ -0,0 +1,172 @@
+// Host unit test of AnalogKeybed, with KeyMotionModel as the position source and the virtual clock (pio test -e native).
+
+#include <unity.h>
+
+#include <pure_analogkeybed.h>
+#include <pure_keymotionmodel.h>
+#include <pure_timebase.h>
+#include <pure_velocitycurve.h>
+
+using namespace PurpleReign;
+
+const uint16_t restRaw = 1000;
+const uint16_t bottomRaw = 3000;
+const uint32_t scanMicros = 100;	   // Per key sample rate of 10 kHz
+const int triggerPosition = 512;	   // AnalogKeybed defaults
+const int releasePosition = 384;
+const int aftertouchStartPosition = 1056;
+
+static KeyMotionModel model(restRaw, bottomRaw);
+static AnalogKeybed keybed;
+static VelocityCurve velocityCurve(LIN_STD);
+
+static int prevPosition; // Key position at the scan before the current one
+
+static int numNoteOns;
+static int noteOnVelocity;
+static int noteOnPosition;
+static int noteOnPrevPosition;
+static uint32_t noteOnEventTime;
+
+static int numNoteOffs;
+static int noteOffPosition;
+static int noteOffPrevPosition;
+
+static int numAftertouches;
+static int maxPressure;
+static int lastPressure;
+static int firstPressurePosition;
+
+static uint16_t modelPosition(int key)
+{
+	return model.raw(key);
+}
+
+static void noteOn(int keyAddress, uint8_t velocity)
+{
+	numNoteOns++;
+	noteOnVelocity = velocity;
+	noteOnPosition = keybed.position(keyAddress);
+	noteOnPrevPosition = prevPosition;
+	noteOnEventTime = keybed.eventTime();
+}
+
+static void noteOff(int keyAddress)
+{
+	numNoteOffs++;
+	noteOffPosition = keybed.position(keyAddress);
+	noteOffPrevPosition = prevPosition;
+}
+
+static void aftertouch(int keyAddress, uint8_t pressure)
+{
+	if (numAftertouches == 0)
+		firstPressurePosition = keybed.position(keyAddress);
+	numAftertouches++;
+	lastPressure = pressure;
+	if (pressure > maxPressure)
+		maxPressure = pressure;
+}
+
+void setUp()
+{
+	Timebase::init();
+	model = KeyMotionModel(restRaw, bottomRaw);
+	keybed = AnalogKeybed();
+	keybed.init(1, modelPosition, bottomRaw - restRaw);
+	keybed.setVelocityCurve(&velocityCurve);
+	keybed.setNoteOnFunction(noteOn);
+	keybed.setNoteOffFunction(noteOff);
+	keybed.setAftertouchFunction(aftertouch);
+	prevPosition = 0;
+	numNoteOns = numNoteOffs = numAftertouches = 0;
+	noteOnVelocity = noteOnPosition = noteOnPrevPosition = -1;
+	noteOffPosition = noteOffPrevPosition = -1;
+	maxPressure = lastPressure = 0;
+	firstPressurePosition = -1;
+	noteOnEventTime = 0;
+}
+
+void tearDown()
+{
+}
+
+// Plays one stroke of key 0 and scans until the key is back at rest
+static void play(uint32_t pressMicros, uint32_t holdMicros, uint32_t releaseMicros, int overtravel)
+{
+	model.press(0, pressMicros, holdMicros, releaseMicros, overtravel);
+	uint32_t endMicros = pressMicros + holdMicros + releaseMicros + 10 * scanMicros;
+	for (uint32_t micros = 0; micros < endMicros; micros += scanMicros)
+	{
+		Timebase::advanceVirtualNow(Timebase::microsToCycles(scanMicros));
+		prevPosition = keybed.position(0);
+		keybed.scan();
+	}
+}
+
+void test_note_on_at_trigger_point()
+{
+	const uint32_t pressMicros = 10000;
+	play(pressMicros, 20000, 10000, 0);
+	TEST_ASSERT_EQUAL(1, numNoteOns);
+	TEST_ASSERT_GREATER_OR_EQUAL(triggerPosition, noteOnPosition);
+	TEST_ASSERT_LESS_THAN(triggerPosition, noteOnPrevPosition);
+	// The key moves at constant speed, so the interpolated crossing time is (close to) when the model passes the trigger point
+	uint32_t expectedCycles = Timebase::microsToCycles32(pressMicros * triggerPosition / analogKeyPositionMax);
+	TEST_ASSERT_UINT32_WITHIN(Timebase::microsToCycles32(2), expectedCycles, noteOnEventTime);
+}
+
+void test_velocity_monotonic_in_press_time()
+{
+	int fastestVelocity = -1;
+	int prevVelocity = 127;
+	for (uint32_t pressMicros = 1000; pressMicros <= 300000; pressMicros += pressMicros / 2)
+	{
+		setUp();
+		play(pressMicros, 20000, 10000, 0);
+		TEST_ASSERT_EQUAL(1, numNoteOns);
+		TEST_ASSERT_GREATER_OR_EQUAL(1, noteOnVelocity);
+		TEST_ASSERT_LESS_OR_EQUAL(prevVelocity, noteOnVelocity); // A slower press never gives a higher velocity
+		if (fastestVelocity < 0)
+			fastestVelocity = noteOnVelocity;
+		prevVelocity = noteOnVelocity;
+	}
+	TEST_ASSERT_LESS_THAN(fastestVelocity, prevVelocity); // ... and the slowest one a lower velocity than the fastest one
+}
+
+void test_release_at_release_point()
+{
+	play(10000, 20000, 10000, 0);
+	TEST_ASSERT_EQUAL(1, numNoteOffs);
+	TEST_ASSERT_LESS_OR_EQUAL(releasePosition, noteOffPosition);
+	TEST_ASSERT_GREATER_THAN(releasePosition, noteOffPrevPosition);
+}
+
+void test_no_aftertouch_at_the_bottom()
+{
+	play(10000, 50000, 10000, 0);
+	TEST_ASSERT_EQUAL(1, numNoteOns);
+	TEST_ASSERT_EQUAL(0, numAftertouches);
+}
+
+void test_aftertouch_beyond_the_bottom()
+{
+	play(10000, 50000, 10000, 128);
+	TEST_ASSERT_EQUAL(1, numNoteOns);
+	TEST_ASSERT_GREATER_THAN(0, numAftertouches);
+	TEST_ASSERT_GREATER_THAN(aftertouchStartPosition, firstPressurePosition);
+	TEST_ASSERT_GREATER_THAN(0, maxPressure);
+	TEST_ASSERT_EQUAL(0, lastPressure); // Back to 0, at the latest when the key is released
+	TEST_ASSERT_EQUAL(1, numNoteOffs);
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_note_on_at_trigger_point);
+	RUN_TEST(test_velocity_monotonic_in_press_time);
+	RUN_TEST(test_release_at_release_point);
+	RUN_TEST(test_no_aftertouch_at_the_bottom);
+	RUN_TEST(test_aftertouch_beyond_the_bottom);
+	return UNITY_END();
+}
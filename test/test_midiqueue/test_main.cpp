@@ -0,0 +1,272 @@
+// Host unit test of MidiQueue, on the virtual clock and the host stand-ins of test/native (pio test -e native).
+
+#include <unity.h>
+
+#include <MIDIUSB.h>
+
+#include <pure_metrics.h>
+#include <pure_midiqueue.h>
+#include <pure_timebase.h>
+
+#include <string.h>
+#include <vector>
+
+using namespace PurpleReign;
+
+const uint32_t latencyMicros = 1000;
+const uint32_t startMicros = 1000000;
+
+static MidiQueue *queue;
+static std::vector<midiEvent_t> sinkEvents;
+static bool sinkBlocked; // The sink takes no events, like a full UART buffer
+
+static bool recordSink(const midiEvent_t &event)
+{
+	if (sinkBlocked)
+		return false;
+	sinkEvents.push_back(event);
+	return true;
+}
+
+static void setUsbReady(bool ready)
+{
+	UOTGHS->UOTGHS_DEVEPTISR[PURE_USB_MIDI_TX_ENDPOINT] = ready ? UOTGHS_DEVEPTISR_TXINI : 0;
+}
+
+static uint32_t atMicros(int32_t micros)
+{
+	return Timebase::microsToCycles32(startMicros + micros);
+}
+
+static void pumpAt(int32_t micros)
+{
+	Timebase::setVirtualNow(atMicros(micros));
+	queue->pump();
+}
+
+static void pumpRepeatedAt(int32_t micros)
+{
+	for (int ix = 0; ix < 100; ix++)
+		pumpAt(micros);
+}
+
+static uint32_t usbNote(uint8_t status, uint8_t key, uint8_t velocity)
+{
+	return (status >> 4) | (status << 8) | ((uint32_t)key << 16) | ((uint32_t)velocity << 24);
+}
+
+// The notes a receiver plays, from the events it was sent
+struct receiver_t
+{
+	bool sounding[16][128];
+
+	receiver_t() { memset(sounding, 0, sizeof(sounding)); }
+
+	void play(uint8_t status, uint8_t data1, uint8_t data2)
+	{
+		uint8_t channel = status & 0x0F;
+		if ((status & 0xF0) == 0x90)
+			sounding[channel][data1 & 0x7F] = data2 != 0;
+		else if ((status & 0xF0) == 0x80)
+			sounding[channel][data1 & 0x7F] = false;
+		else if ((status & 0xF0) == 0xB0 && data1 == 123)
+			memset(sounding[channel], 0, sizeof(sounding[channel]));
+	}
+
+	int numHanging() // Notes sounding that the queue has no note on for
+	{
+		int numHanging = 0;
+		for (int channel = 0; channel < 16; channel++)
+			for (int key = 0; key < 128; key++)
+				if (sounding[channel][key] && !queue->isSounding(channel, key))
+					numHanging++;
+		return numHanging;
+	}
+
+	int numSounding()
+	{
+		int numSounding = 0;
+		for (int channel = 0; channel < 16; channel++)
+			for (int key = 0; key < 128; key++)
+				numSounding += sounding[channel][key];
+		return numSounding;
+	}
+};
+
+static receiver_t sinkReceiver()
+{
+	receiver_t receiver;
+	for (size_t ix = 0; ix < sinkEvents.size(); ix++)
+	{
+		const midiEvent_t &event = sinkEvents[ix];
+		if (event.type == EVENT_NOTE_ON)
+			receiver.play(0x90 | event.channel, event.index, event.value);
+		else if (event.type == EVENT_NOTE_OFF)
+			receiver.play(0x80 | event.channel, event.index, 0);
+		else if (event.type == EVENT_CONTROL_CHANGE)
+			receiver.play(0xB0 | event.channel, event.index, event.value);
+	}
+	return receiver;
+}
+
+static receiver_t usbReceiver()
+{
+	receiver_t receiver;
+	for (size_t ix = 0; ix < MidiUSB.written.size(); ix++)
+	{
+		uint32_t packet = MidiUSB.written[ix];
+		receiver.play((packet >> 8) & 0xFF, (packet >> 16) & 0xFF, (packet >> 24) & 0xFF);
+	}
+	return receiver;
+}
+
+void setUp()
+{
+	Timebase::init();
+	Timebase::setVirtualNow(atMicros(0));
+	queue = new MidiQueue();
+	queue->addSink(recordSink);
+	queue->init();
+	sinkEvents.clear();
+	sinkBlocked = false;
+	MidiUSB.written.clear();
+	setUsbReady(true);
+}
+
+void tearDown()
+{
+	delete queue;
+}
+
+// A backdated keybed note pushed after a controller stamped at push time is released at its own deadline, not held back behind the controller
+void test_backdated_note_released_on_time()
+{
+	queue->setConstantLatency(latencyMicros);
+	queue->push(MidiEvent::controlChange7(0, 7, 100, atMicros(0)));
+	queue->push(MidiEvent::noteOn(0, 60, 100, 0, atMicros(-200)));
+
+	pumpAt(799);
+	TEST_ASSERT_EQUAL(0, MidiUSB.written.size());
+	pumpAt(800);
+	TEST_ASSERT_EQUAL(1, MidiUSB.written.size());
+	TEST_ASSERT_EQUAL_HEX32(usbNote(0x90, 60, 100), MidiUSB.written[0]);
+	TEST_ASSERT_EQUAL(1, sinkEvents.size());
+	TEST_ASSERT_EQUAL(EVENT_NOTE_ON, sinkEvents[0].type);
+
+	pumpAt(1000);
+	TEST_ASSERT_EQUAL(2, MidiUSB.written.size());
+	TEST_ASSERT_EQUAL(2, sinkEvents.size());
+	TEST_ASSERT_EQUAL(EVENT_CONTROL_CHANGE, sinkEvents[1].type);
+	TEST_ASSERT_EQUAL(0, queue->stats().missedDeadlines);
+}
+
+// Events for the same key keep their push order, even when the later one has an earlier capture time
+void test_same_key_order_kept()
+{
+	queue->setConstantLatency(latencyMicros);
+	queue->push(MidiEvent::noteOn(0, 60, 100, 0, atMicros(0)));
+	queue->push(MidiEvent::noteOff(0, 60, 0, 0, atMicros(-100)));
+	queue->push(MidiEvent::noteOn(1, 60, 100, 0, atMicros(-300)));
+
+	pumpAt(1000);
+	TEST_ASSERT_EQUAL(3, sinkEvents.size());
+	TEST_ASSERT_EQUAL(1, sinkEvents[0].channel); // The other channel's note went first, by its capture time
+	TEST_ASSERT_EQUAL(EVENT_NOTE_ON, sinkEvents[1].type);
+	TEST_ASSERT_EQUAL(EVENT_NOTE_OFF, sinkEvents[2].type);
+	TEST_ASSERT_FALSE(queue->isSounding(0, 60));
+}
+
+// Without constant latency, events are sent in push order
+void test_push_order_without_latency()
+{
+	queue->push(MidiEvent::controlChange7(0, 7, 100, atMicros(0)));
+	queue->push(MidiEvent::noteOn(0, 60, 100, 0, atMicros(-200)));
+
+	pumpAt(0);
+	TEST_ASSERT_EQUAL(2, sinkEvents.size());
+	TEST_ASSERT_EQUAL(EVENT_CONTROL_CHANGE, sinkEvents[0].type);
+	TEST_ASSERT_EQUAL(EVENT_NOTE_ON, sinkEvents[1].type);
+}
+
+// A sink that stops taking events fills the queue: controllers are shed first, then note ons, and the note offs that have to be queued
+// overflow the sink, which is then stalled and resynced. Neither receiver is left with a note sounding that the queue has no note on for.
+void test_stalled_sink_leaves_no_hanging_note()
+{
+	uint32_t controllersShed = Metrics::value(METRIC_MIDI_CONTROLLERS_SHED);
+	uint32_t noteOnsShed = Metrics::value(METRIC_MIDI_NOTE_ONS_SHED);
+	uint32_t noteOffsShed = Metrics::value(METRIC_MIDI_NOTE_OFFS_SHED);
+	uint32_t overflows = Metrics::value(METRIC_MIDI_OVERFLOWS);
+	uint32_t stalls = Metrics::value(METRIC_MIDI_OUTPUT_STALLS);
+	uint32_t resyncs = Metrics::value(METRIC_MIDI_OUTPUT_RESYNCS);
+	uint32_t resyncNoteOffs = Metrics::value(METRIC_MIDI_RESYNC_NOTE_OFFS);
+	uint32_t allNotesOffs = Metrics::value(METRIC_MIDI_ALL_NOTES_OFFS);
+
+	// Both outputs play 10 notes on channel 1 and 3 on channel 2
+	for (uint8_t key = 40; key < 50; key++)
+		queue->push(MidiEvent::noteOn(0, key, 100, 0, atMicros(0)));
+	for (uint8_t key = 40; key < 43; key++)
+		queue->push(MidiEvent::noteOn(1, key, 100, 0, atMicros(0)));
+	pumpRepeatedAt(0);
+	TEST_ASSERT_EQUAL(13, sinkEvents.size());
+
+	// The sink stops taking events, and holds the queue: their note offs and the controllers fill it up to the note reserve
+	sinkBlocked = true;
+	for (uint8_t key = 40; key < 50; key++)
+		queue->push(MidiEvent::noteOff(0, key, 0, 0, atMicros(1000)));
+	for (uint8_t key = 40; key < 43; key++)
+		queue->push(MidiEvent::noteOff(1, key, 0, 0, atMicros(1000)));
+	for (int ix = 0; ix < 90; ix++)
+		queue->push(MidiEvent::controlChange7(0, 1, ix, atMicros(1000)));
+	pumpRepeatedAt(1000);
+	TEST_ASSERT_EQUAL(MidiQueue::queueSize - MidiQueue::noteReserve, queue->fill());
+	TEST_ASSERT_EQUAL(90 - (MidiQueue::queueSize - MidiQueue::noteReserve - 13), Metrics::value(METRIC_MIDI_CONTROLLERS_SHED) - controllersShed);
+	TEST_ASSERT_EQUAL(0, Metrics::value(METRIC_MIDI_NOTE_ONS_SHED) - noteOnsShed);
+
+	// Note ons take the note reserve, then are shed, and so are the note offs of the notes shed
+	for (uint8_t key = 60; key < 101; key++)
+		queue->push(MidiEvent::noteOn(2, key, 100, 0, atMicros(2000)));
+	TEST_ASSERT_EQUAL(MidiQueue::queueSize, queue->fill());
+	TEST_ASSERT_EQUAL(41 - MidiQueue::noteReserve, Metrics::value(METRIC_MIDI_NOTE_ONS_SHED) - noteOnsShed);
+	queue->push(MidiEvent::noteOff(2, 100, 0, 0, atMicros(2000)));
+	TEST_ASSERT_EQUAL(1, Metrics::value(METRIC_MIDI_NOTE_OFFS_SHED) - noteOffsShed);
+	TEST_ASSERT_EQUAL(0, Metrics::value(METRIC_MIDI_OVERFLOWS) - overflows);
+
+	// The note off of a sounding note is queued anyway, by discarding the oldest event of the sink
+	queue->push(MidiEvent::noteOff(2, 60, 0, 0, atMicros(2000)));
+	TEST_ASSERT_EQUAL(1, Metrics::value(METRIC_MIDI_OVERFLOWS) - overflows);
+	pumpRepeatedAt(2000);
+	TEST_ASSERT_EQUAL(13, sinkEvents.size());
+	TEST_ASSERT_EQUAL(0, Metrics::value(METRIC_MIDI_OUTPUT_STALLS) - stalls);
+
+	// The sink makes no progress for outputStallMicros: its backlog is dropped, and the queue is free again
+	pumpRepeatedAt(2000 + MidiQueue::outputStallMicros + 1000);
+	TEST_ASSERT_EQUAL(1, Metrics::value(METRIC_MIDI_OUTPUT_STALLS) - stalls);
+	TEST_ASSERT_EQUAL(0, queue->fill());
+
+	// Once the sink takes events again, it is resynced: All Notes Off on channel 1 (more than allNotesOffThreshold notes), note offs on channel 2
+	sinkBlocked = false;
+	pumpRepeatedAt(2000 + MidiQueue::outputStallMicros + 2000);
+	TEST_ASSERT_EQUAL(1, Metrics::value(METRIC_MIDI_OUTPUT_RESYNCS) - resyncs);
+	TEST_ASSERT_EQUAL(1, Metrics::value(METRIC_MIDI_ALL_NOTES_OFFS) - allNotesOffs);
+	TEST_ASSERT_EQUAL(3, Metrics::value(METRIC_MIDI_RESYNC_NOTE_OFFS) - resyncNoteOffs);
+	TEST_ASSERT_EQUAL(0, sinkReceiver().numHanging());
+	TEST_ASSERT_EQUAL(0, sinkReceiver().numSounding());
+	TEST_ASSERT_EQUAL(0, usbReceiver().numHanging());
+
+	// Events pushed from then on reach the sink again
+	for (uint8_t key = 61; key < 60 + MidiQueue::noteReserve; key++)
+		queue->push(MidiEvent::noteOff(2, key, 0, 0, atMicros(3000 + MidiQueue::outputStallMicros)));
+	pumpRepeatedAt(3000 + MidiQueue::outputStallMicros);
+	TEST_ASSERT_EQUAL(0, usbReceiver().numSounding());
+	TEST_ASSERT_EQUAL(0, sinkReceiver().numHanging());
+}
+
+int main()
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_backdated_note_released_on_time);
+	RUN_TEST(test_same_key_order_kept);
+	RUN_TEST(test_push_order_without_latency);
+	RUN_TEST(test_stalled_sink_leaves_no_hanging_note);
+	return UNITY_END();
+}
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+#
+# Decodes the binary log frames of PurpleReign::Log (see include/pure_log.h) sent over SerialUSB, and prints them as text.
+#
+# Frame: 0xA5, payload length, payload, checksum (sum of the payload bytes, modulo 256).
+# Payload (little endian): time (DWT cycles, 4 bytes), format ID (2 bytes), level, subsystem, arguments (4 bytes each).
+#
+# The format strings are read from include/pure_logformats.h (one X(ID, "format") per line, the ID is the line's index).
+# Bytes outside of frames are plain text (boot diagnostics, LOG_* statistics) and are passed through as is.
+# Metrics snapshot frames (0xA6, see tools/query_metrics.py) on the same port are printed as well.
+#
+# Usage: python3 tools/decode_log.py /dev/ttyACM0      (needs pyserial)
+#        python3 tools/decode_log.py capture.bin       (a raw capture of the port)
+#        python3 tools/decode_log.py - < capture.bin
+
+import os
+import re
+import struct
+import sys
+
+import query_metrics
+
+FRAME_START = 0xA5
+MCK = 84000000  # Must match VARIANT_MCK (Timebase cycles per second)
+LEVELS = {1: "ERROR", 2: "WARN", 3: "INFO", 4: "DEBUG", 5: "TRACE"}
+SUBSYSTEMS = {0x01: "core", 0x02: "keybed", 0x04: "ctrl", 0x08: "midi", 0x10: "config"}  # Must match PURE_LOG_* in include/pure_log.h
+
+FORMATS_FILE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "include", "pure_logformats.h")
+FORMAT_RE = re.compile(r'^\s*X\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', re.MULTILINE)
+CONVERSION_RE = re.compile(r"%([-+ 0#]*\d*(?:\.\d+)?)([duxf])")
+
+
+def load_formats(path):
+    with open(path) as f:
+        text = f.read()
+    return [(match.group(1), match.group(2).encode().decode("unicode_escape")) for match in FORMAT_RE.finditer(text)]
+
+
+def format_message(fmt, args):
+    values = iter(args)
+
+    def convert(match):
+        word = next(values, None)
+        if word is None:
+            return "<missing>"
+        flags, conversion = match.group(1), match.group(2)
+        if conversion == "d":
+            value = struct.unpack("<i", struct.pack("<I", word))[0]
+        elif conversion == "f":
+            value = struct.unpack("<f", struct.pack("<I", word))[0]
+        else:
+            value = word
+        return ("%" + flags + conversion) % value
+
+    return CONVERSION_RE.sub(convert, fmt)
+
+
+def decode_payload(payload, formats):
+    time, format_id, level, subsystem = struct.unpack_from("<IHBB", payload)
+    args = struct.unpack_from("<%dI" % ((len(payload) - 8) // 4), payload, 8)
+    if format_id < len(formats):
+        name, fmt = formats[format_id]
+        message = format_message(fmt, args)
+    else:
+        message = "unknown format %d, args %s" % (format_id, " ".join("0x%08x" % a for a in args))
+    return "[%12.6f] %-5s %-6s %s" % (time / MCK, LEVELS.get(level, str(level)), SUBSYSTEMS.get(subsystem, "0x%02x" % subsystem), message)
+
+
+def find_frame(buffer):
+    starts = [ix for ix in (buffer.find(FRAME_START), buffer.find(query_metrics.FRAME_START)) if ix >= 0]
+    return min(starts) if starts else -1
+
+
+def decode(stream, formats, out):
+    metrics = query_metrics.load_metrics()
+    buffer = bytearray()
+    while True:
+        chunk = stream.read(1 if hasattr(stream, "in_waiting") else 4096)
+        if not chunk:
+            break
+        buffer += chunk
+        while buffer:
+            start = find_frame(buffer)
+            if start != 0:
+                text = buffer if start < 0 else buffer[:start]
+                out.write(text.decode("ascii", "replace"))
+                del buffer[: len(text)]
+                continue
+            if len(buffer) < 2:
+                break
+            length = buffer[1]
+            if buffer[0] == query_metrics.FRAME_START:
+                if len(buffer) < length + 3:
+                    break
+                payload = bytes(buffer[2 : 2 + length])
+                if length < 5 or length != 5 + 4 * payload[4] or sum(payload) & 0xFF != buffer[2 + length]:
+                    del buffer[0]  # Not a frame
+                    continue
+                out.write(query_metrics.format_snapshot(*query_metrics.decode_frame_payload(payload), metrics) + "\n")
+                del buffer[: length + 3]
+                continue
+            if length < 8 or (length - 8) % 4 != 0:
+                del buffer[0]  # Not a frame
+                continue
+            if len(buffer) < length + 3:
+                break
+            payload = bytes(buffer[2 : 2 + length])
+            if sum(payload) & 0xFF != buffer[2 + length]:
+                del buffer[0]  # Corrupt, resync on the next frame byte
+                continue
+            out.write(decode_payload(payload, formats) + "\n")
+            del buffer[: length + 3]
+        out.flush()
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("Usage: decode_log.py <serial port | capture file | ->")
+    formats = load_formats(FORMATS_FILE)
+    source = sys.argv[1]
+    if source == "-":
+        decode(sys.stdin.buffer, formats, sys.stdout)
+    elif os.path.isfile(source):
+        with open(source, "rb") as f:
+            decode(f, formats, sys.stdout)
+    else:
+        import serial  # pyserial
+
+        with serial.Serial(source, 115200) as port:
+            decode(port, formats, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
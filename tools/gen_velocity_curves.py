@@ -0,0 +1,121 @@
+#!/usr/bin/env python3
+#
+# Generates src/pure_velocitycurve_tables.cpp, the flash resident bank of velocity curves used by PurpleReign::VelocityCurve.
+#
+# Each curve maps a key velocity stopwatch value x (0..velocityStopWatchMaxValue, in keybed scan ticks) to a MIDI velocity (1..127).
+# A low stopwatch value means a fast key stroke and thus a high velocity. Velocity 0 is never produced since it means note-off in MIDI 1.0.
+#
+# Two banks are generated:
+#  * velocityCurveBank[][]: one entry per stopwatch value (full resolution).
+#  * velocityCurveBankCoarse[][]: one entry per (1 << COARSE_SHIFT) stopwatch values, to be linearly interpolated at runtime (see VELOCITY_CURVE_INTERPOLATE).
+#
+# Plus one bank of 16-bit velocities (MIDI 2.0), always generated:
+#  * velocityCurveBank16[][]: the unrounded curves scaled to 1..65535, one entry per (1 << COARSE_SHIFT) stopwatch values, interpolated at runtime
+#    with the fractional stopwatch value (see VelocityCurve::velocity16()).
+#
+# The banks are marked PURE_HOT_DATA, so they are placed in SRAM when PURE_RAM_HOT_PATH is defined (see include/pure_ramfunc.h).
+#
+# Usage: python3 tools/gen_velocity_curves.py > src/pure_velocitycurve_tables.cpp
+#
+# The curve order MUST match velocityCurveType_t in include/pure_velocitycurve.h.
+
+import math
+
+STOPWATCH_MAX = 1000  # Must match velocityStopWatchMaxValue
+COARSE_SHIFT = 3      # Must match velocityCurveCoarseShift
+VALUES_PER_LINE = 20
+
+
+def clamp(v):
+    return max(1, min(127, v))
+
+
+def lin_exact(x, xMin):
+    # Linear from 127 (x = 0) down to 1 (x >= xMin)
+    return 1 + 126 * max(0.0, 1 - x / xMin)
+
+
+def log_exact(x, a):
+    # Logarithmic (concave); velocity stays high for moderately fast strokes and drops off towards the slow end
+    return 1 + 126 * math.log(1 + a * (1 - x)) / math.log(1 + a)
+
+
+def exp_exact(x, n):
+    # Exponential (convex); the legacy EXP_8 formula from initVelocityMap()
+    return (1.0 / n) * math.pow(126 * n, 1 - x) + 1
+
+
+def lin(x, xMin):
+    return clamp(int(round(lin_exact(x, xMin))))
+
+
+def log_(x, a):
+    return clamp(int(round(log_exact(x, a))))
+
+
+def exp_(x, n):
+    # Truncated the same way as the legacy formula
+    return clamp(int(exp_exact(x, n)))
+
+
+def to16(v):
+    # Unrounded 7-bit curve value (1..127) to a 16-bit velocity (1..65535)
+    return max(1, min(65535, int(round(v * 65535 / 127))))
+
+
+CURVES = [
+    ("LIN_STD", lambda x: lin(x, 1.0)),
+    ("LIN_1", lambda x: lin(x, 0.5)),
+    ("LIN_2", lambda x: lin(x, 0.25)),
+    ("LOG_STD", lambda x: log_(x, 9)),
+    ("LOG_1", lambda x: log_(x, 99)),
+    ("LOG_2", lambda x: log_(x, 999)),
+    ("EXP_8", lambda x: exp_(x, 8)),
+]
+
+CURVES16 = [
+    ("LIN_STD", lambda x: to16(lin_exact(x, 1.0))),
+    ("LIN_1", lambda x: to16(lin_exact(x, 0.5))),
+    ("LIN_2", lambda x: to16(lin_exact(x, 0.25))),
+    ("LOG_STD", lambda x: to16(log_exact(x, 9))),
+    ("LOG_1", lambda x: to16(log_exact(x, 99))),
+    ("LOG_2", lambda x: to16(log_exact(x, 999))),
+    ("EXP_8", lambda x: to16(exp_exact(x, 8))),
+]
+
+
+def emit_table(name, size, stride, ctype="uint8_t", curves=CURVES):
+    print("const %s %s[NUM_VELOCITY_CURVES][%s] PURE_HOT_DATA = {" % (ctype, name, size))
+    for curveName, f in curves:
+        values = [f(float(min(ix * stride, STOPWATCH_MAX)) / STOPWATCH_MAX)
+                  for ix in range((STOPWATCH_MAX // stride) + 1)]
+        print("\t{ // %s" % curveName)
+        for start in range(0, len(values), VALUES_PER_LINE):
+            print("\t\t" + ", ".join("%d" % v for v in values[start:start + VALUES_PER_LINE]) + ",")
+        print("\t},")
+    print("};")
+
+
+def main():
+    print("// GENERATED FILE - DO NOT EDIT!")
+    print("// Generated by tools/gen_velocity_curves.py. Edit the generator and rerun it instead.")
+    print("")
+    print("#include <pure_ramfunc.h>")
+    print("#include <pure_velocitycurve.h>")
+    print("")
+    print("namespace PurpleReign")
+    print("{")
+    print("")
+    print("#ifdef VELOCITY_CURVE_INTERPOLATE")
+    emit_table("velocityCurveBankCoarse", "sizeVelocityCurveCoarse", 1 << COARSE_SHIFT)
+    print("#else")
+    emit_table("velocityCurveBank", "sizeVelocityStopWatchMaxValue", 1)
+    print("#endif")
+    print("")
+    emit_table("velocityCurveBank16", "sizeVelocityCurveCoarse", 1 << COARSE_SHIFT, "uint16_t", CURVES16)
+    print("")
+    print("}")
+
+
+if __name__ == "__main__":
+    main()
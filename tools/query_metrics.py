@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+#
+# Requests a snapshot of the runtime metrics of PurpleReign::Metrics (see include/pure_metrics.h) and prints it.
+#
+# Over SerialUSB: sends the query byte ('M', or 'R' to also restart the peak metrics) and decodes the binary frame of the reply:
+#   0xA6, payload length, payload, checksum (sum of the payload bytes, modulo 256).
+#   Payload (little endian): time (DWT cycles, 4 bytes), number of metrics, values (4 bytes each).
+# Over USB-MIDI: decodes the SysEx reply to CMD_GET_METRICS (F0 7D 50 0E <data> F7), with each value in five 7-bit groups, MSB first.
+# Send the request (F0 7D 50 0E 00 F7) with any SysEx tool and pass the reply as hex.
+#
+# The metric names are read from include/pure_metricnames.h (one X(ID, KIND, "name") per line, in snapshot order).
+# COUNTER metrics are printed with their rate since the previous snapshot, when --interval is given.
+#
+# Usage: python3 tools/query_metrics.py /dev/ttyACM0 [--reset] [--interval <s>]   (needs pyserial)
+#        python3 tools/query_metrics.py --sysex "F0 7D 50 0E ... F7"
+
+import argparse
+import os
+import re
+import struct
+import sys
+import time
+
+FRAME_START = 0xA6
+QUERY_BYTE = b"M"
+QUERY_RESET_BYTE = b"R"
+SYSEX_HEADER = bytes([0xF0, 0x7D, 0x50, 0x0E])
+MCK = 84000000  # Must match VARIANT_MCK (Timebase cycles per second)
+
+NAMES_FILE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "include", "pure_metricnames.h")
+NAME_RE = re.compile(r'^\s*X\(\s*(\w+)\s*,\s*(\w+)\s*,\s*"([^"]*)"\s*\)', re.MULTILINE)
+
+
+def load_metrics(path=NAMES_FILE):
+    with open(path) as f:
+        text = f.read()
+    return [(match.group(3), match.group(2)) for match in NAME_RE.finditer(text)]
+
+
+def decode_frame_payload(payload):
+    time_cycles, count = struct.unpack_from("<IB", payload)
+    values = struct.unpack_from("<%dI" % count, payload, 5)
+    return time_cycles, list(values)
+
+
+def decode_sysex(message):
+    if message[:4] != SYSEX_HEADER or message[-1] != 0xF7:
+        raise ValueError("not a metrics reply")
+    data = message[4:-1]
+
+    def unpack32(offset):
+        value = 0
+        for byte in data[offset : offset + 5]:
+            value = (value << 7) | byte
+        return value & 0xFFFFFFFF
+
+    count = data[5]
+    return unpack32(0), [unpack32(6 + 5 * ix) for ix in range(count)]
+
+
+def format_snapshot(time_cycles, values, metrics, previous=None):
+    lines = ["[%12.6f] metrics" % (time_cycles / MCK)]
+    elapsed = (time_cycles - previous[0]) % (1 << 32) / MCK if previous else 0
+    for ix, value in enumerate(values):
+        name, kind = metrics[ix] if ix < len(metrics) else ("metric%d" % ix, "COUNTER")
+        line = "  %-32s %10u" % (name, value)
+        if kind == "COUNTER" and elapsed > 0 and ix < len(previous[1]):
+            line += "  %10.1f/s" % (((value - previous[1][ix]) % (1 << 32)) / elapsed)
+        lines.append(line)
+    return "\n".join(lines)
+
+
+def read_frame(port):
+    buffer = bytearray()
+    while True:
+        chunk = port.read(1)
+        if not chunk:
+            raise TimeoutError("no metrics frame received")
+        buffer += chunk
+        start = buffer.find(FRAME_START)
+        if start < 0:
+            buffer.clear()
+            continue
+        del buffer[:start]
+        if len(buffer) < 2 or len(buffer) < buffer[1] + 3:
+            continue
+        length = buffer[1]
+        payload = bytes(buffer[2 : 2 + length])
+        if length >= 5 and sum(payload) & 0xFF == buffer[2 + length] and length == 5 + 4 * payload[4]:
+            return payload
+        del buffer[0]  # Not a frame (e.g. a log frame byte), resync
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Query the runtime metrics of a PurpleReign keyboard")
+    parser.add_argument("port", nargs="?", help="SerialUSB port, e.g. /dev/ttyACM0")
+    parser.add_argument("--reset", action="store_true", help="restart the peak metrics after the snapshot")
+    parser.add_argument("--interval", type=float, help="repeat every INTERVAL seconds, with counter rates")
+    parser.add_argument("--sysex", help="decode a CMD_GET_METRICS SysEx reply, given as hex")
+    args = parser.parse_args()
+    metrics = load_metrics()
+
+    if args.sysex:
+        print(format_snapshot(*decode_sysex(bytes.fromhex(args.sysex)), metrics))
+        return
+    if not args.port:
+        parser.error("a serial port or --sysex is required")
+
+    import serial  # pyserial
+
+    previous = None
+    with serial.Serial(args.port, 115200, timeout=1) as port:
+        while True:
+            port.write(QUERY_RESET_BYTE if args.reset else QUERY_BYTE)
+            snapshot = decode_frame_payload(read_frame(port))
+            print(format_snapshot(*snapshot, metrics, previous=previous))
+            sys.stdout.flush()
+            if args.interval is None:
+                break
+            previous = snapshot
+            time.sleep(args.interval)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,109 @@
+#
+# PlatformIO extra script (post): Reports what landed in SRAM through the .ramfunc.* sections (see include/pure_ramfunc.h).
+#
+# Adds a linker map file to the build and, after linking, lists every .ramfunc.* input section with its SRAM address, size, object file and symbols,
+# followed by the totals for code and data.
+#
+# Then disassembles the code sections and flags every call that leaves SRAM: a branch to a flash address, or to a linker veneer (long branch stub,
+# e.g. "__aeabi_dmul_veneer" for a soft-float helper). Such a call runs from flash, with its wait states, and undoes the point of the placement.
+#
+
+import os
+import re
+import subprocess
+
+Import("env")  # noqa: F821 (provided by PlatformIO/SCons)
+
+MAP_FILE = os.path.join(env.subst("$BUILD_DIR"), "firmware.map")  # noqa: F821
+
+env.Append(LINKFLAGS=["-Wl,-Map," + MAP_FILE])  # noqa: F821
+
+SYMBOL_RE = re.compile(r"^\s+(0x[0-9a-fA-F]+)\s+(\S.*)$")
+BRANCH_RE = re.compile(r"^\s*([0-9a-f]+):\s.*\s(bl|blx|b\.w|b)\s+([0-9a-f]+)\s+<([^>]+)>")
+SRAM_START = 0x20000000
+SRAM_END = 0x20088000  # SRAM0 and SRAM1 of the SAM3X8E, incl. the contiguous mirror
+
+
+def parse_map(text):
+    sections = []
+    lines = text.splitlines()
+    ix = 0
+    while ix < len(lines):
+        line = lines[ix]
+        if line.startswith(" .ramfunc."):
+            fields = line.split()
+            if len(fields) == 1 and ix + 1 < len(lines):  # Long section names wrap onto the next line
+                ix += 1
+                fields += lines[ix].split()
+            if len(fields) >= 4:
+                name, address, size, obj = fields[0], int(fields[1], 16), int(fields[2], 16), fields[3]
+                symbols = []
+                while ix + 1 < len(lines):
+                    match = SYMBOL_RE.match(lines[ix + 1])
+                    if not match or lines[ix + 1].startswith(" ."):
+                        break
+                    symbols.append(match.group(2).strip())
+                    ix += 1
+                if size > 0:
+                    sections.append((name, address, size, os.path.basename(obj), symbols))
+        ix += 1
+    return sections
+
+
+def objdump_command(env):
+    cc = env.subst("$CC")
+    return cc[: -len("gcc")] + "objdump" if cc.endswith("gcc") else "arm-none-eabi-objdump"
+
+
+def calls_to_flash(env, elf, sections):
+    calls = []
+    for name, address, size, obj, symbols in sections:
+        if not name.startswith(".ramfunc.pure_func"):
+            continue
+        try:
+            disassembly = subprocess.run(
+                [objdump_command(env), "-d", "--start-address=0x%x" % address, "--stop-address=0x%x" % (address + size), elf],
+                stdout=subprocess.PIPE,
+                universal_newlines=True,
+                check=True,
+            ).stdout
+        except (OSError, subprocess.CalledProcessError) as error:
+            print("ramfunc_report: can not disassemble %s (%s)" % (elf, error))
+            return calls
+        for line in disassembly.splitlines():
+            match = BRANCH_RE.match(line)
+            if not match:
+                continue
+            source, target, symbol = int(match.group(1), 16), int(match.group(3), 16), match.group(4)
+            if symbol.split("+")[0].endswith("_veneer") or not SRAM_START <= target < SRAM_END:
+                calls.append((source, obj, symbol))
+    return calls
+
+
+def report(source, target, env):
+    if not os.path.isfile(MAP_FILE):
+        print("ramfunc_report: no map file found (%s)" % MAP_FILE)
+        return
+    with open(MAP_FILE) as f:
+        sections = parse_map(f.read())
+
+    print("")
+    print("==== RAM resident hot path (.ramfunc.*) ====")
+    totals = {}
+    for name, address, size, obj, symbols in sections:
+        print("  0x%08x %6d  %-22s %-28s %s" % (address, size, name, obj, ", ".join(symbols)))
+        totals[name] = totals.get(name, 0) + size
+    if not sections:
+        print("  (nothing, is PURE_RAM_HOT_PATH defined?)")
+    for name in sorted(totals):
+        print("  total %-22s %6d bytes" % (name, totals[name]))
+
+    calls = calls_to_flash(env, target[0].get_abspath(), sections)
+    if calls:
+        print("  WARNING: %d call(s) from SRAM into flash:" % len(calls))
+        for address, obj, symbol in calls:
+            print("    0x%08x %-28s -> %s" % (address, obj, symbol))
+    print("")
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", report)  # noqa: F821